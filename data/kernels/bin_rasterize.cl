@@ -6,6 +6,199 @@ typedef struct __attribute__((packed, aligned(16))) {
 	float4 bounds; // (.x = INFINITY if culled)
 } primitive_bounds;
 
+typedef struct __attribute__((packed, aligned(4))) {
+	// VV0: 0 - 2
+	// VV1: 3 - 5
+	// VV2: 6 - 8
+	// depth: 9
+	float data[10];
+} transformed_data;
+
+// exact bin/primitive overlap test (the primitive aabb only gives a conservative estimate):
+// evaluates the edge functions (computed in processing.cl) at the pixel center of the bin that is "most inside"
+// w.r.t. each edge and rejects the bin if this is outside any edge, i.e. no fragment in the bin can pass.
+// edge_sign is -1 for perspective (inside: all edge functions < 0) and +1 for orthographic (inside: all >= 0),
+// or 0 for fixed-point rasterization (data contains the integer edge setup, inside: all >= 0)
+#define EDGE_EPSILON 0.00001f
+
+// computes the (pixel space) edge function i from the fixed-point edge setup (see processing.cl)
+float3 fixed_point_edge(global const float* data, const unsigned int i) {
+	global const int* fixed_data = (global const int*)data;
+	const float a = (i == 0u ? -(convert_float(fixed_data[0]) + convert_float(fixed_data[2])) : convert_float(fixed_data[i * 2u - 2u]));
+	const float b = (i == 0u ? -(convert_float(fixed_data[1]) + convert_float(fixed_data[3])) : convert_float(fixed_data[i * 2u - 1u]));
+	const float c = (i == 0u ? convert_float(((long)fixed_data[7] << 32) | (long)(uint)fixed_data[6]) : 0.0f);
+	return (float3)(a * (float)OCLRASTER_SUBPIXEL_SCALE, b * (float)OCLRASTER_SUBPIXEL_SCALE,
+					c - mad(a, convert_float(fixed_data[4]), b * convert_float(fixed_data[5])));
+}
+// tile_origin is in pixels, tile_size is the width/height of the (square) tile
+bool tile_edge_test(global const float* edges, const float edge_sign, const uint2 tile_origin, const unsigned int tile_size) {
+	const float2 tile_min = convert_float2(tile_origin) + 0.5f;
+	const float2 tile_max = tile_min + convert_float(tile_size - 1u);
+	for(unsigned int i = 0; i < 3; i++) {
+		const float3 edge = (edge_sign != 0.0f ?
+							 (float3)(edges[i * 3], edges[i * 3 + 1], edges[i * 3 + 2]) * edge_sign :
+							 fixed_point_edge(edges, i));
+		const float x = (edge.x >= 0.0f ? tile_max.x : tile_min.x);
+		const float y = (edge.y >= 0.0f ? tile_max.y : tile_min.y);
+		const float value = mad(x, edge.x, mad(y, edge.y, edge.z));
+		// be conservative here, the rasterizer evaluates the edge functions slightly differently (and snaps small values to 0)
+		const float margin = mad(EDGE_EPSILON, fabs(x * edge.x) + fabs(y * edge.y) + fabs(edge.z), EDGE_EPSILON);
+		if(value < -margin) return false;
+	}
+	return true;
+}
+bool bin_edge_test(global const float* edges, const float edge_sign, const uint2 bin_location) {
+	return tile_edge_test(edges, edge_sign, bin_location * BIN_SIZE, BIN_SIZE);
+}
+
+// per-bin depth bounds test (hi-z):
+// depth_bounds contains the min/max depth of all fragments of each bin (updated by the rasterizer, reset on depth clears)
+// -> a bin/primitive pair is rejected if the nearest depth of the primitive inside the bin can't pass the depth test
+// against the bin bounds, i.e. no fragment of the primitive in this bin could ever be visible.
+// depth_bounds_func is one of the DEPTH_BOUNDS_* values below (-> DEPTH_BOUNDS_NONE disables the test)
+#define DEPTH_BOUNDS_NONE 0u
+#define DEPTH_BOUNDS_LESS 1u
+#define DEPTH_BOUNDS_LESS_OR_EQUAL 2u
+#define DEPTH_BOUNDS_GREATER 3u
+#define DEPTH_BOUNDS_GREATER_OR_EQUAL 4u
+#define DEPTH_BOUNDS_EQUAL 5u
+#define DEPTH_BOUNDS_EPSILON 0.0001f
+
+// min/max depth of the primitive plane inside a bin (conservative)
+float2 primitive_bin_depth_range(global const float* data, const float edge_sign, const uint2 bin_location) {
+	// fixed-point data already contains the final (constant) depth
+	if(edge_sign == 0.0f) return (float2)(data[9], data[9]);
+	
+	// fragment depth = data[9] / sum of all edge functions (see the rasterizer),
+	// the sum is linear in x/y -> min/max depth is at the bin corners (if the depth is positive at all corners)
+	const float3 edge_sum = (float3)(data[0] + data[3] + data[6], data[1] + data[4] + data[7], data[2] + data[5] + data[8]);
+	const float2 bin_min = convert_float2(bin_location * BIN_SIZE) + 0.5f;
+	const float2 bin_max = bin_min + convert_float(BIN_SIZE - 1u);
+	const float depth_0 = data[9] / mad(bin_min.x, edge_sum.x, mad(bin_min.y, edge_sum.y, edge_sum.z));
+	const float depth_1 = data[9] / mad(bin_max.x, edge_sum.x, mad(bin_min.y, edge_sum.y, edge_sum.z));
+	const float depth_2 = data[9] / mad(bin_min.x, edge_sum.x, mad(bin_max.y, edge_sum.y, edge_sum.z));
+	const float depth_3 = data[9] / mad(bin_max.x, edge_sum.x, mad(bin_max.y, edge_sum.y, edge_sum.z));
+	const float2 depth_range = (float2)(fmin(fmin(depth_0, depth_1), fmin(depth_2, depth_3)),
+									   fmax(fmax(depth_0, depth_1), fmax(depth_2, depth_3)));
+	// plane passes through the camera plane inside the bin (or degenerate) -> can't say anything
+	if(!(depth_range.x > 0.0f) || !(depth_range.y < INFINITY) ||
+	   isnan(depth_0) || isnan(depth_1) || isnan(depth_2) || isnan(depth_3)) {
+		return (float2)(0.0f, INFINITY);
+	}
+	return depth_range;
+}
+
+bool depth_bounds_test(global const float* data, const float edge_sign, const uint2 bin_location,
+					   const float2 bin_depth, const unsigned int depth_bounds_func) {
+	const float2 depth_range = primitive_bin_depth_range(data, edge_sign, bin_location);
+	// be conservative here as well, the rasterizer computes the depth slightly differently
+	const float2 depth = (float2)(depth_range.x - fabs(depth_range.x) * DEPTH_BOUNDS_EPSILON,
+								  depth_range.y + fabs(depth_range.y) * DEPTH_BOUNDS_EPSILON);
+	switch(depth_bounds_func) {
+		case DEPTH_BOUNDS_LESS: return (depth.x < bin_depth.y);
+		case DEPTH_BOUNDS_LESS_OR_EQUAL: return (depth.x <= bin_depth.y);
+		case DEPTH_BOUNDS_GREATER: return (depth.y > bin_depth.x);
+		case DEPTH_BOUNDS_GREATER_OR_EQUAL: return (depth.y >= bin_depth.x);
+		case DEPTH_BOUNDS_EQUAL: return (depth.x <= bin_depth.y && depth.y >= bin_depth.x);
+		default: break;
+	}
+	return true;
+}
+
+////
+// coarse binning (two-level binning, gather binner only):
+// for large framebuffers, every bin scanning all primitives of all batches gets expensive. to reduce this work,
+// every primitive is first scattered into the coarse tiles (COARSE_BIN_FACTOR x COARSE_BIN_FACTOR bins) it overlaps,
+// via a primitive bitmask per coarse tile and batch (atomic or). the gather binner then only considers the
+// primitives of its coarse tile and skips all primitives before the first and after the last set bit.
+#define COARSE_BIN_FACTOR (4u)
+#define COARSE_BIN_SIZE (BIN_SIZE * COARSE_BIN_FACTOR)
+#define COARSE_MASK_WORDS (BATCH_SIZE / 32u)
+
+kernel void oclraster_bin_coarse(global unsigned int* coarse_masks,
+								 const uint2 coarse_count,
+								 const uint2 coarse_offset,
+								 const unsigned int batch_count,
+								 const unsigned int primitive_count,
+								 
+								 global const primitive_bounds* primitive_bounds_buffer,
+								 global const transformed_data* transformed_buffer,
+								 const float edge_sign,
+								 const uint2 framebuffer_size) {
+	const unsigned int primitive_id = get_global_id(0);
+	if(primitive_id >= primitive_count) return;
+	
+	// cull:
+	const float4 bounds = primitive_bounds_buffer[primitive_id].bounds;
+	if(bounds.x == INFINITY) return;
+	
+	// valid pixel pos: [0, framebuffer_size - 1] (same as the gather binner)
+	const uint2 framebuffer_clamp_size = framebuffer_size - 1u;
+	const uint2 x_bounds_u = (uint2)(clamp(convert_uint(bounds.x), 0u, framebuffer_clamp_size.x),
+									 clamp(convert_uint(bounds.y), 0u, framebuffer_clamp_size.x));
+	const uint2 y_bounds_u = (uint2)(clamp(convert_uint(bounds.z), 0u, framebuffer_clamp_size.y),
+									 clamp(convert_uint(bounds.w), 0u, framebuffer_clamp_size.y));
+	const uint2 x_tiles = x_bounds_u / COARSE_BIN_SIZE;
+	const uint2 y_tiles = y_bounds_u / COARSE_BIN_SIZE;
+	
+	// only consider tiles that contain rasterized bins (-> scissor)
+	const uint2 coarse_end = coarse_offset + coarse_count - 1u;
+	if(x_tiles.y < coarse_offset.x || x_tiles.x > coarse_end.x ||
+	   y_tiles.y < coarse_offset.y || y_tiles.x > coarse_end.y) {
+		return;
+	}
+	const uint2 x_range = (uint2)(max(x_tiles.x, coarse_offset.x), min(x_tiles.y, coarse_end.x)) - coarse_offset.x;
+	const uint2 y_range = (uint2)(max(y_tiles.x, coarse_offset.y), min(y_tiles.y, coarse_end.y)) - coarse_offset.y;
+	
+	const unsigned int batch_idx = primitive_id / BATCH_SIZE;
+	const unsigned int local_idx = primitive_id % BATCH_SIZE;
+	const unsigned int mask_word = local_idx / 32u;
+	const unsigned int mask_bit = 1u << (local_idx % 32u);
+	global const float* edges = transformed_buffer[primitive_id].data;
+	for(unsigned int y = y_range.x; y <= y_range.y; y++) {
+		for(unsigned int x = x_range.x; x <= x_range.y; x++) {
+			const uint2 tile_location = (uint2)(x, y) + coarse_offset;
+			if(!tile_edge_test(edges, edge_sign, tile_location * COARSE_BIN_SIZE, COARSE_BIN_SIZE)) continue;
+			const unsigned int coarse_idx = y * coarse_count.x + x;
+			atomic_or(&coarse_masks[(coarse_idx * batch_count + batch_idx) * COARSE_MASK_WORDS + mask_word], mask_bit);
+		}
+	}
+}
+
+// loads the coarse primitive mask of a bin and batch into coarse_mask (all bits are set if coarse binning is disabled)
+// and returns the [first, last) primitive range (local batch indices) that contains all set bits
+uint2 load_coarse_mask(unsigned int* coarse_mask,
+					   global const unsigned int* coarse_masks,
+					   const uint2 coarse_count,
+					   const uint2 coarse_offset,
+					   const unsigned int coarse_binning,
+					   const uint2 bin_location,
+					   const unsigned int batch_idx,
+					   const unsigned int batch_count) {
+	if(coarse_binning == 0) {
+		for(unsigned int word_idx = 0; word_idx < COARSE_MASK_WORDS; word_idx++) {
+			coarse_mask[word_idx] = 0xFFFFFFFFu;
+		}
+		return (uint2)(0u, BATCH_SIZE);
+	}
+	
+	const uint2 tile_location = bin_location / COARSE_BIN_FACTOR - coarse_offset;
+	const unsigned int coarse_idx = tile_location.y * coarse_count.x + tile_location.x;
+	global const unsigned int* mask_ptr = &coarse_masks[(coarse_idx * batch_count + batch_idx) * COARSE_MASK_WORDS];
+	uint2 range = (uint2)(BATCH_SIZE, 0u);
+	for(unsigned int word_idx = 0; word_idx < COARSE_MASK_WORDS; word_idx++) {
+		const unsigned int word = mask_ptr[word_idx];
+		coarse_mask[word_idx] = word;
+		if(word == 0u) continue;
+		// lowest set bit: 31 - clz(isolated lowest bit), highest set bit: 31 - clz(word)
+		range.x = min(range.x, word_idx * 32u + 31u - clz(word & (~word + 1u)));
+		range.y = word_idx * 32u + 32u - clz(word);
+	}
+	// empty -> empty range
+	if(range.x > range.y) range = (uint2)(0u, 0u);
+	return range;
+}
+
 //
 kernel void oclraster_bin(global unsigned int* bin_distribution_counter,
 						  global ulong* bin_queues,
@@ -16,6 +209,17 @@ kernel void oclraster_bin(global unsigned int* bin_distribution_counter,
 						  const unsigned int primitive_count,
 						  
 						  global const primitive_bounds* primitive_bounds_buffer,
+						  global const transformed_data* transformed_buffer,
+						  const float edge_sign,
+						  global unsigned int* bin_statistics,
+						  const unsigned int collect_statistics,
+						  global const float2* depth_bounds,
+						  const unsigned int depth_bounds_pitch,
+						  const unsigned int depth_bounds_func,
+						  global const unsigned int* coarse_masks,
+						  const uint2 coarse_count,
+						  const uint2 coarse_offset,
+						  const unsigned int coarse_binning,
 						  const uint2 framebuffer_size
 #if !defined(CPU)
 						  , const unsigned int intra_bin_groups
@@ -24,12 +228,14 @@ kernel void oclraster_bin(global unsigned int* bin_distribution_counter,
 	const unsigned int local_id = get_local_id(0);
 	const unsigned int local_size = get_local_size(0);
 	
-	// TODO: already read depth from framebuffer in here -> cull if depth test fails
+	// bin_statistics (if collect_statistics is set): [0] = #bin/primitive pairs passing the aabb test,
+	// [1] = #pairs also passing the edge test, [2] = #pairs thereof rejected by the depth bounds test
+	// (with coarse binning, pairs rejected by the coarse tile edge test are not counted at all)
 	
 	// -> each work-item: 1 bin + private mem queue (gpu version) or 1 batch + private mem queue (cpu version)
-	// -> iterate over 256 primitives (batch size: 256)
+	// -> iterate over BATCH_SIZE primitives (128 or 256)
 	// -> store loop index in priv mem queue (-> only one byte per primitive)
-	// -> 2 vstore16 calls with 2 ulong16s (256 bytes)
+	// -> 1 vstore16 call per 128 queue bytes (the second one is only necessary for > 128 queued primitives)
 	
 #if !defined(CPU)
 	// GPU version
@@ -44,6 +250,7 @@ kernel void oclraster_bin(global unsigned int* bin_distribution_counter,
 	
 	// note: opencl does not require this to be aligned, but certain implementations do
 	uchar primitive_queue[BATCH_SIZE] __attribute__((aligned(8)));
+	unsigned int coarse_mask[COARSE_MASK_WORDS];
 	local float4 primitive_bounds[BATCH_SIZE] __attribute__((aligned(16))); // correctly align, so async copy will work
 	local unsigned int batch_idx;
 	const uint2 framebuffer_clamp_size = framebuffer_size - 1u;
@@ -74,13 +281,17 @@ kernel void oclraster_bin(global unsigned int* bin_distribution_counter,
 			const unsigned int bin_idx = local_id + (bin_idx_offset * local_size);
 			if(bin_idx >= bin_count_lin) break;
 			const uint2 bin_location = (uint2)(bin_idx % bin_count.x, bin_idx / bin_count.x) + bin_offset;
+			const float2 bin_depth = depth_bounds[bin_location.y * depth_bounds_pitch + bin_location.x];
+			const uint2 coarse_range = load_coarse_mask(coarse_mask, coarse_masks, coarse_count, coarse_offset,
+														coarse_binning, bin_location, batch_idx, batch_count);
 			
-			// iterate over all primitives in this batch
-			unsigned int primitives_in_queue = 0;
-			for(unsigned int primitive_id = primitive_id_offset, idx = 0,
-				last_primitive_id = min(primitive_id_offset + BATCH_SIZE, primitive_count);
+			// iterate over all primitives in this batch (-> only those that overlap the coarse tile)
+			unsigned int primitives_in_queue = 0, aabb_pairs = 0, depth_rejected_pairs = 0;
+			for(unsigned int primitive_id = primitive_id_offset + coarse_range.x, idx = coarse_range.x,
+				last_primitive_id = min(primitive_id_offset + coarse_range.y, primitive_count);
 				primitive_id < last_primitive_id; primitive_id++, idx++) {
 				// cull:
+				if((coarse_mask[idx / 32u] & (1u << (idx % 32u))) == 0u) continue;
 				if(primitive_bounds[idx].x == INFINITY) continue;
 				
 				const uint2 x_bounds = (uint2)(convert_uint(primitive_bounds[idx].x),
@@ -92,18 +303,23 @@ kernel void oclraster_bin(global unsigned int* bin_distribution_counter,
 	
 	const unsigned int bin_idx = get_group_id(0);
 	const uint2 bin_location = (uint2)(bin_idx % bin_count.x, bin_idx / bin_count.x) + bin_offset;
+	const float2 bin_depth = depth_bounds[bin_location.y * depth_bounds_pitch + bin_location.x];
 	
 	// note: opencl does not require this to be aligned, but certain implementations do
 	uchar primitive_queue[BATCH_SIZE] __attribute__((aligned(8)));
+	unsigned int coarse_mask[COARSE_MASK_WORDS];
 	const uint2 framebuffer_clamp_size = framebuffer_size - 1u;
 	{
 		for(unsigned int batch_idx = local_id; batch_idx < batch_count; batch_idx += local_size) {
-			unsigned int primitives_in_queue = 0;
+			unsigned int primitives_in_queue = 0, aabb_pairs = 0, depth_rejected_pairs = 0;
 			const unsigned int primitive_id_offset = batch_idx * BATCH_SIZE;
-			for(unsigned int primitive_id = primitive_id_offset, idx = 0,
-				last_primitive_id = min(primitive_id_offset + BATCH_SIZE, primitive_count);
+			const uint2 coarse_range = load_coarse_mask(coarse_mask, coarse_masks, coarse_count, coarse_offset,
+														coarse_binning, bin_location, batch_idx, batch_count);
+			for(unsigned int primitive_id = primitive_id_offset + coarse_range.x, idx = coarse_range.x,
+				last_primitive_id = min(primitive_id_offset + coarse_range.y, primitive_count);
 				primitive_id < last_primitive_id; primitive_id++, idx++) {
 				// cull:
+				if((coarse_mask[idx / 32u] & (1u << (idx % 32u))) == 0u) continue;
 				if(primitive_bounds_buffer[primitive_id].bounds.x == INFINITY) continue;
 				
 				const uint2 x_bounds = (uint2)(convert_uint(primitive_bounds_buffer[primitive_id].bounds.x),
@@ -124,18 +340,32 @@ kernel void oclraster_bin(global unsigned int* bin_distribution_counter,
 				
 				if(bin_location.y >= y_bins.x && bin_location.y <= y_bins.y &&
 				   bin_location.x >= x_bins.x && bin_location.x <= x_bins.y) {
+					aabb_pairs++;
+					if(!bin_edge_test(transformed_buffer[primitive_id].data, edge_sign, bin_location)) continue;
+					if(depth_bounds_func != DEPTH_BOUNDS_NONE &&
+					   !depth_bounds_test(transformed_buffer[primitive_id].data, edge_sign, bin_location,
+										  bin_depth, depth_bounds_func)) {
+						depth_rejected_pairs++;
+						continue;
+					}
 					primitive_queue[primitives_in_queue] = idx;
 					primitives_in_queue++;
 				}
 			}
 			
+			if(collect_statistics != 0 && aabb_pairs != 0) {
+				atomic_add(&bin_statistics[0], aabb_pairs);
+				atomic_add(&bin_statistics[1], primitives_in_queue + depth_rejected_pairs);
+				atomic_add(&bin_statistics[2], depth_rejected_pairs);
+			}
+			
 			if(primitives_in_queue == 0) {
 				// flag empty queue with 0xFFFF
 				primitive_queue[0] = 0xFF;
 				primitive_queue[1] = 0xFF;
 				//primitives_in_queue = 2;
 			}
-			else if(primitives_in_queue != 256) {
+			else if(primitives_in_queue != BATCH_SIZE) {
 				// set end of queue byte (0x00)
 				primitive_queue[primitives_in_queue] = 0x00;
 				primitives_in_queue++;
@@ -158,3 +388,193 @@ kernel void oclraster_bin(global unsigned int* bin_distribution_counter,
 		}
 	}
 }
+
+// resets the depth bounds of all bins (merge: union with the current bounds, used for partial clears)
+kernel void oclraster_bin_depth_bounds_clear(global float2* depth_bounds,
+											 const unsigned int bin_count_lin,
+											 const float2 bounds,
+											 const unsigned int merge) {
+	const unsigned int idx = get_global_id(0);
+	if(idx >= bin_count_lin) return;
+	if(merge != 0) {
+		const float2 prev_bounds = depth_bounds[idx];
+		depth_bounds[idx] = (float2)(fmin(prev_bounds.x, bounds.x), fmax(prev_bounds.y, bounds.y));
+	}
+	else depth_bounds[idx] = bounds;
+}
+
+////
+// scatter binner:
+// instead of every bin scanning all primitives (see above), every primitive is scattered into the bins it overlaps.
+// this is done via a primitive bitmask per bin and batch (atomic or), which is then compacted into per-bin lists
+// of non-empty batches. the rasterizer only iterates over these lists and skips empty bins entirely.
+// primitive order inside each bin is preserved, since batches and mask bits are processed in ascending order.
+//
+// bin list layout (uints):
+// [0, bin_count_lin]: exclusive prefix sum of the #entries per bin (the last element contains the total #entries)
+// [bin_count_lin + 1, ...]: entries (SCATTER_ENTRY_SIZE uints each): batch index + primitive mask
+#define SCATTER_MASK_WORDS (BATCH_SIZE / 32u)
+#define SCATTER_ENTRY_SIZE (SCATTER_MASK_WORDS + 1u)
+#define SCATTER_SCAN_SIZE (256u)
+
+kernel void oclraster_bin_scatter_clear(global unsigned int* bin_masks,
+										const unsigned int mask_word_count) {
+	const unsigned int idx = get_global_id(0);
+	if(idx >= mask_word_count) return;
+	bin_masks[idx] = 0u;
+}
+
+//
+kernel void oclraster_bin_scatter(global unsigned int* bin_masks,
+								  const uint2 bin_count,
+								  const uint2 bin_offset,
+								  const unsigned int batch_count,
+								  const unsigned int primitive_count,
+								  
+								  global const primitive_bounds* primitive_bounds_buffer,
+								  global const transformed_data* transformed_buffer,
+								  const float edge_sign,
+								  global unsigned int* bin_statistics,
+								  const unsigned int collect_statistics,
+								  global const float2* depth_bounds,
+								  const unsigned int depth_bounds_pitch,
+								  const unsigned int depth_bounds_func,
+								  const uint2 framebuffer_size) {
+	const unsigned int primitive_id = get_global_id(0);
+	if(primitive_id >= primitive_count) return;
+	
+	// cull:
+	const float4 bounds = primitive_bounds_buffer[primitive_id].bounds;
+	if(bounds.x == INFINITY) return;
+	
+	// valid pixel pos: [0, framebuffer_size - 1] (same as the gather binner)
+	const uint2 framebuffer_clamp_size = framebuffer_size - 1u;
+	const uint2 x_bounds_u = (uint2)(clamp(convert_uint(bounds.x), 0u, framebuffer_clamp_size.x),
+									 clamp(convert_uint(bounds.y), 0u, framebuffer_clamp_size.x));
+	const uint2 y_bounds_u = (uint2)(clamp(convert_uint(bounds.z), 0u, framebuffer_clamp_size.y),
+									 clamp(convert_uint(bounds.w), 0u, framebuffer_clamp_size.y));
+	const uint2 x_bins = x_bounds_u / BIN_SIZE;
+	const uint2 y_bins = y_bounds_u / BIN_SIZE;
+	
+	// only consider bins that are actually rasterized (-> scissor)
+	const uint2 bin_end = bin_offset + bin_count - 1u;
+	if(x_bins.y < bin_offset.x || x_bins.x > bin_end.x ||
+	   y_bins.y < bin_offset.y || y_bins.x > bin_end.y) {
+		return;
+	}
+	const uint2 x_range = (uint2)(max(x_bins.x, bin_offset.x), min(x_bins.y, bin_end.x)) - bin_offset.x;
+	const uint2 y_range = (uint2)(max(y_bins.x, bin_offset.y), min(y_bins.y, bin_end.y)) - bin_offset.y;
+	
+	const unsigned int batch_idx = primitive_id / BATCH_SIZE;
+	const unsigned int local_idx = primitive_id % BATCH_SIZE;
+	const unsigned int mask_word = local_idx / 32u;
+	const unsigned int mask_bit = 1u << (local_idx % 32u);
+	global const float* edges = transformed_buffer[primitive_id].data;
+	unsigned int edge_pairs = 0, depth_rejected_pairs = 0;
+	for(unsigned int y = y_range.x; y <= y_range.y; y++) {
+		for(unsigned int x = x_range.x; x <= x_range.y; x++) {
+			const uint2 bin_location = (uint2)(x, y) + bin_offset;
+			if(!bin_edge_test(edges, edge_sign, bin_location)) continue;
+			edge_pairs++;
+			if(depth_bounds_func != DEPTH_BOUNDS_NONE &&
+			   !depth_bounds_test(edges, edge_sign, bin_location,
+								  depth_bounds[bin_location.y * depth_bounds_pitch + bin_location.x], depth_bounds_func)) {
+				depth_rejected_pairs++;
+				continue;
+			}
+			const unsigned int bin_idx = y * bin_count.x + x;
+			atomic_or(&bin_masks[(bin_idx * batch_count + batch_idx) * SCATTER_MASK_WORDS + mask_word], mask_bit);
+		}
+	}
+	
+	// see oclraster_bin
+	if(collect_statistics != 0) {
+		atomic_add(&bin_statistics[0], (x_range.y - x_range.x + 1u) * (y_range.y - y_range.x + 1u));
+		atomic_add(&bin_statistics[1], edge_pairs);
+		atomic_add(&bin_statistics[2], depth_rejected_pairs);
+	}
+}
+
+// counts the non-empty batches of each bin
+kernel void oclraster_bin_scatter_count(global const unsigned int* bin_masks,
+										global unsigned int* bin_lists,
+										const unsigned int bin_count_lin,
+										const unsigned int batch_count) {
+	const unsigned int bin_idx = get_global_id(0);
+	if(bin_idx >= bin_count_lin) return;
+	
+	global const unsigned int* mask_ptr = &bin_masks[bin_idx * batch_count * SCATTER_MASK_WORDS];
+	unsigned int entry_count = 0;
+	for(unsigned int batch_idx = 0; batch_idx < batch_count; batch_idx++, mask_ptr += SCATTER_MASK_WORDS) {
+		unsigned int any_bit = 0u;
+		for(unsigned int word_idx = 0; word_idx < SCATTER_MASK_WORDS; word_idx++) {
+			any_bit |= mask_ptr[word_idx];
+		}
+		if(any_bit != 0u) entry_count++;
+	}
+	bin_lists[bin_idx] = entry_count;
+}
+
+// in-place exclusive prefix sum over all bin entry counts (must be run as a single work-group)
+kernel void oclraster_bin_scatter_prefix_sum(global unsigned int* bin_lists,
+											 const unsigned int bin_count_lin) {
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int local_size = get_local_size(0);
+	local unsigned int partial_sums[SCATTER_SCAN_SIZE];
+	
+	// each work-item sums up a contiguous range of bins
+	const unsigned int bins_per_item = (bin_count_lin + local_size - 1u) / local_size;
+	const unsigned int first_bin = min(local_id * bins_per_item, bin_count_lin);
+	const unsigned int last_bin = min(first_bin + bins_per_item, bin_count_lin);
+	unsigned int sum = 0;
+	for(unsigned int bin_idx = first_bin; bin_idx < last_bin; bin_idx++) {
+		sum += bin_lists[bin_idx];
+	}
+	partial_sums[local_id] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	
+	// scan the partial sums (at most SCATTER_SCAN_SIZE values, so this is cheap enough to do serially)
+	if(local_id == 0) {
+		unsigned int offset = 0;
+		for(unsigned int i = 0; i < local_size; i++) {
+			const unsigned int count = partial_sums[i];
+			partial_sums[i] = offset;
+			offset += count;
+		}
+		bin_lists[bin_count_lin] = offset; // total #entries
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+	
+	// write the final offsets
+	unsigned int offset = partial_sums[local_id];
+	for(unsigned int bin_idx = first_bin; bin_idx < last_bin; bin_idx++) {
+		const unsigned int count = bin_lists[bin_idx];
+		bin_lists[bin_idx] = offset;
+		offset += count;
+	}
+}
+
+// writes the non-empty batches of each bin to its list
+kernel void oclraster_bin_scatter_write(global const unsigned int* bin_masks,
+										global unsigned int* bin_lists,
+										const unsigned int bin_count_lin,
+										const unsigned int batch_count) {
+	const unsigned int bin_idx = get_global_id(0);
+	if(bin_idx >= bin_count_lin) return;
+	
+	global const unsigned int* mask_ptr = &bin_masks[bin_idx * batch_count * SCATTER_MASK_WORDS];
+	global unsigned int* entry_ptr = &bin_lists[bin_count_lin + 1u + bin_lists[bin_idx] * SCATTER_ENTRY_SIZE];
+	for(unsigned int batch_idx = 0; batch_idx < batch_count; batch_idx++, mask_ptr += SCATTER_MASK_WORDS) {
+		unsigned int any_bit = 0u;
+		for(unsigned int word_idx = 0; word_idx < SCATTER_MASK_WORDS; word_idx++) {
+			any_bit |= mask_ptr[word_idx];
+		}
+		if(any_bit == 0u) continue;
+		
+		entry_ptr[0] = batch_idx;
+		for(unsigned int word_idx = 0; word_idx < SCATTER_MASK_WORDS; word_idx++) {
+			entry_ptr[1u + word_idx] = mask_ptr[word_idx];
+		}
+		entry_ptr += SCATTER_ENTRY_SIZE;
+	}
+}
@@ -243,6 +243,9 @@ OCLRASTER_FUNC float4 fma(const float4 a, const float4 b, const float4 c) {
 #define atomic_or(a, v) atomicOr(a, v)
 #define atomic_xor(a, v) atomicXor(a, v)
 
+// integer functions
+#define clz(x) __clz(x)
+
 // async function emulation
 typedef int event_t;
 
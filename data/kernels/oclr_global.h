@@ -108,6 +108,10 @@ typedef half4 oclr_half4;
 #define oclraster_out typedef struct __attribute__((packed, aligned(OCLRASTER_STRUCT_ALIGNMENT)))
 #define oclraster_uniforms typedef struct __attribute__((packed, aligned(OCLRASTER_STRUCT_ALIGNMENT)))
 
+// fixed-point rasterization: sub-pixel precision of the snapped vertex positions
+#define OCLRASTER_SUBPIXEL_BITS 8
+#define OCLRASTER_SUBPIXEL_SCALE (1 << OCLRASTER_SUBPIXEL_BITS)
+
 // unsigned int on host side
 enum PRIMITIVE_TYPE {
 	PT_TRIANGLE,
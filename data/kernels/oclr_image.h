@@ -74,7 +74,10 @@ INT_TEXEL_MIX(long, long4, double, 1.0)
 #endif
 
 // image_read* and image_write* functions for buffer-based images
+// note: user programs directly contain the functions of the image types they use (-> not included)
+#if !defined(OCLRASTER_TRIMMED_IMAGE_SUPPORT)
 #include "oclr_image_support.h"
+#endif
 
 // image read functions for native images
 OCLRASTER_FUNC float4 FUNC_OVERLOAD image_read(read_only image2d_t img, const sampler_t sampler, const float2 coord) {
@@ -2,9 +2,10 @@
 #ifndef __OCLRASTER_PRIMITIVE_ASSEMBLY_H__
 #define __OCLRASTER_PRIMITIVE_ASSEMBLY_H__
 
-#define MAKE_PRIMITIVE_INDICES(indices_var_name)									\
+// note: draw_primitive_id is the primitive id relative to the start of the draw call (not the chunk)
+#define MAKE_PRIMITIVE_INDICES(indices_var_name, draw_primitive_id)						\
 unsigned int index_ids[3];															\
-const unsigned int instance_primitive_id = primitive_id % instance_primitive_count;	\
+const unsigned int instance_primitive_id = (draw_primitive_id) % instance_primitive_count;	\
 switch(primitive_type) {															\
 	case PT_TRIANGLE:																\
 		index_ids[0] = instance_primitive_id * 3;									\
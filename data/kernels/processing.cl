@@ -27,6 +27,15 @@ typedef struct __attribute__((packed, aligned(16))) {
 //
 #define MIN_FRAGMENT_SIZE (1.0f / 256.0f)
 #define discard() { tb_ptr->bounds.x = INFINITY; return; }
+// pipeline statistics: culled primitive counters (see pipeline::draw_statistics, bit 0 of collect_statistics)
+#define STATISTICS_CULLED_DISCARD 0
+#define STATISTICS_CULLED_NEAR_PLANE 1
+#define STATISTICS_CULLED_FRUSTUM 2
+#define STATISTICS_CULLED_AREA 3
+#define cull(counter) { \
+	if((collect_statistics & 1u) != 0u) atomic_inc(&pipeline_statistics[counter]); \
+	discard(); \
+}
 kernel void oclraster_processing(global const unsigned int* index_buffer,
 								 global const float4* transformed_vertex_buffer,
 								 global transformed_data* transformed_buffer,
@@ -36,20 +45,32 @@ kernel void oclraster_processing(global const unsigned int* index_buffer,
 								 const unsigned int primitive_count,
 								 const unsigned int instance_primitive_count,
 								 const unsigned int instance_index_count,
-								 const uint4 scissor_rectangle) {
+								 const unsigned int draw_primitive_offset,
+								 const uint4 scissor_rectangle,
+								 global unsigned int* pipeline_statistics,
+								 const unsigned int collect_statistics) {
 	const unsigned int primitive_id = get_global_id(0);
 	// global work size is greater than the actual primitive count
 	// -> check for primitive_count instead of get_global_size(0)
-	if(primitive_id >= primitive_count) return;
+	if(primitive_id >= primitive_count) {
+		// mark padding primitives (up to the next batch boundary) as culled,
+		// so that consecutive primitive ranges can be binned together
+		if(primitive_id < ((primitive_count + BATCH_SIZE - 1) / BATCH_SIZE) * BATCH_SIZE) {
+			primitive_bounds_buffer[primitive_id].bounds.x = INFINITY;
+		}
+		return;
+	}
 	
 	global transformed_data* tf_ptr = &transformed_buffer[primitive_id];
 	global primitive_bounds* tb_ptr = &primitive_bounds_buffer[primitive_id];
 	global float* tf_data_ptr = tf_ptr->data;
-	const unsigned int instance_id = primitive_id / instance_primitive_count;
+	// chunked draws: primitive_id is relative to the chunk, index and instance lookups need the draw-relative id
+	const unsigned int draw_primitive_id = draw_primitive_offset + primitive_id;
+	const unsigned int instance_id = draw_primitive_id / instance_primitive_count;
 	const unsigned int instance_index_offset = instance_id * instance_index_count;
 	
 	//
-	MAKE_PRIMITIVE_INDICES(indices);
+	MAKE_PRIMITIVE_INDICES(indices, draw_primitive_id);
 	
 	// read user transformed vertices
 	const float3 vertices[3] = {
@@ -60,7 +81,7 @@ kernel void oclraster_processing(global const unsigned int* index_buffer,
 	
 	// check if any vertex has been discarded (-> discard the primitive)
 	for(unsigned int i = 0; i < 3; i++) {
-		if(vertices[i].x == INFINITY) discard();
+		if(vertices[i].x == INFINITY) cull(STATISTICS_CULLED_DISCARD);
 	}
 	
 	//
@@ -87,7 +108,7 @@ kernel void oclraster_processing(global const unsigned int* index_buffer,
 	   primitive_near_clipping[1] < 0.0f &&
 	   primitive_near_clipping[2] < 0.0f) {
 		// all vertices are behind the camera
-		discard();
+		cull(STATISTICS_CULLED_NEAR_PLANE);
 	}
 	
 	// frustum culling using the "p/n-test"
@@ -107,7 +128,7 @@ kernel void oclraster_processing(global const unsigned int* index_buffer,
 	}
 	// if any dot product is less than 0 (aabb is completely outside any plane) -> cull
 	if(any(signbit(fc_dot))) {
-		discard();
+		cull(STATISTICS_CULLED_FRUSTUM);
 	}
 #endif
 	
@@ -245,7 +266,7 @@ kernel void oclraster_processing(global const unsigned int* index_buffer,
 			// half sample size (TODO: -> check if between sample points; <=1/2^8 sample size seems to be a good threshold?)
 			if(area < MIN_FRAGMENT_SIZE) {
 				//printf("primitive area culled: %d (%f)\n", primitive_id, area);
-				discard(); // cull
+				cull(STATISTICS_CULLED_AREA); // cull
 			}
 		}
 		
@@ -258,7 +279,7 @@ kernel void oclraster_processing(global const unsigned int* index_buffer,
 		   (coord_ys[1] == 0.0f || coord_ys[1] == -1.0f) &&
 		   (coord_ys[2] == 0.0f || coord_ys[2] == -1.0f)) {
 			//printf("imprecision culled (tp2): %d\n", primitive_id);
-			discard();
+			cull(STATISTICS_CULLED_AREA);
 		}
 		
 		// ---bin---
@@ -329,7 +350,7 @@ kernel void oclraster_processing(global const unsigned int* index_buffer,
 	float2 y_bounds = (float2)(aabb_min.y, aabb_max.y);
 	if(fabs(aabb_min.x - aabb_max.x) < MIN_FRAGMENT_SIZE ||
 	   fabs(aabb_min.y - aabb_max.y) < MIN_FRAGMENT_SIZE) {
-		discard();
+		cull(STATISTICS_CULLED_AREA);
 	}
 #endif
 	const float4 bounds = (float4)(floor(x_bounds.x), ceil(x_bounds.y),
@@ -340,11 +361,50 @@ kernel void oclraster_processing(global const unsigned int* index_buffer,
 	const uint4 ubounds = convert_uint4(bounds);
 	if(scissor_rectangle.x > ubounds.y || ubounds.x > scissor_rectangle.z ||
 	   scissor_rectangle.y > ubounds.w || ubounds.z > scissor_rectangle.w) {
-		discard();
+		cull(STATISTICS_CULLED_FRUSTUM);
 	}
 #endif
 	
 	// output:
+#if defined(OCLRASTER_PROJECTION_ORTHOGRAPHIC) && defined(OCLRASTER_FIXED_POINT_RASTERIZATION)
+	// fixed-point rasterization: the rasterizer evaluates exact integer edge functions (sub-pixel space, edge sign applied)
+	// -> [0 - 1]: a/b of edge function 1, [2 - 3]: a/b of edge function 2, [4 - 5]: snapped vertex 0 (as int),
+	//    [6 - 7]: edge sum (as long, low/high word), [8]: 1 / edge sum, [9]: final depth
+	// edge functions 1 and 2 go through vertex 0: e_i(p) = a_i * (p.x - v0.x) + b_i * (p.y - v0.y),
+	// edge function 0 follows from the sum of all edge functions, which is constant: e_0(p) = edge sum - e_1(p) - e_2(p)
+	// note: vertices are clamped to a guard band, so that the edge functions can't overflow (64-bit)
+#define FIXED_POINT_GUARD_BAND 1048576.0f
+	int2 fixed_vertices[3];
+	for(unsigned int i = 0u; i < 3u; i++) {
+		const float2 snapped = clamp(vertices[i].xy, -FIXED_POINT_GUARD_BAND, FIXED_POINT_GUARD_BAND) * (float)OCLRASTER_SUBPIXEL_SCALE;
+		fixed_vertices[i] = (int2)(convert_int(rint(snapped.x)), convert_int(rint(snapped.y)));
+	}
+	
+	// cull primitives that are degenerate after snapping
+	const long fixed_area = (((long)(fixed_vertices[1].x - fixed_vertices[0].x) * (long)(fixed_vertices[2].y - fixed_vertices[0].y)) -
+							 ((long)(fixed_vertices[2].x - fixed_vertices[0].x) * (long)(fixed_vertices[1].y - fixed_vertices[0].y)));
+	if(fixed_area == 0) {
+		cull(STATISTICS_CULLED_AREA);
+	}
+	
+	const int edge_sign = (DX < 0.0f ? -1 : 1);
+	const int2 edge_1 = (int2)(fixed_vertices[0].y - fixed_vertices[2].y, fixed_vertices[2].x - fixed_vertices[0].x) * edge_sign;
+	const int2 edge_2 = (int2)(fixed_vertices[1].y - fixed_vertices[0].y, fixed_vertices[0].x - fixed_vertices[1].x) * edge_sign;
+	// = e_0(v0) (vertex 0 is on edges 1 and 2)
+	const long edge_sum = (-((long)edge_1.x + (long)edge_2.x) * (long)(fixed_vertices[0].x - fixed_vertices[2].x) -
+						   ((long)edge_1.y + (long)edge_2.y) * (long)(fixed_vertices[0].y - fixed_vertices[2].y));
+	*tf_data_ptr++ = as_float(edge_1.x);
+	*tf_data_ptr++ = as_float(edge_1.y);
+	*tf_data_ptr++ = as_float(edge_2.x);
+	*tf_data_ptr++ = as_float(edge_2.y);
+	*tf_data_ptr++ = as_float(fixed_vertices[0].x);
+	*tf_data_ptr++ = as_float(fixed_vertices[0].y);
+	*tf_data_ptr++ = as_float((uint)edge_sum);
+	*tf_data_ptr++ = as_float((int)(edge_sum >> 32));
+	*tf_data_ptr++ = 1.0f / convert_float(edge_sum);
+	// the sum of all edge functions is constant across the primitive (-> so is the depth)
+	*tf_data_ptr++ = VV_depth / (VV[0][2] + VV[1][2] + VV[2][2]);
+#else
 	for(unsigned int i = 0u; i < 3u; i++) {
 		*tf_data_ptr++ = VV[i][0];
 		*tf_data_ptr++ = VV[i][1];
@@ -352,7 +412,18 @@ kernel void oclraster_processing(global const unsigned int* index_buffer,
 	}
 	//printf("[%d] bounds: %f %f -> %f %f\n", primitive_id, x_bounds.x, y_bounds.x, x_bounds.y, y_bounds.y);
 	*tf_data_ptr++ = VV_depth;
+#endif
 	
 	// TODO: rounding should depend on sampling mode
 	tb_ptr->bounds = bounds;
 }
+
+// used to merge the index buffers of multiple draw calls into one index buffer
+kernel void oclraster_rebase_indices(global const unsigned int* index_buffer,
+									 global unsigned int* rebased_index_buffer,
+									 const unsigned int index_count,
+									 const unsigned int vertex_offset) {
+	const unsigned int index_id = get_global_id(0);
+	if(index_id >= index_count) return;
+	rebased_index_buffer[index_id] = index_buffer[index_id] + vertex_offset;
+}
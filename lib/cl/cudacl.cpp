@@ -186,6 +186,9 @@ opencl_base(), cc_target(CU_TARGET_COMPUTE_10) {
 	fastest_cpu = nullptr;
 	fastest_gpu = nullptr;
 	
+	// the cuda context is bound to the calling thread and the cache isn't thread-safe -> compile serially
+	parallel_kernel_compilation = false;
+	
 	build_options = "-I" + kernel_path_str;
 	build_options += " -I" + kernel_path_str + "cuda";
 	build_options += " -DOCLRASTER_CUDA_CL";
@@ -468,6 +471,7 @@ void cudacl::init(bool use_platform_devices oclr_unused, const size_t platform_i
 			device->vendor_type = VENDOR::NVIDIA;
 			device->type = (opencl_base::DEVICE_TYPE)cur_device;
 			device->max_alloc = global_mem;
+			device->base_addr_align = 256; // cuMemAlloc alignment
 			device->max_wi_sizes.set(get<0>(max_work_item_size), get<1>(max_work_item_size), get<2>(max_work_item_size));
 			device->max_wg_size = max_work_group_size;
 			device->img_support = true;
@@ -536,25 +540,42 @@ void cudacl::init(bool use_platform_devices oclr_unused, const size_t platform_i
 		
 		if(fastest_gpu != nullptr) oclr_debug("fastest GPU device: %s %s (score: %u)", fastest_gpu->vendor.c_str(), fastest_gpu->name.c_str(), fastest_gpu_score);
 		
+		// load the pipeline tuning parameters of the primary device (these are compiled into all kernels)
+		load_tuning();
+		
 		// compile internal kernels
 		//size_t local_size_limit = std::max((size_t)512, devices[0]->max_wg_size); // default to 512
 		//const string lsl_str = " -DLOCAL_SIZE_LIMIT="+size_t2string(local_size_limit);
 		
 		internal_kernels = { // first time init:
-			make_tuple("BIN_RASTERIZE", "bin_rasterize.cl", "oclraster_bin",
-					   " -DBIN_SIZE="+uint2string(OCLRASTER_BIN_SIZE)+
-					   " -DBATCH_SIZE="+uint2string(OCLRASTER_BATCH_SIZE)),
+			make_tuple("BIN_RASTERIZE", "bin_rasterize.cl", "oclraster_bin", ""),
+			
+			make_tuple("BIN_DEPTH_BOUNDS.CLEAR", "bin_rasterize.cl", "oclraster_bin_depth_bounds_clear", ""),
+			
+			make_tuple("BIN_COARSE", "bin_rasterize.cl", "oclraster_bin_coarse", ""),
+			
+			make_tuple("BIN_SCATTER.CLEAR", "bin_rasterize.cl", "oclraster_bin_scatter_clear", ""),
+			
+			make_tuple("BIN_SCATTER", "bin_rasterize.cl", "oclraster_bin_scatter", ""),
+			
+			make_tuple("BIN_SCATTER.COUNT", "bin_rasterize.cl", "oclraster_bin_scatter_count", ""),
+			
+			make_tuple("BIN_SCATTER.PREFIX_SUM", "bin_rasterize.cl", "oclraster_bin_scatter_prefix_sum", ""),
+			
+			make_tuple("BIN_SCATTER.WRITE", "bin_rasterize.cl", "oclraster_bin_scatter_write", ""),
 			
 			make_tuple("PROCESSING.PERSPECTIVE", "processing.cl", "oclraster_processing",
-					   " -DBIN_SIZE="+uint2string(OCLRASTER_BIN_SIZE)+
-					   " -DBATCH_SIZE="+uint2string(OCLRASTER_BATCH_SIZE)+
 					   " -DOCLRASTER_PROJECTION_PERSPECTIVE"),
 			
 			make_tuple("PROCESSING.ORTHOGRAPHIC", "processing.cl", "oclraster_processing",
-					   " -DBIN_SIZE="+uint2string(OCLRASTER_BIN_SIZE)+
-					   " -DBATCH_SIZE="+uint2string(OCLRASTER_BATCH_SIZE)+
 					   " -DOCLRASTER_PROJECTION_ORTHOGRAPHIC"),
 			
+			make_tuple("PROCESSING.ORTHOGRAPHIC.FIXED_POINT", "processing.cl", "oclraster_processing",
+					   " -DOCLRASTER_PROJECTION_ORTHOGRAPHIC -DOCLRASTER_FIXED_POINT_RASTERIZATION"),
+			
+			make_tuple("PROCESSING.REBASE_INDICES", "processing.cl", "oclraster_rebase_indices",
+					   " -DOCLRASTER_PROJECTION_PERSPECTIVE"),
+			
 #if defined(OCLRASTER_FXAA)
 			make_tuple("FXAA.LUMA", "luma_pass.cl", "framebuffer_luma", ""),
 			make_tuple("FXAA", "fxaa_pass.cl", "framebuffer_fxaa", ""),
@@ -598,6 +619,7 @@ weak_ptr<opencl_base::kernel_object> cudacl::add_kernel_src(const string& identi
 		kernels[identifier] = kernel;
 		kernel->name = identifier;
 		kernel->kernel = nullptr;
+		track_kernel_dependencies(identifier, src);
 		const cudacl_kernel_info* kernel_info = nullptr;
 		vector<cudacl_kernel_info> kernels_info;
 		
@@ -789,6 +811,7 @@ void cudacl::delete_kernel(weak_ptr<opencl::kernel_object> kernel_obj) {
 	for(const auto& kernel : kernels) {
 		if(kernel.second == kernel_ptr) {
 			kernel_object::unassociate_buffers(kernel_ptr);
+			untrack_kernel_dependencies(kernel.first);
 			kernels.erase(kernel.first);
 			if(kernel_ptr.use_count() > 1) {
 				oclr_error("kernel object (%X) use count > 1 (%u) - kernel object is still used somewhere!",
@@ -805,6 +828,29 @@ void cudacl::log_program_binary(const shared_ptr<opencl::kernel_object> kernel)
 	if(kernel == nullptr) return;
 }
 
+bool cudacl::load_kernel_bundle(const string& filename oclr_unused) {
+	oclr_error("kernel bundles are not supported with cuda!");
+	return false;
+}
+
+void cudacl::record_kernel_bundle() {
+	oclr_error("kernel bundles are not supported with cuda!");
+}
+
+bool cudacl::write_kernel_bundle(const string& filename oclr_unused, const device_object* device oclr_unused) {
+	oclr_error("kernel bundles are not supported with cuda!");
+	return false;
+}
+
+void cudacl::record_struct_layout(const device_object* device oclr_unused, const string& layout oclr_unused) {
+	// nop (kernel bundles are not supported with cuda)
+}
+
+const vector<string>& cudacl::get_bundle_struct_layouts() const {
+	static const vector<string> no_layouts;
+	return no_layouts;
+}
+
 opencl_base::buffer_object* cudacl::create_buffer_object(const opencl_base::BUFFER_FLAG type, const void* data) {
 	try {
 		opencl_base::buffer_object* buffer = new opencl_base::buffer_object();
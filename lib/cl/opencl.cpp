@@ -42,6 +42,7 @@ opencl_base::opencl_base() {
 }
 
 opencl_base::~opencl_base() {
+	finish_internal_kernel_prefetch();
 }
 
 vector<pair<opencl_base::PLATFORM_VENDOR, string>> opencl_base::get_platforms() {
@@ -100,6 +101,7 @@ opencl_base::CL_VERSION opencl_base::get_platform_cl_version() const {
 }
 
 void opencl_base::destroy_kernels() {
+	finish_internal_kernel_prefetch();
 	cur_kernel = nullptr;
 	kernels_lock.lock();
 	for(auto& k : kernels) {
@@ -112,6 +114,10 @@ void opencl_base::destroy_kernels() {
 	}
 	kernels.clear();
 	kernels_lock.unlock();
+	
+	lock_guard<mutex> lock(dependency_lock);
+	kernel_dependencies.clear();
+	kernel_file_hashes.clear();
 }
 
 bool opencl_base::is_cpu_support() const {
@@ -146,7 +152,80 @@ weak_ptr<opencl_base::kernel_object> opencl_base::add_kernel_file(const string&
 		kernel_data.insert(0, "#define __" + core::str_to_upper(func_name) +  "_BUILD_TIME__ " + uint2string((unsigned int)time(nullptr)) + "\n");
 	}
 	
-	return add_kernel_src(identifier, kernel_data, func_name, additional_options);
+	auto kernel = add_kernel_src(identifier, kernel_data, func_name, additional_options);
+	if(kernel.use_count() > 0 && file_name.compare(0, kernel_path_str.size(), kernel_path_str) == 0) {
+		track_kernel_dependencies(identifier, "", file_name.substr(kernel_path_str.size()));
+	}
+	return kernel;
+}
+
+void opencl_base::collect_kernel_includes(const string& src, set<string>& includes) const {
+	// only "..." includes are resolved (relative to the kernel path, the only include path)
+	static const string include_directive { "#include" };
+	for(size_t pos = src.find(include_directive); pos != string::npos; pos = src.find(include_directive, pos + 1)) {
+		const size_t name_start = src.find_first_not_of(" \t", pos + include_directive.size());
+		if(name_start == string::npos || src[name_start] != '\"') continue;
+		const size_t name_end = src.find('\"', name_start + 1);
+		if(name_end == string::npos) continue;
+		
+		const string include_name = src.substr(name_start + 1, name_end - name_start - 1);
+		if(!includes.insert(include_name).second) continue;
+		
+		string include_src;
+		if(file_io::file_to_string(make_kernel_path(include_name), include_src)) {
+			collect_kernel_includes(include_src, includes);
+		}
+	}
+}
+
+static uint64 kernel_file_hash(const string& filename) {
+	string file_data;
+	if(!file_io::file_to_string(filename, file_data)) return 0;
+	return CityHash64(file_data.c_str(), file_data.size());
+}
+
+void opencl_base::track_kernel_dependencies(const string& identifier, const string& src, const string& file_name) {
+	set<string> files;
+	collect_kernel_includes(src, files);
+	if(!file_name.empty()) files.insert(file_name);
+	
+	lock_guard<mutex> lock(dependency_lock);
+	for(const auto& file : files) {
+		if(kernel_file_hashes.count(file) == 0) {
+			kernel_file_hashes.emplace(file, kernel_file_hash(make_kernel_path(file)));
+		}
+	}
+	kernel_dependencies[identifier].insert(files.begin(), files.end());
+}
+
+void opencl_base::untrack_kernel_dependencies(const string& identifier) {
+	lock_guard<mutex> lock(dependency_lock);
+	kernel_dependencies.erase(identifier);
+}
+
+set<string> opencl_base::find_changed_kernel_files() {
+	set<string> changed_files;
+	lock_guard<mutex> lock(dependency_lock);
+	for(auto& file : kernel_file_hashes) {
+		const uint64 hash = kernel_file_hash(make_kernel_path(file.first));
+		if(hash == file.second) continue;
+		file.second = hash;
+		changed_files.insert(file.first);
+	}
+	return changed_files;
+}
+
+bool opencl_base::kernel_depends_on(weak_ptr<kernel_object> kernel_obj, const set<string>& files) {
+	const auto kernel_ptr = kernel_obj.lock();
+	if(kernel_ptr == nullptr || files.empty()) return false;
+	
+	lock_guard<mutex> lock(dependency_lock);
+	const auto deps = kernel_dependencies.find(kernel_ptr->name);
+	if(deps == kernel_dependencies.end()) return false;
+	for(const auto& file : files) {
+		if(deps->second.count(file) > 0) return true;
+	}
+	return false;
 }
 
 void opencl_base::check_compilation(const bool ret, const string& filename) {
@@ -156,29 +235,438 @@ void opencl_base::check_compilation(const bool ret, const string& filename) {
 	}
 }
 
-void opencl_base::reload_kernels() {
-	kernels_lock.lock();
+// internal kernels that are only needed by certain pipeline configurations or features
+// -> these are compiled on first use (or prefetched in the background), all others are compiled before init returns
+static const set<string> lazy_internal_kernels {
+	"BIN_COARSE",
+	"BIN_SCATTER.CLEAR",
+	"BIN_SCATTER",
+	"BIN_SCATTER.COUNT",
+	"BIN_SCATTER.PREFIX_SUM",
+	"BIN_SCATTER.WRITE",
+	"PROCESSING.ORTHOGRAPHIC",
+	"PROCESSING.ORTHOGRAPHIC.FIXED_POINT",
+	"FXAA.LUMA",
+	"FXAA",
+};
+
+void opencl_base::reload_kernels(const bool full_reload) {
+	const auto compile_start = SDL_GetPerformanceCounter();
+	bool initial_load = false;
+	{
+		lock_guard<mutex> lock(internal_kernels_lock);
+		initial_load = internal_kernel_states.empty();
+	}
+	if(!full_reload && !initial_load) {
+		reload_changed_kernels();
+		return;
+	}
 	destroy_kernels();
 	
 	successful_internal_compilation = true;
 	
-	for(const auto& int_kernel : internal_kernels) {
-		check_compilation(add_kernel_file(get<0>(int_kernel),
-										  make_kernel_path(get<1>(int_kernel)),
-										  get<2>(int_kernel),
-										  get<3>(int_kernel)).use_count() > 0,
-						  get<1>(int_kernel));
-	}
-	kernels_lock.unlock();
+	vector<size_t> core_kernels, lazy_kernels;
+	{
+		lock_guard<mutex> lock(internal_kernels_lock);
+		internal_kernel_states.clear();
+		for(size_t i = 0, count = internal_kernels.size(); i < count; i++) {
+			internal_kernel_states.emplace(get<0>(internal_kernels[i]), INTERNAL_KERNEL_STATE::PENDING);
+			if(lazy_internal_kernels.count(get<0>(internal_kernels[i])) > 0) lazy_kernels.emplace_back(i);
+			else core_kernels.emplace_back(i);
+		}
+		internal_kernels_ready = lazy_kernels.empty();
+	}
+	compile_internal_kernels(core_kernels);
 	
-	if(successful_internal_compilation) oclr_debug("internal kernels loaded successfully!");
+	if(successful_internal_compilation) {
+		oclr_debug("internal kernels loaded successfully! (%u core kernels in %fms, %u deferred)",
+				   core_kernels.size(),
+				   double(SDL_GetPerformanceCounter() - compile_start) * 1000.0 / double(SDL_GetPerformanceFrequency()),
+				   lazy_kernels.size());
+	}
 	else {
 		// one or more kernels didn't compile
 		oclr_error("there were problems loading/compiling the internal kernels!");
 	}
 	
+	// prefetch all remaining kernels in the background
+	// note: not possible if compilation is bound to the calling thread (-> compiled on first use)
+	if(parallel_kernel_compilation && !lazy_kernels.empty()) {
+		internal_kernel_prefetch = thread([this, lazy_kernels]() {
+			compile_internal_kernels(lazy_kernels);
+			internal_kernels_ready = true;
+		});
+	}
+	
 	// emit kernel reload event
-	oclraster::get_event()->add_event(EVENT_TYPE::KERNEL_RELOAD, make_shared<kernel_reload_event>(SDL_GetTicks()));
+	oclraster::get_event()->add_event(EVENT_TYPE::KERNEL_RELOAD,
+									  make_shared<kernel_reload_event>(SDL_GetTicks(), true, set<string> {}));
+}
+
+void opencl_base::reload_changed_kernels() {
+	const auto compile_start = SDL_GetPerformanceCounter();
+	
+	// internal kernels must not be compiled in the background while they are being replaced
+	finish_internal_kernel_prefetch();
+	
+	const set<string> changed_files { find_changed_kernel_files() };
+	
+	// find all (already compiled) internal kernels that depend on a changed file
+	vector<size_t> affected_kernels;
+	if(!changed_files.empty()) {
+		for(size_t i = 0, count = internal_kernels.size(); i < count; i++) {
+			const string& identifier = get<0>(internal_kernels[i]);
+			{
+				lock_guard<mutex> lock(internal_kernels_lock);
+				if(internal_kernel_states[identifier] != INTERNAL_KERNEL_STATE::DONE) continue;
+			}
+			
+			kernels_lock.lock();
+			const auto kernel_iter = kernels.find(identifier);
+			weak_ptr<kernel_object> kernel = (kernel_iter != kernels.end() ? kernel_iter->second : null_kernel_object);
+			kernels_lock.unlock();
+			
+			if(kernel.use_count() > 0 && !kernel_depends_on(kernel, changed_files)) continue;
+			affected_kernels.emplace_back(i);
+		}
+	}
+	
+	// delete and recompile them
+	if(!affected_kernels.empty()) {
+		successful_internal_compilation = true;
+		for(const auto& idx : affected_kernels) {
+			const string& identifier = get<0>(internal_kernels[idx]);
+			kernels_lock.lock();
+			const auto kernel_iter = kernels.find(identifier);
+			weak_ptr<kernel_object> kernel = (kernel_iter != kernels.end() ? kernel_iter->second : null_kernel_object);
+			kernels_lock.unlock();
+			delete_kernel(kernel);
+			
+			lock_guard<mutex> lock(internal_kernels_lock);
+			internal_kernel_states[identifier] = INTERNAL_KERNEL_STATE::PENDING;
+		}
+		compile_internal_kernels(affected_kernels);
+		if(!successful_internal_compilation) {
+			oclr_error("there were problems recompiling the internal kernels!");
+		}
+	}
+	
+	oclr_debug("kernel reload: %u changed files, %u internal kernels rebuilt (%fms)",
+			   changed_files.size(), affected_kernels.size(),
+			   double(SDL_GetPerformanceCounter() - compile_start) * 1000.0 / double(SDL_GetPerformanceFrequency()));
+	
+	// emit kernel reload event (-> users of other kernels must check if they are affected)
+	oclraster::get_event()->add_event(EVENT_TYPE::KERNEL_RELOAD,
+									  make_shared<kernel_reload_event>(SDL_GetTicks(), false, changed_files));
+}
+
+void opencl_base::compile_internal_kernels(const vector<size_t>& kernel_indices) {
+	if(kernel_indices.empty()) return;
+	const size_t worker_count = (!parallel_kernel_compilation ? 1 :
+								 std::min(kernel_indices.size(), size_t(std::max(thread::hardware_concurrency(), 1u))));
+	atomic<size_t> next_kernel { 0 };
+	const auto worker = [this, &kernel_indices, &next_kernel]() {
+		for(size_t idx = next_kernel++; idx < kernel_indices.size(); idx = next_kernel++) {
+			compile_internal_kernel(kernel_indices[idx]);
+		}
+	};
+	
+	// the calling thread is one of the workers
+	vector<thread> workers;
+	for(size_t i = 1; i < worker_count; i++) {
+		workers.emplace_back(worker);
+	}
+	worker();
+	for(auto& worker_thread : workers) {
+		worker_thread.join();
+	}
+}
+
+void opencl_base::compile_internal_kernel(const size_t kernel_index) {
+	const auto& int_kernel = internal_kernels[kernel_index];
+	{
+		// another thread might already be compiling this kernel (-> require_internal_kernel)
+		lock_guard<mutex> lock(internal_kernels_lock);
+		auto& state = internal_kernel_states[get<0>(int_kernel)];
+		if(state != INTERNAL_KERNEL_STATE::PENDING) return;
+		state = INTERNAL_KERNEL_STATE::COMPILING;
+	}
+	
+	check_compilation(add_kernel_file(get<0>(int_kernel),
+									  make_kernel_path(get<1>(int_kernel)),
+									  get<2>(int_kernel),
+									  get_tuning_options() + get<3>(int_kernel)).use_count() > 0,
+					  get<1>(int_kernel));
+	
+	{
+		lock_guard<mutex> lock(internal_kernels_lock);
+		internal_kernel_states[get<0>(int_kernel)] = INTERNAL_KERNEL_STATE::DONE;
+	}
+	internal_kernels_cv.notify_all();
+}
+
+void opencl_base::require_internal_kernel(const string& identifier) {
+	if(internal_kernels_ready) return;
+	
+	unique_lock<mutex> lock(internal_kernels_lock);
+	const auto state_iter = internal_kernel_states.find(identifier);
+	if(state_iter == internal_kernel_states.end()) return; // not an internal kernel
+	if(state_iter->second == INTERNAL_KERNEL_STATE::PENDING) {
+		// not compiled yet -> compile it now
+		lock.unlock();
+		for(size_t i = 0, count = internal_kernels.size(); i < count; i++) {
+			if(get<0>(internal_kernels[i]) == identifier) {
+				oclr_debug("compiling internal kernel \"%s\" on first use", identifier);
+				compile_internal_kernel(i);
+				break;
+			}
+		}
+		lock.lock();
+	}
+	// wait until it has been compiled (by the background prefetch or another thread)
+	internal_kernels_cv.wait(lock, [this, &identifier]() {
+		return (internal_kernel_states[identifier] == INTERNAL_KERNEL_STATE::DONE);
+	});
+}
+
+void opencl_base::finish_internal_kernel_prefetch() {
+	if(internal_kernel_prefetch.joinable()) {
+		internal_kernel_prefetch.join();
+	}
+}
+
+const opencl_base::device_object* opencl_base::get_primary_device() const {
+	// same order as in load_internal_kernels
+	return (fastest_gpu != nullptr ? fastest_gpu : fastest_cpu);
+}
+
+string opencl_base::get_tuning_options() const {
+	return " -DBIN_SIZE="+uint2string(tuning.bin_size)+" -DBATCH_SIZE="+uint2string(tuning.batch_size);
+}
+
+size_t opencl_base::get_tuned_work_group_size(const unsigned int tuned_wg_size) const {
+	const size_t max_wg_size = get_kernel_work_group_size();
+	if(tuned_wg_size == 0 || tuned_wg_size > max_wg_size) return max_wg_size;
+	return tuned_wg_size;
+}
+
+bool opencl_base::set_tuning(const tuning_parameters& params) {
+	// bins are split into 4x4 sub-tiles and batch queue entries are uchar indices (see bin_rasterize.cl),
+	// i.e. the bin size must be a power of two in [8, 64] and the batch size either 128 or 256
+	if(params.bin_size < 8 || params.bin_size > 64 || (params.bin_size & (params.bin_size - 1)) != 0) {
+		oclr_error("invalid bin size: %u", params.bin_size);
+		return false;
+	}
+	if(params.batch_size != 128 && params.batch_size != 256) {
+		oclr_error("invalid batch size: %u", params.batch_size);
+		return false;
+	}
+	const device_object* device = get_primary_device();
+	if(device != nullptr &&
+	   (params.rasterization_wg_size > device->max_wg_size || params.binning_wg_size > device->max_wg_size)) {
+		oclr_error("invalid work-group size: %u/%u (max: %u)",
+				   params.rasterization_wg_size, params.binning_wg_size, device->max_wg_size);
+		return false;
+	}
+	// the cpu rasterizer (no barriers) updates the per-bin depth bounds from a single work-item per bin
+	// -> the rasterization work-group size must be 1 on cpus
+	if(device != nullptr &&
+	   device->type >= DEVICE_TYPE::CPU0 && device->type <= DEVICE_TYPE::CPU255 &&
+	   params.rasterization_wg_size != 1) {
+		oclr_error("invalid rasterization work-group size for a cpu device: %u (must be 1)", params.rasterization_wg_size);
+		return false;
+	}
+	tuning = params;
+	return true;
+}
+
+// tuning file format (one device per line, '#' starts a comment):
+// device name;driver version;bin size;batch size;rasterization wg size;binning wg size
+static string tuning_device_key(const opencl_base::device_object* device) {
+	return device->name + ";" + device->driver_version + ";";
+}
+
+void opencl_base::load_tuning() {
+	tuning = tuning_parameters {};
+	const device_object* device = get_primary_device();
+	if(device == nullptr) return;
+	
+	if(device->type >= DEVICE_TYPE::CPU0 && device->type <= DEVICE_TYPE::CPU255) {
+		// for whatever reason, using a work-group size of 1 runs a lot faster than using 128 (most cpu implementations)
+		tuning.rasterization_wg_size = 1;
+	}
+	
+	const string tuning_filename { oclraster::data_path(oclraster::get_tuning_file()) };
+	stringstream tuning_data;
+	if(!file_io::is_file(tuning_filename) || !file_io::file_to_buffer(tuning_filename, tuning_data)) return;
+	
+	const string device_key { tuning_device_key(device) };
+	string line;
+	while(getline(tuning_data, line)) {
+		if(line.empty() || line[0] == '#') continue;
+		if(line.compare(0, device_key.size(), device_key) != 0) continue;
+		
+		const auto values = core::tokenize(line.substr(device_key.size()), ';');
+		if(values.size() != 4) {
+			oclr_error("invalid tuning file entry: %s", line);
+			continue;
+		}
+		tuning_parameters params;
+		params.bin_size = string2uint(values[0]);
+		params.batch_size = string2uint(values[1]);
+		params.rasterization_wg_size = string2uint(values[2]);
+		params.binning_wg_size = string2uint(values[3]);
+		if(set_tuning(params)) {
+			oclr_debug("using tuned pipeline parameters for %s: bin size %u, batch size %u, work-group sizes %u/%u",
+					   device->name, tuning.bin_size, tuning.batch_size,
+					   tuning.rasterization_wg_size, tuning.binning_wg_size);
+		}
+	}
+}
+
+bool opencl_base::save_tuning() const {
+	const device_object* device = get_primary_device();
+	if(device == nullptr) return false;
+	
+	// keep the entries of all other devices/drivers
+	const string tuning_filename { oclraster::data_path(oclraster::get_tuning_file()) };
+	const string device_key { tuning_device_key(device) };
+	stringstream old_tuning_data;
+	string tuning_data { "# device name;driver version;bin size;batch size;rasterization wg size;binning wg size\n" };
+	if(file_io::is_file(tuning_filename) && file_io::file_to_buffer(tuning_filename, old_tuning_data)) {
+		string line;
+		while(getline(old_tuning_data, line)) {
+			if(line.empty() || line[0] == '#') continue;
+			if(line.compare(0, device_key.size(), device_key) == 0) continue;
+			tuning_data += line + "\n";
+		}
+	}
+	tuning_data += (device_key + uint2string(tuning.bin_size) + ";" + uint2string(tuning.batch_size) + ";" +
+					uint2string(tuning.rasterization_wg_size) + ";" + uint2string(tuning.binning_wg_size) + "\n");
+	
+	if(!file_io::string_to_file(tuning_filename, tuning_data)) {
+		oclr_error("couldn't write the tuning file \"%s\"!", tuning_filename);
+		return false;
+	}
+	return true;
+}
+
+const char* opencl_base::profiling_stage_to_string(const PROFILING_STAGE stage) {
+	switch(stage) {
+		case PROFILING_STAGE::TRANSFORM: return "transform";
+		case PROFILING_STAGE::PROCESSING: return "processing";
+		case PROFILING_STAGE::BINNING: return "binning";
+		case PROFILING_STAGE::RASTERIZATION: return "rasterization";
+		case PROFILING_STAGE::CLEAR: return "clear";
+		case PROFILING_STAGE::FXAA: return "fxaa";
+		case PROFILING_STAGE::SWAP_READBACK: return "swap readback";
+		case PROFILING_STAGE::OTHER:
+		case PROFILING_STAGE::__MAX_PROFILING_STAGE: break;
+	}
+	return "other";
+}
+
+opencl_base::profiling_stage_scope::profiling_stage_scope(const PROFILING_STAGE stage) : prev_stage(ocl->profiling_stage) {
+	ocl->profiling_stage = stage;
+}
+
+opencl_base::profiling_stage_scope::~profiling_stage_scope() {
+	ocl->profiling_stage = prev_stage;
+}
+
+void opencl_base::next_profiling_draw() {
+	profiling_draw_index++;
+}
+
+void opencl_base::record_profiling_event(const cl::Event& evt, const string& name) {
+	pending_profiling_events.emplace_back(evt, profiling_event { name, profiling_stage, profiling_draw_index, 0, 0 });
+}
+
+void opencl_base::end_profiling_frame() {
+#if defined(OCLRASTER_PROFILING)
+	profiling_frame frame;
+	frame.frame_index = profiling_frame_index;
+	for(auto& pending_event : pending_profiling_events) {
+		try {
+			pending_event.first.wait();
+			pending_event.second.start = pending_event.first.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+			pending_event.second.end = pending_event.first.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+		}
+		catch(cl::Error err) {
+			oclr_error("failed to get the profiling info of \"%s\": %s (%d: %s)!",
+					   pending_event.second.name, err.what(), err.err(), error_code_to_string(err.err()));
+			continue;
+		}
+		frame.stage_times[(size_t)pending_event.second.stage] += double(pending_event.second.end - pending_event.second.start) / 1000000.0;
+		frame.events.emplace_back(pending_event.second);
+	}
+	profiling_frames.emplace_back(frame);
+	if(profiling_frames.size() > max_profiling_frames) {
+		profiling_frames.pop_front();
+	}
+#endif
+	pending_profiling_events.clear();
+	profiling_draw_index = 0;
+	profiling_frame_index++;
+}
+
+const opencl_base::profiling_frame& opencl_base::get_profiling_frame() const {
+	static const profiling_frame empty_frame;
+	return (profiling_frames.empty() ? empty_frame : profiling_frames.back());
+}
+
+bool opencl_base::write_profiling_trace(const string& filename) const {
+	if(profiling_frames.empty()) {
+		oclr_error("no profiling data recorded (requires OCLRASTER_PROFILING)!");
+		return false;
+	}
+	
+	// timestamps are in us, relative to the first recorded event
+	cl_ulong base_time = ~cl_ulong(0);
+	for(const auto& frame : profiling_frames) {
+		for(const auto& evt : frame.events) {
+			base_time = std::min(base_time, evt.start);
+		}
+	}
+	const auto to_us = [&base_time](const cl_ulong& t) {
+		return double(t - base_time) / 1000.0;
+	};
+	
+	// one "thread" per stage and one for the frames
+	static constexpr size_t frame_tid { (size_t)PROFILING_STAGE::__MAX_PROFILING_STAGE };
+	stringstream trace;
+	trace.precision(3);
+	trace << fixed << "{\"traceEvents\":[\n";
+	for(size_t i = 0; i < frame_tid; i++) {
+		trace << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i;
+		trace << ",\"args\":{\"name\":\"" << profiling_stage_to_string((PROFILING_STAGE)i) << "\"}},\n";
+	}
+	trace << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << frame_tid;
+	trace << ",\"args\":{\"name\":\"frames\"}}";
+	
+	for(const auto& frame : profiling_frames) {
+		if(frame.events.empty()) continue;
+		cl_ulong frame_start = ~cl_ulong(0), frame_end = 0;
+		for(const auto& evt : frame.events) {
+			trace << ",\n{\"name\":\"" << evt.name << "\",\"cat\":\"" << profiling_stage_to_string(evt.stage) << "\"";
+			trace << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << (size_t)evt.stage;
+			trace << ",\"ts\":" << to_us(evt.start) << ",\"dur\":" << (double(evt.end - evt.start) / 1000.0);
+			trace << ",\"args\":{\"frame\":" << frame.frame_index << ",\"draw\":" << evt.draw_index << "}}";
+			frame_start = std::min(frame_start, evt.start);
+			frame_end = std::max(frame_end, evt.end);
+		}
+		trace << ",\n{\"name\":\"frame " << frame.frame_index << "\",\"cat\":\"frame\"";
+		trace << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << frame_tid;
+		trace << ",\"ts\":" << to_us(frame_start) << ",\"dur\":" << (double(frame_end - frame_start) / 1000.0) << "}";
+	}
+	trace << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	
+	string trace_str { trace.str() };
+	if(!file_io::string_to_file(filename, trace_str)) {
+		oclr_error("couldn't write the profiling trace \"%s\"!", filename);
+		return false;
+	}
+	return true;
 }
 
 void opencl_base::load_internal_kernels() {
@@ -189,6 +677,7 @@ void opencl_base::load_internal_kernels() {
 }
 
 void opencl_base::use_kernel(const string& identifier) {
+	require_internal_kernel(identifier);
 	lock_guard<recursive_mutex> lock(kernels_lock);
 	const auto kernel_iter = kernels.find(identifier);
 	if(kernel_iter == kernels.end()) {
@@ -208,6 +697,7 @@ void opencl_base::run_kernel() {
 }
 
 void opencl_base::run_kernel(const string& identifier) {
+	require_internal_kernel(identifier);
 	kernels_lock.lock();
 	const auto iter = kernels.find(identifier);
 	if(iter != kernels.end()) {
@@ -226,6 +716,7 @@ void opencl_base::delete_kernel(const string& identifier) {
 		auto kernel_ptr = iter->second;
 		kernels_lock.unlock();
 		delete_kernel(kernel_ptr);
+		return;
 	}
 	kernels_lock.unlock();
 	oclr_error("kernel \"%s\" doesn't exist!", identifier);
@@ -349,6 +840,29 @@ void opencl_base::set_manual_gl_sharing(buffer_object* gl_buffer_obj, const bool
 	gl_buffer_obj->manual_gl_sharing = state;
 }
 
+size_t opencl_base::get_allocated_memory() const {
+	size_t allocated_memory = 0;
+	for(const auto& buffer_obj : buffers) {
+		// sub-buffers use the memory of their parent and opengl objects are owned by opengl
+		if(buffer_obj->parent_buffer != nullptr ||
+		   (buffer_obj->type & BUFFER_FLAG::OPENGL_BUFFER) != BUFFER_FLAG::NONE) {
+			continue;
+		}
+		if(buffer_obj->image_buffer != nullptr) {
+			try {
+				allocated_memory += (buffer_obj->image_size.x * buffer_obj->image_size.y * buffer_obj->image_size.z *
+									 buffer_obj->image_buffer->getImageInfo<CL_IMAGE_ELEMENT_SIZE>());
+			}
+			catch(cl::Error err) {
+				oclr_error("failed to get the image element size: %s (%d: %s)!",
+						   err.what(), err.err(), error_code_to_string(err.err()));
+			}
+		}
+		else allocated_memory += buffer_obj->size;
+	}
+	return allocated_memory;
+}
+
 const vector<cl::ImageFormat>& opencl_base::get_image_formats() const {
 	return img_formats;
 }
@@ -575,6 +1089,12 @@ opencl::opencl(const char* kernel_path, SDL_Window* wnd, const bool clear_cache)
 	build_options += " -DOS_X_VERSION=" + size_t2string(osx_helper::get_system_version());
 #endif
 	
+	// program binary cache (same location as the cuda cache)
+	cache_path = kernel_path_str.substr(0, kernel_path_str.rfind('/', kernel_path_str.length()-2)) + "/cache/";
+	if(!file_io::create_directory(cache_path)) {
+		oclr_error("couldn't create the program binary cache directory \"%s\"!", cache_path);
+	}
+	
 	// clear opencl cache
 	if(clear_cache) {
 #if defined(__APPLE__)
@@ -585,6 +1105,20 @@ opencl::opencl(const char* kernel_path, SDL_Window* wnd, const bool clear_cache)
 		system("rm -R ~/.nv/ComputeCache > /dev/null 2>&1");
 #endif
 	}
+	
+	// delete all cached program binaries and preprocessed programs
+	// note: these are keyed by a hash of everything that affects the compilation (-> never stale), so this
+	// is separate from clear_cache, which is enabled by default
+	if(oclraster::get_clear_program_cache()) {
+		for(const auto& ext : { "clbin", "pp" }) {
+			for(const auto& cache_file : core::get_file_list(cache_path, ext)) {
+				if(cache_file.second == file_io::FILE_TYPE::DIR) continue;
+				if(remove((cache_path + cache_file.first).c_str()) != 0) {
+					oclr_error("couldn't delete cached file \"%s\"!", cache_file.first);
+				}
+			}
+		}
+	}
 }
 
 /*! opencl destructor
@@ -686,9 +1220,10 @@ void opencl::init(bool use_platform_devices, const size_t platform_index,
 			0
 		};
 #else // Linux, hopefully *BSD too
+		// note: there is no window without gl sharing (headless mode)
 		SDL_SysWMinfo wm_info;
 		SDL_VERSION(&wm_info.version);
-		if(SDL_GetWindowWMInfo(sdl_wnd, &wm_info) != 1) {
+		if(gl_sharing && SDL_GetWindowWMInfo(sdl_wnd, &wm_info) != 1) {
 			oclr_error("couldn't get window manger info!");
 			return;
 		}
@@ -812,6 +1347,7 @@ void opencl::init(bool use_platform_devices, const size_t platform_index,
 			device->extensions = internal_device.getInfo<CL_DEVICE_EXTENSIONS>();
 			
 			device->max_alloc = internal_device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+			device->base_addr_align = internal_device.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>() / 8; // bits -> bytes
 			device->max_wg_size = internal_device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
 			const auto max_wi_sizes = internal_device.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
 			device->max_wi_sizes.set(max_wi_sizes[0], max_wi_sizes[1], max_wi_sizes[2]);
@@ -831,7 +1367,7 @@ void opencl::init(bool use_platform_devices, const size_t platform_index,
 					 device->mem_size / 1024ULL / 1024ULL,
 					 device->local_mem_size / 1024ULL,
 					 device->constant_mem_size / 1024ULL);
-			oclr_msg("mem base address alignment: %u", internal_device.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>());
+			oclr_msg("mem base address alignment: %u bytes", device->base_addr_align);
 			oclr_msg("min data type alignment size: %u", internal_device.getInfo<CL_DEVICE_MIN_DATA_TYPE_ALIGN_SIZE>());
 			oclr_msg("host unified memory: %u", internal_device.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>());
 			oclr_msg("max_wi_sizes: %v", device->max_wi_sizes);
@@ -978,28 +1514,50 @@ void opencl::init(bool use_platform_devices, const size_t platform_index,
 		if(fastest_cpu != nullptr) oclr_debug("fastest CPU device: %s %s (score: %u)", fastest_cpu->vendor.c_str(), fastest_cpu->name.c_str(), fastest_cpu_score);
 		if(fastest_gpu != nullptr) oclr_debug("fastest GPU device: %s %s (score: %u)", fastest_gpu->vendor.c_str(), fastest_gpu->name.c_str(), fastest_gpu_score);
 		
+		// load the pipeline tuning parameters of the primary device (these are compiled into all kernels)
+		load_tuning();
+		
 		// compile internal kernels
 		internal_kernels = { // first time init:
-			make_tuple("BIN_RASTERIZE", "bin_rasterize.cl", "oclraster_bin",
-					   " -DBIN_SIZE="+uint2string(OCLRASTER_BIN_SIZE)+
-					   " -DBATCH_SIZE="+uint2string(OCLRASTER_BATCH_SIZE)),
+			make_tuple("BIN_RASTERIZE", "bin_rasterize.cl", "oclraster_bin", ""),
+			
+			make_tuple("BIN_DEPTH_BOUNDS.CLEAR", "bin_rasterize.cl", "oclraster_bin_depth_bounds_clear", ""),
+			
+			make_tuple("BIN_COARSE", "bin_rasterize.cl", "oclraster_bin_coarse", ""),
+			
+			make_tuple("BIN_SCATTER.CLEAR", "bin_rasterize.cl", "oclraster_bin_scatter_clear", ""),
+			
+			make_tuple("BIN_SCATTER", "bin_rasterize.cl", "oclraster_bin_scatter", ""),
+			
+			make_tuple("BIN_SCATTER.COUNT", "bin_rasterize.cl", "oclraster_bin_scatter_count", ""),
+			
+			make_tuple("BIN_SCATTER.PREFIX_SUM", "bin_rasterize.cl", "oclraster_bin_scatter_prefix_sum", ""),
+			
+			make_tuple("BIN_SCATTER.WRITE", "bin_rasterize.cl", "oclraster_bin_scatter_write", ""),
 			
 			make_tuple("PROCESSING.PERSPECTIVE", "processing.cl", "oclraster_processing",
-					   " -DBIN_SIZE="+uint2string(OCLRASTER_BIN_SIZE)+
-					   " -DBATCH_SIZE="+uint2string(OCLRASTER_BATCH_SIZE)+
 					   " -DOCLRASTER_PROJECTION_PERSPECTIVE"),
 			
 			make_tuple("PROCESSING.ORTHOGRAPHIC", "processing.cl", "oclraster_processing",
-					   " -DBIN_SIZE="+uint2string(OCLRASTER_BIN_SIZE)+
-					   " -DBATCH_SIZE="+uint2string(OCLRASTER_BATCH_SIZE)+
 					   " -DOCLRASTER_PROJECTION_ORTHOGRAPHIC"),
 			
+			make_tuple("PROCESSING.ORTHOGRAPHIC.FIXED_POINT", "processing.cl", "oclraster_processing",
+					   " -DOCLRASTER_PROJECTION_ORTHOGRAPHIC -DOCLRASTER_FIXED_POINT_RASTERIZATION"),
+			
+			make_tuple("PROCESSING.REBASE_INDICES", "processing.cl", "oclraster_rebase_indices",
+					   " -DOCLRASTER_PROJECTION_PERSPECTIVE"),
+			
 #if defined(OCLRASTER_FXAA)
 			make_tuple("FXAA.LUMA", "luma_pass.cl", "framebuffer_luma", ""),
 			make_tuple("FXAA", "fxaa_pass.cl", "framebuffer_fxaa", ""),
 #endif
 		};
 		
+		// load the kernel bundle (if specified) before any kernel is compiled
+		if(!oclraster::get_kernel_bundle().empty()) {
+			load_kernel_bundle(oclraster::data_path(oclraster::get_kernel_bundle()));
+		}
+		
 		load_internal_kernels();
 	}
 	__HANDLE_CL_EXCEPTION_START("init")
@@ -1201,6 +1759,7 @@ weak_ptr<opencl::kernel_object> opencl::add_kernel_src(const string& identifier,
 	kernels.emplace(identifier, kernel_ptr);
 	
 	kernels_lock.unlock();
+	track_kernel_dependencies(identifier, src);
 	
 	//
 	oclr_debug("compiling \"%s\" kernel!", identifier);
@@ -1238,10 +1797,10 @@ weak_ptr<opencl::kernel_object> opencl::add_kernel_src(const string& identifier,
 		
 		// add kernel
 		kernel_ptr->name = identifier;
-		cl::Program::Sources source(1, make_pair(src.c_str(), src.length()));
-		kernel_ptr->program = new cl::Program(*context, source);
 		
 		// compile for each device independently to add device-specific defines
+		vector<string> device_build_options;
+		vector<uint128> device_hashes;
 		for(const auto& device : devices) {
 			string device_options = "";
 			switch(device->vendor_type) {
@@ -1271,10 +1830,62 @@ weak_ptr<opencl::kernel_object> opencl::add_kernel_src(const string& identifier,
 			device_options += " -DLOCAL_MEM_SIZE=6144";
 			if(device->double_support) device_options += " -DOCLRASTER_DOUBLE_SUPPORT";
 			
-			kernel_ptr->program->build({ device->device }, (options+device_options).c_str());
+			device_build_options.emplace_back(options + device_options);
+			device_hashes.emplace_back(compute_program_hash(src, device_build_options.back(), device));
+		}
+		
+		// try to create the program from cached binaries (only if there is a binary for each device)
+		const auto compile_start = SDL_GetPerformanceCounter();
+		bool cache_hit = false;
+		vector<string> binaries;
+		for(const auto& hash : device_hashes) {
+			string binary;
+			if(!read_program_binary(hash, binary)) break;
+			binaries.emplace_back(binary);
+		}
+		if(!devices.empty() && binaries.size() == devices.size()) {
+			vector<cl::Device> cl_devices;
+			cl::Program::Binaries cl_binaries;
+			for(size_t i = 0, count = devices.size(); i < count; i++) {
+				cl_devices.emplace_back(devices[i]->device);
+				cl_binaries.emplace_back(binaries[i].data(), binaries[i].size());
+			}
+			try {
+				kernel_ptr->program = new cl::Program(*context, cl_devices, cl_binaries);
+				for(size_t i = 0, count = devices.size(); i < count; i++) {
+					kernel_ptr->program->build({ devices[i]->device }, device_build_options[i].c_str());
+				}
+				cache_hit = true;
+				if(bundle_recording) {
+					for(size_t i = 0, count = devices.size(); i < count; i++) {
+						record_program_binary(device_hashes[i], devices[i], binaries[i]);
+					}
+				}
+			}
+			catch(cl::Error err) {
+				// binary is invalid or incompatible -> recompile
+				oclr_debug("invalid cached program binary for \"%s\": %s (%d)", identifier, err.what(), err.err());
+				if(kernel_ptr->program != nullptr) {
+					delete kernel_ptr->program;
+					kernel_ptr->program = nullptr;
+				}
+			}
 		}
 		
-		kernel_ptr->kernel = new cl::Kernel(*kernel_ptr->program, func_name.c_str(), &ierr);
+		if(!cache_hit) {
+			cl::Program::Sources source(1, make_pair(src.c_str(), src.length()));
+			kernel_ptr->program = new cl::Program(*context, source);
+			for(size_t i = 0, count = devices.size(); i < count; i++) {
+				kernel_ptr->program->build({ devices[i]->device }, device_build_options[i].c_str());
+			}
+			write_program_binaries(*kernel_ptr->program, device_hashes);
+		}
+		oclr_debug("%s \"%s\" (%fms)", (cache_hit ? "program cache hit:" : "program cache miss, compiled"), identifier,
+				   double(SDL_GetPerformanceCounter() - compile_start) * 1000.0 / double(SDL_GetPerformanceFrequency()));
+		
+		// note: internal kernels are compiled in parallel -> don't use the shared ierr member here
+		cl_int kernel_ierr = CL_SUCCESS;
+		kernel_ptr->kernel = new cl::Kernel(*kernel_ptr->program, func_name.c_str(), &kernel_ierr);
 		
 		kernel_ptr->arg_count = kernel_ptr->kernel->getInfo<CL_KERNEL_NUM_ARGS>();
 		kernel_ptr->args_passed.insert(kernel_ptr->args_passed.begin(), kernel_ptr->arg_count, false);
@@ -1332,6 +1943,288 @@ weak_ptr<opencl::kernel_object> opencl::add_kernel_src(const string& identifier,
 	return kernel_ptr;
 }
 
+uint128 opencl::compute_program_hash(const string& src, const string& options, const device_object* device) const {
+	// note: included headers can change independently of the program source -> hash their content as well
+	string hash_src = src;
+	set<string> included;
+	append_include_sources(src, hash_src, included);
+	
+	hash_src += '\0' + options;
+	hash_src += '\0' + platform->getInfo<CL_PLATFORM_NAME>() + '\0' + platform->getInfo<CL_PLATFORM_VERSION>();
+	hash_src += '\0' + device->name + '\0' + device->vendor + '\0' + device->version + '\0' + device->driver_version;
+	return CityHash128(hash_src.c_str(), hash_src.size());
+}
+
+void opencl::append_include_sources(const string& src, string& hash_src, set<string>& included) const {
+	// only "..." includes are resolved (relative to the kernel path, the only include path)
+	static const string include_directive { "#include" };
+	for(size_t pos = src.find(include_directive); pos != string::npos; pos = src.find(include_directive, pos + 1)) {
+		const size_t name_start = src.find_first_not_of(" \t", pos + include_directive.size());
+		if(name_start == string::npos || src[name_start] != '\"') continue;
+		const size_t name_end = src.find('\"', name_start + 1);
+		if(name_end == string::npos) continue;
+		
+		const string include_name = src.substr(name_start + 1, name_end - name_start - 1);
+		if(!included.insert(include_name).second) continue;
+		
+		string include_src;
+		if(!file_io::file_to_string(make_kernel_path(include_name), include_src)) {
+			// not a kernel header (or it doesn't exist) -> at least consider the name
+			hash_src += '\0' + include_name;
+			continue;
+		}
+		hash_src += '\0' + include_src;
+		append_include_sources(include_src, hash_src, included);
+	}
+}
+
+static string program_cache_filename(const uint128& hash) {
+	// uint128 hash -> string conversion (+fill up with 0s if necessary, same as the cuda cache)
+	stringstream sstr_upper; sstr_upper << hex << hash.first;
+	stringstream sstr_lower; sstr_lower << hex << hash.second;
+	string upper_hash { sstr_upper.str() };
+	string lower_hash { sstr_lower.str() };
+	if(upper_hash.size() < 16) upper_hash.insert(0, 16 - upper_hash.size(), '0');
+	if(lower_hash.size() < 16) lower_hash.insert(0, 16 - lower_hash.size(), '0');
+	return upper_hash + lower_hash + ".clbin";
+}
+
+bool opencl::read_program_binary(const uint128& hash, string& binary) const {
+	const auto bundle_iter = bundle_binaries.find(hash);
+	if(bundle_iter != bundle_binaries.end()) {
+		binary = bundle_iter->second;
+		return true;
+	}
+	
+	fstream bin_file(cache_path + program_cache_filename(hash), fstream::in | fstream::binary);
+	if(!bin_file.is_open()) return false;
+	binary.assign(istreambuf_iterator<char>(bin_file), istreambuf_iterator<char>());
+	bin_file.close();
+	return !binary.empty();
+}
+
+void opencl::write_program_binaries(const cl::Program& program, const vector<uint128>& hashes) {
+	try {
+		// note: the program may have been created for more devices than are actually used
+		const vector<cl::Device> program_devices = program.getInfo<CL_PROGRAM_DEVICES>();
+		const vector<size_t> program_sizes = program.getInfo<CL_PROGRAM_BINARY_SIZES>();
+		if(program_sizes.size() != program_devices.size()) return;
+		
+		vector<vector<unsigned char>> binary_data(program_sizes.size());
+		vector<unsigned char*> program_binaries(program_sizes.size(), nullptr);
+		for(size_t i = 0; i < program_sizes.size(); i++) {
+			binary_data[i].resize(program_sizes[i] + 1);
+			program_binaries[i] = binary_data[i].data();
+		}
+		clGetProgramInfo(program(), CL_PROGRAM_BINARIES, program_binaries.size() * sizeof(unsigned char*),
+						 program_binaries.data(), nullptr);
+		
+		for(size_t i = 0, count = devices.size(); i < count; i++) {
+			for(size_t j = 0; j < program_devices.size(); j++) {
+				if(program_devices[j]() != devices[i]->device()) continue;
+				if(program_sizes[j] == 0) break;
+				if(bundle_recording) {
+					record_program_binary(hashes[i], devices[i],
+										  string((const char*)program_binaries[j], program_sizes[j]));
+				}
+				
+				const string filename { cache_path + program_cache_filename(hashes[i]) };
+				fstream bin_file(filename, fstream::out | fstream::binary | fstream::trunc);
+				if(!bin_file.is_open()) {
+					oclr_error("couldn't write program binary \"%s\"!", filename);
+					break;
+				}
+				bin_file.write((const char*)program_binaries[j], (streamsize)program_sizes[j]);
+				bin_file.close();
+				break;
+			}
+		}
+	}
+	__HANDLE_CL_EXCEPTION("write_program_binaries")
+}
+
+// kernel bundle format (all uints are stored big-endian, strings are 0-terminated):
+// "OCLRBNDL", uint format version, oclraster version string,
+// uint #devices, [device name, vendor, version, driver version]*,
+// uint #binaries, [uint hash[4], uint size, binary data]*,
+// uint #struct layouts, [struct layout cache entry]*
+static constexpr char kernel_bundle_magic[8] { 'O', 'C', 'L', 'R', 'B', 'N', 'D', 'L' };
+static constexpr unsigned int kernel_bundle_version { 2 };
+
+bool opencl::load_kernel_bundle(const string& filename) {
+	file_io bundle_file(filename, file_io::OPEN_TYPE::READ_BINARY);
+	if(!bundle_file.is_open()) {
+		oclr_error("couldn't open kernel bundle \"%s\"!", filename);
+		return false;
+	}
+	
+	char magic[8];
+	bundle_file.get_block(magic, 8);
+	if(!bundle_file.good() || memcmp(magic, kernel_bundle_magic, 8) != 0) {
+		oclr_error("\"%s\" is not a kernel bundle!", filename);
+		return false;
+	}
+	const unsigned int version = bundle_file.get_uint();
+	string oclr_version = "";
+	bundle_file.get_terminated_block(oclr_version, '\0');
+	if(version != kernel_bundle_version || oclr_version != oclraster::get_version()) {
+		oclr_log("kernel bundle \"%s\" was created by another oclraster version (%u: %s) - falling back to source compilation",
+				 filename, version, oclr_version);
+		return false;
+	}
+	
+	// at least one device in this context must match a bundle device
+	// note: everything else (build options, sources) is part of the program hash
+	bool device_match = false;
+	const unsigned int device_count = bundle_file.get_uint();
+	for(unsigned int i = 0; i < device_count && bundle_file.good(); i++) {
+		string name = "", vendor = "", dev_version = "", driver_version = "";
+		bundle_file.get_terminated_block(name, '\0');
+		bundle_file.get_terminated_block(vendor, '\0');
+		bundle_file.get_terminated_block(dev_version, '\0');
+		bundle_file.get_terminated_block(driver_version, '\0');
+		for(const auto& device : devices) {
+			if(device->name == name && device->vendor == vendor &&
+			   device->version == dev_version && device->driver_version == driver_version) {
+				device_match = true;
+			}
+		}
+		if(!device_match) {
+			oclr_debug("kernel bundle device: %s (%s, %s, %s)", name, vendor, dev_version, driver_version);
+		}
+	}
+	if(!device_match) {
+		oclr_log("kernel bundle \"%s\" was not created for any of the active devices/drivers - falling back to source compilation",
+				 filename);
+		return false;
+	}
+	
+	map<uint128, string> binaries;
+	const unsigned int binary_count = bundle_file.get_uint();
+	for(unsigned int i = 0; i < binary_count; i++) {
+		uint128 hash;
+		hash.first = ((unsigned long long int)bundle_file.get_uint() << 32ull);
+		hash.first |= (unsigned long long int)bundle_file.get_uint();
+		hash.second = ((unsigned long long int)bundle_file.get_uint() << 32ull);
+		hash.second |= (unsigned long long int)bundle_file.get_uint();
+		const unsigned int size = bundle_file.get_uint();
+		string binary(size, '\0');
+		bundle_file.get_block(&binary[0], size);
+		if(!bundle_file.good()) {
+			oclr_error("kernel bundle \"%s\" is truncated - falling back to source compilation!", filename);
+			return false;
+		}
+		binaries.emplace(hash, binary);
+	}
+	
+	// struct layouts of all bundle devices (-> oclraster_program::load_struct_layouts)
+	vector<string> struct_layouts;
+	const unsigned int struct_layout_count = bundle_file.get_uint();
+	for(unsigned int i = 0; i < struct_layout_count && bundle_file.good(); i++) {
+		string layout = "";
+		bundle_file.get_terminated_block(layout, '\0');
+		struct_layouts.emplace_back(layout);
+	}
+	if(!bundle_file.good()) {
+		oclr_error("kernel bundle \"%s\" is truncated - falling back to source compilation!", filename);
+		return false;
+	}
+	bundle_file.close();
+	
+	bundle_binaries.swap(binaries);
+	bundle_struct_layouts.swap(struct_layouts);
+	oclr_log("loaded kernel bundle \"%s\" (%u program binaries, %u struct layouts)", filename,
+			 bundle_binaries.size(), bundle_struct_layouts.size());
+	return true;
+}
+
+void opencl::record_kernel_bundle() {
+	lock_guard<mutex> lock(bundle_lock);
+	recorded_binaries.clear();
+	recorded_struct_layouts.clear();
+	bundle_recording = true;
+}
+
+void opencl::record_program_binary(const uint128& hash, const device_object* device, const string& binary) {
+	lock_guard<mutex> lock(bundle_lock);
+	recorded_binaries[hash] = make_pair(device, binary);
+}
+
+void opencl::record_struct_layout(const device_object* device, const string& layout) {
+	if(!bundle_recording) return;
+	lock_guard<mutex> lock(bundle_lock);
+	recorded_struct_layouts.emplace(device, layout);
+}
+
+const vector<string>& opencl::get_bundle_struct_layouts() const {
+	return bundle_struct_layouts;
+}
+
+bool opencl::write_kernel_bundle(const string& filename, const device_object* device) {
+	// make sure all internal kernels have been compiled
+	finish_internal_kernel_prefetch();
+	
+	lock_guard<mutex> lock(bundle_lock);
+	vector<const device_object*> bundle_devices;
+	unsigned int binary_count = 0;
+	for(const auto& binary : recorded_binaries) {
+		if(device != nullptr && binary.second.first != device) continue;
+		if(find(begin(bundle_devices), end(bundle_devices), binary.second.first) == end(bundle_devices)) {
+			bundle_devices.emplace_back(binary.second.first);
+		}
+		binary_count++;
+	}
+	if(binary_count == 0) {
+		oclr_error("no program binaries have been recorded for the kernel bundle!");
+		return false;
+	}
+	
+	file_io bundle_file(filename, file_io::OPEN_TYPE::WRITE_BINARY);
+	if(!bundle_file.is_open()) {
+		oclr_error("couldn't write kernel bundle \"%s\"!", filename);
+		return false;
+	}
+	bundle_file.write_block(kernel_bundle_magic, 8);
+	bundle_file.write_uint(kernel_bundle_version);
+	bundle_file.write_terminated_block(oclraster::get_version(), '\0');
+	bundle_file.write_uint((unsigned int)bundle_devices.size());
+	for(const auto& bundle_device : bundle_devices) {
+		bundle_file.write_terminated_block(bundle_device->name, '\0');
+		bundle_file.write_terminated_block(bundle_device->vendor, '\0');
+		bundle_file.write_terminated_block(bundle_device->version, '\0');
+		bundle_file.write_terminated_block(bundle_device->driver_version, '\0');
+	}
+	bundle_file.write_uint(binary_count);
+	for(const auto& binary : recorded_binaries) {
+		if(device != nullptr && binary.second.first != device) continue;
+		bundle_file.write_uint((unsigned int)(binary.first.first >> 32ull));
+		bundle_file.write_uint((unsigned int)(binary.first.first & 0xFFFFFFFFull));
+		bundle_file.write_uint((unsigned int)(binary.first.second >> 32ull));
+		bundle_file.write_uint((unsigned int)(binary.first.second & 0xFFFFFFFFull));
+		bundle_file.write_uint((unsigned int)binary.second.second.size());
+		bundle_file.write_block(binary.second.second.data(), binary.second.second.size());
+	}
+	unsigned int struct_layout_count = 0;
+	for(const auto& layout : recorded_struct_layouts) {
+		if(device != nullptr && layout.first != device) continue;
+		struct_layout_count++;
+	}
+	bundle_file.write_uint(struct_layout_count);
+	for(const auto& layout : recorded_struct_layouts) {
+		if(device != nullptr && layout.first != device) continue;
+		bundle_file.write_terminated_block(layout.second, '\0');
+	}
+	const bool success = bundle_file.good();
+	bundle_file.close();
+	if(!success) {
+		oclr_error("failed to write kernel bundle \"%s\"!", filename);
+		return false;
+	}
+	oclr_log("wrote kernel bundle \"%s\" (%u program binaries, %u struct layouts, %u devices)", filename,
+			 binary_count, struct_layout_count, bundle_devices.size());
+	return true;
+}
+
 void opencl::delete_kernel(weak_ptr<opencl::kernel_object> kernel_obj) {
 	auto kernel_ptr = kernel_obj.lock();
 	if(kernel_ptr == nullptr) {
@@ -1352,6 +2245,7 @@ void opencl::delete_kernel(weak_ptr<opencl::kernel_object> kernel_obj) {
 	for(const auto& kernel : kernels) {
 		if(kernel.second == kernel_ptr) {
 			kernel_object::unassociate_buffers(kernel_ptr);
+			untrack_kernel_dependencies(kernel.first);
 			kernels.erase(kernel.first);
 			if(kernel_ptr.use_count() > 1) {
 				oclr_error("kernel object (%X) use count > 1 (%u) - kernel object is still used somewhere!",
@@ -1979,27 +2873,8 @@ void opencl::run_kernel(weak_ptr<kernel_object> kernel_obj) {
 		functor->second();
 		//functor->second().wait();
 #else
-		auto evt = functor->second();
-		evt.wait();
-		const auto prof_queued = evt.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
-		const auto prof_submit = evt.getProfilingInfo<CL_PROFILING_COMMAND_SUBMIT>();
-		const auto prof_start = evt.getProfilingInfo<CL_PROFILING_COMMAND_START>();
-		const auto prof_end = evt.getProfilingInfo<CL_PROFILING_COMMAND_END>();
-		const auto ns_to_ms = [](const unsigned long long int& t) {
-			return ((double)t) / 1000000.0;
-		};
-		oclr_msg("profiling %s:\n"
-				 "\t%u (queued->submit), %u (submit->start), %u (start->end), %u (submit->end)\n"
-				 "\t%ums (queued->submit), %ums (submit->start), %ums (start->end), %ums (submit->end)",
-				 kernel_ptr->name,
-				 prof_submit - prof_queued,
-				 prof_start - prof_submit,
-				 prof_end - prof_start,
-				 prof_end - prof_submit,
-				 ns_to_ms(prof_submit - prof_queued),
-				 ns_to_ms(prof_start - prof_submit),
-				 ns_to_ms(prof_end - prof_start),
-				 ns_to_ms(prof_end - prof_submit));
+		// the profiling info is only queried at the end of the frame (-> end_profiling_frame)
+		record_profiling_event(functor->second(), kernel_ptr->name);
 #endif
 		
 		for(const auto& buffer_arg : kernel_ptr->buffer_args) {
@@ -2121,7 +2996,14 @@ void* __attribute__((aligned(128))) opencl::map_buffer(opencl::buffer_object* bu
 		
 		void* __attribute__((aligned(128))) map_ptr = nullptr;
 		if(buffer_obj->buffer != nullptr) {
+#if !defined(OCLRASTER_PROFILING)
 			map_ptr = queues[&active_device->device]->enqueueMapBuffer(*buffer_obj->buffer, blocking, map_flags, map_offset, map_size);
+#else
+			cl::Event evt;
+			map_ptr = queues[&active_device->device]->enqueueMapBuffer(*buffer_obj->buffer, blocking, map_flags, map_offset, map_size,
+																		nullptr, &evt);
+			record_profiling_event(evt, "map_buffer");
+#endif
 		}
 		else if(buffer_obj->image_buffer != nullptr) {
 			oclr_error("use map_image to map an image buffer object!");
@@ -2175,9 +3057,18 @@ void* __attribute__((aligned(128))) opencl::map_image(opencl_base::buffer_object
 		
 		void* __attribute__((aligned(128))) map_ptr = nullptr;
 		if(buffer_obj->image_buffer != nullptr) {
+#if !defined(OCLRASTER_PROFILING)
 			map_ptr = queues[&active_device->device]->enqueueMapImage(*buffer_obj->image_buffer, blocking, map_flags,
 																	  map_origin, map_region,
 																	  image_row_pitch, image_slice_pitch);
+#else
+			cl::Event evt;
+			map_ptr = queues[&active_device->device]->enqueueMapImage(*buffer_obj->image_buffer, blocking, map_flags,
+																	  map_origin, map_region,
+																	  image_row_pitch, image_slice_pitch,
+																	  nullptr, &evt);
+			record_profiling_event(evt, "map_image");
+#endif
 		}
 		else if(buffer_obj->buffer != nullptr) {
 			oclr_error("use map_buffer to map a buffer object!");
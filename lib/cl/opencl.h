@@ -26,6 +26,10 @@
 #include "core/gl_support.h"
 #include "hash/city.h"
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
 // necessary for now (when compiling with opencl 1.2+ headers)
 #define CL_USE_DEPRECATED_OPENCL_1_1_APIS 1
 
@@ -173,7 +177,16 @@ public:
 	virtual void init(bool use_platform_devices = false, const size_t platform_index = 0,
 					  const set<string> device_restriction = set<string> {},
 					  const bool gl_sharing = true) = 0;
-	void reload_kernels();
+	// full reload: rebuilds all internal kernels and invalidates all other kernels
+	// otherwise: only rebuilds the internal kernels whose source files (incl. all included kernel headers)
+	// have changed since they were compiled, all other kernels remain valid
+	// note: the emitted kernel_reload_event contains all changed files (-> kernel_depends_on)
+	void reload_kernels(const bool full_reload = false);
+	// returns true if the kernel was compiled from (or includes) any of the specified kernel files
+	// (file names are relative to the kernel path, e.g. "oclr_global.h")
+	bool kernel_depends_on(weak_ptr<kernel_object> kernel_obj, const set<string>& files);
+	// false if kernels can only be compiled on the thread that owns the context
+	bool has_parallel_kernel_compilation() const { return parallel_kernel_compilation; }
 	
 	// kernel execution
 	void use_kernel(const string& identifier);
@@ -202,6 +215,41 @@ public:
 	void delete_kernel(const string& identifier);
 	virtual void delete_kernel(weak_ptr<kernel_object> kernel_obj) = 0;
 	
+	// pipeline tuning parameters: bin and batch size are compiled into all internal and program kernels,
+	// the work-group sizes are used by the binning and rasterization stage (0 = max kernel work-group size).
+	// these are loaded from the tuning file (config: pipeline tuning_file) for the primary device on init
+	// note: after changing the bin or batch size, all kernels must be fully reloaded and all pipelines recreated
+	struct tuning_parameters {
+		unsigned int bin_size { OCLRASTER_BIN_SIZE };
+		unsigned int batch_size { OCLRASTER_BATCH_SIZE };
+		unsigned int rasterization_wg_size { 0 };
+		unsigned int binning_wg_size { 0 };
+	};
+	const tuning_parameters& get_tuning() const { return tuning; }
+	bool set_tuning(const tuning_parameters& params);
+	// build options that must be used for all kernels that are run by the pipeline (-DBIN_SIZE, -DBATCH_SIZE)
+	string get_tuning_options() const;
+	// applies the work-group size tuning parameter to the max work-group size of the current kernel
+	size_t get_tuned_work_group_size(const unsigned int tuned_wg_size) const;
+	// the device the tuning parameters apply to (the device that is made active on init)
+	const device_object* get_primary_device() const;
+	// stores the current tuning parameters for the primary device in the tuning file
+	bool save_tuning() const;
+	
+	// kernel bundles (-> oclr_bundle): precompiled program binaries of all internal and program kernels
+	// note: programs contained in a loaded bundle are never compiled from source, programs that aren't
+	// contained in it (other device/driver/source) are compiled from source as usual
+	virtual bool load_kernel_bundle(const string& filename) = 0;
+	// starts recording the binaries of all programs that are compiled or loaded from now on
+	virtual void record_kernel_bundle() = 0;
+	// writes all recorded binaries (only those of the specified device or of all devices if nullptr)
+	virtual bool write_kernel_bundle(const string& filename, const device_object* device = nullptr) = 0;
+	// struct layouts (-> oclraster_program) are bundled as well, so that the programs of a bundle don't have to
+	// be probed: layouts are recorded together with the binaries (one struct layout cache entry per layout) and
+	// the layouts of a loaded bundle are used to seed the struct layout cache
+	virtual void record_struct_layout(const device_object* device, const string& layout) = 0;
+	virtual const vector<string>& get_bundle_struct_layouts() const = 0;
+	
 	// create
 	virtual buffer_object* create_buffer(const BUFFER_FLAG type,
 										 const size_t size,
@@ -299,6 +347,9 @@ public:
 	//
 	void set_manual_gl_sharing(buffer_object* gl_buffer_obj, const bool state);
 	
+	// currently allocated buffer and image memory (in bytes, without sub-buffers and shared opengl objects)
+	size_t get_allocated_memory() const;
+	
 	const vector<cl::ImageFormat>& get_image_formats() const;
 	cl::ImageFormat get_image_format(const IMAGE_TYPE& data_type, const IMAGE_CHANNEL channel_type) const;
 	
@@ -402,6 +453,7 @@ public:
 		string extensions = "";
 		
 		cl_ulong max_alloc = 0;
+		size_t base_addr_align = 128; // in bytes (sub-buffer offsets must be a multiple of this)
 		size_t max_wg_size = 0;
 		size3 max_wi_sizes { 1, 1, 1 };
 		size2 max_img_2d { 0, 0 };
@@ -417,6 +469,49 @@ public:
 		return kernel_path_str + file_name;
 	}
 	
+	// profiling (only recorded when built with OCLRASTER_PROFILING, i.e. premake4 --cl-profiling, opencl only):
+	// all kernel launches and buffer/image maps are timed on the device and tagged with the current pipeline
+	// stage and draw index. the events of a frame are collected on end_profiling_frame (-> oclraster::stop_draw)
+	enum class PROFILING_STAGE : unsigned int {
+		TRANSFORM,
+		PROCESSING,
+		BINNING,
+		RASTERIZATION,
+		CLEAR,
+		FXAA,
+		SWAP_READBACK,
+		OTHER,
+		__MAX_PROFILING_STAGE
+	};
+	static const char* profiling_stage_to_string(const PROFILING_STAGE stage);
+	struct profiling_event {
+		string name;
+		PROFILING_STAGE stage;
+		unsigned int draw_index;
+		cl_ulong start; // device time in ns
+		cl_ulong end;
+	};
+	struct profiling_frame {
+		unsigned int frame_index { 0 };
+		array<double, (size_t)PROFILING_STAGE::__MAX_PROFILING_STAGE> stage_times {{}}; // in ms
+		vector<profiling_event> events;
+	};
+	// tags all following kernel launches with the specified stage, the previous stage is restored on destruction
+	class profiling_stage_scope {
+	public:
+		profiling_stage_scope(const PROFILING_STAGE stage);
+		~profiling_stage_scope();
+	protected:
+		const PROFILING_STAGE prev_stage;
+	};
+	// starts the next draw call (draw indices start at 1 every frame, 0 = not part of a draw call)
+	void next_profiling_draw();
+	void end_profiling_frame();
+	// the last completed frame (per-stage totals and all events)
+	const profiling_frame& get_profiling_frame() const;
+	// writes the last completed frames (up to max_profiling_frames) in the chrome trace event format
+	bool write_profiling_trace(const string& filename) const;
+	
 protected:
 	SDL_Window* sdl_wnd;
 	bool supported = true;
@@ -427,9 +522,40 @@ protected:
 	string kernel_path_str;
 	
 	virtual buffer_object* create_buffer_object(const BUFFER_FLAG type, const void* data = nullptr) = 0;
+	void load_tuning();
 	void load_internal_kernels();
 	void destroy_kernels();
 	void check_compilation(const bool ret, const string& filename);
+	
+	// internal kernels are compiled in parallel (if parallel_kernel_compilation is set): only the core pipeline
+	// kernels are compiled before init/reload returns, all others (see lazy_internal_kernels) are compiled on first
+	// use or prefetched in the background
+	enum class INTERNAL_KERNEL_STATE : unsigned int {
+		PENDING,
+		COMPILING,
+		DONE
+	};
+	bool parallel_kernel_compilation = true;
+	atomic<bool> internal_kernels_ready { true }; // set if all internal kernels have been compiled
+	mutex internal_kernels_lock;
+	condition_variable internal_kernels_cv;
+	unordered_map<string, INTERNAL_KERNEL_STATE> internal_kernel_states;
+	thread internal_kernel_prefetch;
+	void compile_internal_kernels(const vector<size_t>& kernel_indices);
+	void compile_internal_kernel(const size_t kernel_index);
+	void require_internal_kernel(const string& identifier);
+	void finish_internal_kernel_prefetch();
+	
+	// kernel dependency tracking: kernel identifier -> kernel files (relative to the kernel path),
+	// kernel file -> content hash (at the time the file was first used or the last reload)
+	mutex dependency_lock;
+	unordered_map<string, set<string>> kernel_dependencies;
+	unordered_map<string, uint64> kernel_file_hashes;
+	void track_kernel_dependencies(const string& identifier, const string& src, const string& file_name = "");
+	void untrack_kernel_dependencies(const string& identifier);
+	void collect_kernel_includes(const string& src, set<string>& includes) const;
+	set<string> find_changed_kernel_files();
+	void reload_changed_kernels();
 	virtual void log_program_binary(const shared_ptr<kernel_object> kernel) = 0;
 	
 	bool has_vendor_device(VENDOR vendor_type);
@@ -447,8 +573,8 @@ protected:
 	device_object* active_device;
 	device_object* fastest_cpu;
 	device_object* fastest_gpu;
-	cl_int ierr;
-	bool successful_internal_compilation;
+	cl_int ierr; // note: not thread-safe, must not be used by add_kernel_src (-> parallel compilation)
+	atomic<bool> successful_internal_compilation { true };
 	
 	vector<cl::ImageFormat> img_formats;
 	
@@ -464,6 +590,16 @@ protected:
 	// identifier -> <file_name, func_name, options>
 	vector<tuple<string, string, string, string>> internal_kernels;
 	
+	tuning_parameters tuning;
+	
+	PROFILING_STAGE profiling_stage { PROFILING_STAGE::OTHER };
+	unsigned int profiling_draw_index { 0 };
+	unsigned int profiling_frame_index { 0 };
+	vector<pair<cl::Event, profiling_event>> pending_profiling_events;
+	deque<profiling_frame> profiling_frames;
+	static constexpr size_t max_profiling_frames { 120 };
+	void record_profiling_event(const cl::Event& evt, const string& name);
+	
 };
 
 template<typename T> bool opencl_base::set_kernel_argument(const unsigned int& index, T&& arg) {
@@ -620,11 +756,34 @@ public:
 	virtual void acquire_gl_object(buffer_object* gl_buffer_obj);
 	virtual void release_gl_object(buffer_object* gl_buffer_obj);
 	
+	virtual bool load_kernel_bundle(const string& filename);
+	virtual void record_kernel_bundle();
+	virtual bool write_kernel_bundle(const string& filename, const device_object* device = nullptr);
+	virtual void record_struct_layout(const device_object* device, const string& layout);
+	virtual const vector<string>& get_bundle_struct_layouts() const;
+	
 protected:
 	virtual buffer_object* create_buffer_object(const BUFFER_FLAG type, const void* data = nullptr);
 	virtual void log_program_binary(const shared_ptr<kernel_object> kernel);
 	virtual string error_code_to_string(cl_int error_code) const;
 	
+	// program binary cache (data/cache/*.clbin): one binary per program and device, keyed by the program source
+	// (incl. all included kernel headers), build options, platform, device and driver version
+	string cache_path = "";
+	uint128 compute_program_hash(const string& src, const string& options, const device_object* device) const;
+	void append_include_sources(const string& src, string& hash_src, set<string>& included) const;
+	bool read_program_binary(const uint128& hash, string& binary) const;
+	void write_program_binaries(const cl::Program& program, const vector<uint128>& hashes);
+	
+	// kernel bundle: loaded binaries take precedence over the binary cache
+	map<uint128, string> bundle_binaries;
+	atomic<bool> bundle_recording { false };
+	mutex bundle_lock;
+	map<uint128, pair<const device_object*, string>> recorded_binaries;
+	void record_program_binary(const uint128& hash, const device_object* device, const string& binary);
+	vector<string> bundle_struct_layouts;
+	set<pair<const device_object*, string>> recorded_struct_layouts;
+	
 };
 
 #if defined(OCLRASTER_CUDA_CL)
@@ -758,6 +917,13 @@ public:
 	virtual void acquire_gl_object(buffer_object* gl_buffer_obj);
 	virtual void release_gl_object(buffer_object* gl_buffer_obj);
 	
+	// not supported with cuda (-> uses its own ptx cache)
+	virtual bool load_kernel_bundle(const string& filename);
+	virtual void record_kernel_bundle();
+	virtual bool write_kernel_bundle(const string& filename, const device_object* device = nullptr);
+	virtual void record_struct_layout(const device_object* device, const string& layout);
+	virtual const vector<string>& get_bundle_struct_layouts() const;
+	
 protected:
 	bool valid = true;
 	string cache_path = "";
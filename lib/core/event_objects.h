@@ -184,7 +184,13 @@ typedef touch_move_event_base<EVENT_TYPE::FINGER_MOVE> finger_move_event;
 
 // misc
 typedef event_object_base<EVENT_TYPE::QUIT> quit_event;
-typedef event_object_base<EVENT_TYPE::KERNEL_RELOAD> kernel_reload_event;
+struct kernel_reload_event : public event_object_base<EVENT_TYPE::KERNEL_RELOAD> {
+	// full reload: all kernels are invalid, otherwise only kernels depending on a changed file (-> kernel_depends_on)
+	const bool full_reload;
+	const set<string> changed_files; // relative to the kernel path
+	kernel_reload_event(const unsigned int& time_, const bool full_reload_, const set<string>& changed_files_) :
+	event_object_base(time_), full_reload(full_reload_), changed_files(changed_files_) {}
+};
 
 struct clipboard_update_event : public event_object_base<EVENT_TYPE::CLIPBOARD_UPDATE> {
 	const string text;
@@ -17,6 +17,9 @@
  */
 
 #include "file_io.h"
+#if !defined(__WINDOWS__)
+#include <sys/stat.h>
+#endif
 
 /*! there is no function currently
  */
@@ -369,3 +372,12 @@ bool file_io::string_to_file(const string& filename, string& str) {
 	file.close();
 	return true;
 }
+
+bool file_io::create_directory(const string& dirname) {
+#if defined(__WINDOWS__)
+	if(_mkdir(dirname.c_str()) == 0) return true;
+#else
+	if(mkdir(dirname.c_str(), 0755) == 0) return true;
+#endif
+	return (errno == EEXIST);
+}
@@ -53,6 +53,8 @@ public:
 	static bool file_to_string(const string& filename, string& str);
 	static string file_to_string(const string& filename);
 	static bool string_to_file(const string& filename, string& str);
+	// creates the directory (the parent directory must exist), returns true if it exists afterwards
+	static bool create_directory(const string& dirname);
 
 	bool open(const string& filename, OPEN_TYPE open_type);
 	void close();
@@ -21,6 +21,7 @@
 #include "core/gl_support.h"
 #include "pipeline/framebuffer.h"
 #include "pipeline/pipeline.h"
+#include "pipeline/autotuner.h"
 
 #if defined(__APPLE__)
 #if !defined(OCLRASTER_IOS)
@@ -52,11 +53,15 @@ unsigned int oclraster::frame_time_sum = 0;
 unsigned int oclraster::frame_time_counter = 0;
 bool oclraster::new_fps_count = false;
 
+unsigned long long int oclraster::init_start_time = 0;
+bool oclraster::first_frame_done = false;
+
 bool oclraster::cursor_visible = true;
 
 event::handler* oclraster::event_handler_fnctr = nullptr;
 
 atomic<bool> oclraster::reload_kernels_flag { false };
+atomic<bool> oclraster::reload_kernels_full { false };
 
 #if defined(OCLRASTER_INTERNAL_PROGRAM_DEBUG)
 // from transform_program.cpp and rasterization_program.cpp for debugging purposes:
@@ -82,7 +87,8 @@ BOOL APIENTRY DllMain(HANDLE hModule oclr_unused, DWORD ul_reason_for_call, LPVO
 /*! this is used to set an absolute data path depending on call path (path from where the binary is called/started),
  *! which is mostly needed when the binary is opened via finder under os x or any file manager under linux
  */
-void oclraster::init(const char* callpath_, const char* datapath_) {
+void oclraster::init(const char* callpath_, const char* datapath_, const bool headless) {
+	init_start_time = SDL_GetPerformanceCounter();
 	logger::init();
 	
 	oclraster::callpath = callpath_;
@@ -207,6 +213,9 @@ void oclraster::init(const char* callpath_, const char* datapath_) {
 		config.clear_cache = config_doc.get<bool>("config.opencl.clear_cache", false);
 		config.gl_sharing = config_doc.get<bool>("config.opencl.gl_sharing", true);
 		config.log_binaries = config_doc.get<bool>("config.opencl.log_binaries", false);
+		config.clear_program_cache = config_doc.get<bool>("config.opencl.clear_program_cache", false);
+		config.kernel_bundle = config_doc.get<string>("config.opencl.bundle", "");
+		config.trimmed_image_support = config_doc.get<bool>("config.opencl.trimmed_image_support", true);
 		const auto cl_dev_tokens(core::tokenize(config_doc.get<string>("config.opencl.restrict", ""), ','));
 		for(const auto& dev_token : cl_dev_tokens) {
 			if(dev_token == "") continue;
@@ -219,10 +228,23 @@ void oclraster::init(const char* callpath_, const char* datapath_) {
 		config.cuda_keep_temp = config_doc.get<bool>("config.cuda.keep_temp", false);
 		config.cuda_keep_binaries = config_doc.get<bool>("config.cuda.keep_binaries", true);
 		config.cuda_use_cache = config_doc.get<bool>("config.cuda.use_cache", true);
+		
+		config.draw_memory_budget = config_doc.get<size_t>("config.pipeline.draw_memory_budget", 512);
+		config.binning = config_doc.get<string>("config.pipeline.binning", "gather");
+		config.coarse_binning_threshold = (unsigned int)config_doc.get<size_t>("config.pipeline.coarse_binning_threshold", 1024);
+		config.kernel_spec_warmup = config_doc.get<bool>("config.pipeline.kernel_spec_warmup", false);
+		config.preprocess_cache = config_doc.get<bool>("config.pipeline.preprocess_cache", false);
+		config.tuning_file = config_doc.get<string>("config.pipeline.tuning_file", "tuning.txt");
+		config.autotune = config_doc.get<bool>("config.pipeline.autotune", false);
+		
+		config.headless = config_doc.get<bool>("config.screen.headless", false);
 	}
+	if(headless) config.headless = true;
 	
 	//
 	init_internal();
+	oclr_log("init done (%fms)",
+			 double(SDL_GetPerformanceCounter() - init_start_time) * 1000.0 / double(SDL_GetPerformanceFrequency()));
 }
 
 void oclraster::destroy() {
@@ -247,9 +269,11 @@ void oclraster::destroy() {
 
 	oclr_debug("oclraster destroyed!");
 	
-	SDL_GL_DeleteContext(config.ctx);
-	SDL_DestroyWindow(config.wnd);
-	SDL_Quit();
+	if(!config.headless) {
+		SDL_GL_DeleteContext(config.ctx);
+		SDL_DestroyWindow(config.wnd);
+		SDL_Quit();
+	}
 	
 	logger::destroy();
 }
@@ -257,6 +281,67 @@ void oclraster::destroy() {
 void oclraster::init_internal() {
 	oclr_debug("initializing oclraster");
 
+	// create the window and opengl context (neither exists in headless mode)
+	if(!config.headless) {
+		init_window();
+	}
+	else {
+		oclr_debug("headless mode: no window or opengl context is created");
+		config.gl_sharing = false;
+	}
+	
+	acquire_context();
+	
+	if(!config.headless) {
+		// initialize opengl functions (get function pointers) on non-apple platforms
+#if !defined(__APPLE__)
+		init_gl_funcs();
+#endif
+		
+		// on iOS/GLES we need a simple "blit shader" to draw the opencl framebuffer
+#if defined(OCLRASTER_IOS)
+		ios_helper::compile_shaders();
+#endif
+	}
+	
+	// check if a cudacl or pure opencl context should be created
+	// use absolute path
+#if defined(OCLRASTER_CUDA_CL)
+	if(config.opencl_platform == "cuda") {
+		ocl = new cudacl(core::strip_path(string(datapath + kernelpath)).c_str(), config.wnd, config.clear_cache);
+	}
+	else {
+#else
+		if(config.opencl_platform == "cuda") {
+			oclr_error("CUDA support is not enabled!");
+		}
+#endif
+		ocl = new opencl(core::strip_path(string(datapath + kernelpath)).c_str(), config.wnd, config.clear_cache);
+#if defined(OCLRASTER_CUDA_CL)
+	}
+#endif
+	
+	if(!config.headless) {
+		init_window_gl();
+	}
+	
+	// set dpi lower bound to 72
+	if(config.dpi < 72) config.dpi = 72;
+	
+	// init opencl
+	ocl->init(false,
+			  config.opencl_platform == "cuda" ? 0 : string2size_t(config.opencl_platform),
+			  config.cl_device_restriction, config.gl_sharing);
+	
+	// benchmark and store the pipeline tuning parameters of the primary device
+	if(config.autotune) {
+		autotuner::run();
+	}
+	
+	release_context();
+}
+
+void oclraster::init_window() {
 	// in order to use multi-threaded opengl with x11/xlib, we have to tell it to actually be thread safe
 #if !defined(__APPLE__) && !defined(__WINDOWS__)
 	if(XInitThreads() == 0) {
@@ -378,36 +463,9 @@ void oclraster::init_internal() {
 	}
 #endif
 #endif
-	
-	acquire_context();
-	
-	// initialize opengl functions (get function pointers) on non-apple platforms
-#if !defined(__APPLE__)
-	init_gl_funcs();
-#endif
-	
-	// on iOS/GLES we need a simple "blit shader" to draw the opencl framebuffer
-#if defined(OCLRASTER_IOS)
-	ios_helper::compile_shaders();
-#endif
-	
-	// check if a cudacl or pure opencl context should be created
-	// use absolute path
-#if defined(OCLRASTER_CUDA_CL)
-	if(config.opencl_platform == "cuda") {
-		ocl = new cudacl(core::strip_path(string(datapath + kernelpath)).c_str(), config.wnd, config.clear_cache);
-	}
-	else {
-#else
-		if(config.opencl_platform == "cuda") {
-			oclr_error("CUDA support is not enabled!");
-		}
-#endif
-		ocl = new opencl(core::strip_path(string(datapath + kernelpath)).c_str(), config.wnd, config.clear_cache);
-#if defined(OCLRASTER_CUDA_CL)
-	}
-#endif
-	
+}
+
+void oclraster::init_window_gl() {
 	// make an early clear
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -472,16 +530,6 @@ void oclraster::init_internal() {
 		}
 #endif
 	}
-	
-	// set dpi lower bound to 72
-	if(config.dpi < 72) config.dpi = 72;
-	
-	// init opencl
-	ocl->init(false,
-			  config.opencl_platform == "cuda" ? 0 : string2size_t(config.opencl_platform),
-			  config.cl_device_restriction, config.gl_sharing);
-	
-	release_context();
 }
 
 /*! sets the windows width
@@ -490,6 +538,10 @@ void oclraster::init_internal() {
 void oclraster::set_width(const unsigned int& width) {
 	if(width == config.width) return;
 	config.width = width;
+	if(config.headless) {
+		resize_headless();
+		return;
+	}
 	SDL_SetWindowSize(config.wnd, (int)config.width, (int)config.height);
 	// TODO: make this work:
 	/*SDL_SetWindowPosition(config.wnd,
@@ -503,6 +555,10 @@ void oclraster::set_width(const unsigned int& width) {
 void oclraster::set_height(const unsigned int& height) {
 	if(height == config.height) return;
 	config.height = height;
+	if(config.headless) {
+		resize_headless();
+		return;
+	}
 	SDL_SetWindowSize(config.wnd, (int)config.width, (int)config.height);
 	// TODO: make this work:
 	/*SDL_SetWindowPosition(config.wnd,
@@ -514,6 +570,10 @@ void oclraster::set_screen_size(const uint2& screen_size) {
 	if(screen_size.x == config.width && screen_size.y == config.height) return;
 	config.width = screen_size.x;
 	config.height = screen_size.y;
+	if(config.headless) {
+		resize_headless();
+		return;
+	}
 	SDL_SetWindowSize(config.wnd, (int)config.width, (int)config.height);
 	
 	SDL_Rect bounds;
@@ -530,6 +590,7 @@ void oclraster::set_screen_size(const uint2& screen_size) {
 void oclraster::set_fullscreen(const bool& state) {
 	if(state == config.fullscreen) return;
 	config.fullscreen = state;
+	if(config.headless) return;
 	if(SDL_SetWindowFullscreen(config.wnd, (SDL_bool)state) != 0) {
 		oclr_error("failed to %s fullscreen: %s!",
 				  (state ? "enable" : "disable"), SDL_GetError());
@@ -540,9 +601,17 @@ void oclraster::set_fullscreen(const bool& state) {
 	// TODO: border?
 }
 
+void oclraster::resize_headless() {
+	// there is no window that could send a resize event -> send it directly
+	evt->add_event(EVENT_TYPE::WINDOW_RESIZE,
+				   make_shared<window_resize_event>(SDL_GetTicks(),
+													size2(config.width, config.height)));
+}
+
 void oclraster::set_vsync(const bool& state) {
 	if(state == config.vsync) return;
 	config.vsync = state;
+	if(config.headless) return;
 #if !defined(OCLRASTER_IOS)
 	SDL_GL_SetSwapInterval(config.vsync ? 1 : 0);
 #endif
@@ -552,6 +621,7 @@ void oclraster::set_vsync(const bool& state) {
  */
 void oclraster::start_draw() {
 	acquire_context();
+	if(config.headless) return;
 	
 	// draws ogl stuff
 	glBindFramebuffer(GL_FRAMEBUFFER, OCLRASTER_DEFAULT_FRAMEBUFFER);
@@ -569,8 +639,15 @@ void oclraster::stop_draw() {
 		active_pipeline->swap();
 	}
 	swap();
+	ocl->end_profiling_frame();
+	
+	if(!first_frame_done) {
+		first_frame_done = true;
+		oclr_log("time to first frame: %fms",
+				 double(SDL_GetPerformanceCounter() - init_start_time) * 1000.0 / double(SDL_GetPerformanceFrequency()));
+	}
 	
-	GLenum error = glGetError();
+	const GLenum error = (!config.headless ? glGetError() : GL_NO_ERROR);
 	switch(error) {
 		case GL_NO_ERROR:
 			break;
@@ -614,7 +691,7 @@ void oclraster::stop_draw() {
 		reload_kernels_flag = false;
 		ocl->flush();
 		ocl->finish();
-		ocl->reload_kernels();
+		ocl->reload_kernels(reload_kernels_full);
 	}
 	
 	release_context();
@@ -624,12 +701,17 @@ void oclraster::stop_draw() {
  *  @param caption the window caption
  */
 void oclraster::set_caption(const string& caption) {
+	if(config.headless) {
+		config.caption = caption;
+		return;
+	}
 	SDL_SetWindowTitle(config.wnd, caption.c_str());
 }
 
 /*! returns the window caption
  */
 const char* oclraster::get_caption() {
+	if(config.headless) return config.caption.c_str();
 	return SDL_GetWindowTitle(config.wnd);
 }
 
@@ -652,6 +734,8 @@ void oclraster::init_gl() {
 /* function to reset our viewport after a window resize
  */
 void oclraster::resize_window() {
+	if(config.headless) return;
+	
 	// set the viewport
 	glViewport(0, 0, (GLsizei)config.width, (GLsizei)config.height);
 }
@@ -661,6 +745,7 @@ void oclraster::resize_window() {
  */
 void oclraster::set_cursor_visible(const bool& state) {
 	oclraster::cursor_visible = state;
+	if(config.headless) return;
 	SDL_ShowCursor(oclraster::cursor_visible);
 }
 
@@ -789,10 +874,12 @@ const string oclraster::get_version() {
 }
 
 void oclraster::swap() {
+	if(config.headless) return;
 	SDL_GL_SwapWindow(config.wnd);
 }
 
-void oclraster::reload_kernels() {
+void oclraster::reload_kernels(const bool full_reload) {
+	reload_kernels_full = full_reload;
 	reload_kernels_flag = true;
 }
 
@@ -827,7 +914,7 @@ void oclraster::acquire_context() {
 	// note: not a race, since there can only be one active gl thread
 	const unsigned int cur_active_locks = config.ctx_active_locks++;
 	if(cur_active_locks == 0) {
-		if(SDL_GL_MakeCurrent(config.wnd, config.ctx) != 0) {
+		if(!config.headless && SDL_GL_MakeCurrent(config.wnd, config.ctx) != 0) {
 			oclr_error("couldn't make gl context current: %s!", SDL_GetError());
 			return;
 		}
@@ -836,7 +923,7 @@ void oclraster::acquire_context() {
 		}
 	}
 #if defined(OCLRASTER_IOS)
-	glBindFramebuffer(GL_FRAMEBUFFER, OCLRASTER_DEFAULT_FRAMEBUFFER);
+	if(!config.headless) glBindFramebuffer(GL_FRAMEBUFFER, OCLRASTER_DEFAULT_FRAMEBUFFER);
 #endif
 }
 
@@ -848,7 +935,7 @@ void oclraster::release_context() {
 			ocl->finish();
 			ocl->deactivate_context();
 		}
-		if(SDL_GL_MakeCurrent(config.wnd, nullptr) != 0) {
+		if(!config.headless && SDL_GL_MakeCurrent(config.wnd, nullptr) != 0) {
 			oclr_error("couldn't release current gl context: %s!", SDL_GetError());
 			return;
 		}
@@ -865,6 +952,7 @@ bool oclraster::event_handler(EVENT_TYPE type, shared_ptr<event_object> obj) {
 		return true;
 	}
 	else if(type == EVENT_TYPE::KERNEL_RELOAD) {
+		const kernel_reload_event& reload_evt = (const kernel_reload_event&)*obj;
 #if defined(OCLRASTER_INTERNAL_PROGRAM_DEBUG)
 		template_transform_program = file_io::file_to_string(data_path("kernels/template_transform_program.cl"));
 		if(template_transform_program == "") {
@@ -876,8 +964,14 @@ bool oclraster::event_handler(EVENT_TYPE type, shared_ptr<event_object> obj) {
 		}
 #endif
 		
-		// deletes all framebuffer clear kernels
-		delete_clear_kernels();
+		// oclr_image_support.h might have changed -> re-read the image support sections on the next compilation
+		if(reload_evt.full_reload || reload_evt.changed_files.count("oclr_image_support.h") > 0) {
+			oclraster_program::invalidate_image_support_sections();
+		}
+		
+		// deletes all framebuffer clear kernels (full reload) or only the ones affected by the changed files
+		if(reload_evt.full_reload) delete_clear_kernels();
+		else delete_clear_kernels(reload_evt.changed_files);
 		
 		return true;
 	}
@@ -894,6 +988,7 @@ const float& oclraster::get_upscaling() {
 
 float oclraster::get_scale_factor() {
 #if defined(__APPLE__) && !defined(OCLRASTER_IOS)
+	if(config.headless) return config.upscaling;
 	return osx_helper::get_scale_factor(config.wnd);
 #else
 	return config.upscaling; // TODO: get this from somewhere ...
@@ -908,6 +1003,18 @@ bool oclraster::get_log_binaries() {
 	return config.log_binaries;
 }
 
+bool oclraster::get_clear_program_cache() {
+	return config.clear_program_cache;
+}
+
+const string& oclraster::get_kernel_bundle() {
+	return config.kernel_bundle;
+}
+
+bool oclraster::get_trimmed_image_support() {
+	return config.trimmed_image_support;
+}
+
 void oclraster::set_active_pipeline(pipeline* active_pipeline_) {
 	active_pipeline = active_pipeline_;
 }
@@ -939,3 +1046,35 @@ bool oclraster::get_cuda_keep_binaries() {
 bool oclraster::get_cuda_use_cache() {
 	return config.cuda_use_cache;
 }
+
+size_t oclraster::get_draw_memory_budget() {
+	return config.draw_memory_budget;
+}
+
+const string& oclraster::get_binning() {
+	return config.binning;
+}
+
+unsigned int oclraster::get_coarse_binning_threshold() {
+	return config.coarse_binning_threshold;
+}
+
+bool oclraster::get_kernel_spec_warmup() {
+	return config.kernel_spec_warmup;
+}
+
+bool oclraster::get_preprocess_cache() {
+	return config.preprocess_cache;
+}
+
+const string& oclraster::get_tuning_file() {
+	return config.tuning_file;
+}
+
+bool oclraster::get_autotune() {
+	return config.autotune;
+}
+
+bool oclraster::is_headless() {
+	return config.headless;
+}
@@ -35,7 +35,9 @@ class pipeline;
 
 class OCLRASTER_API oclraster {
 public:
-	static void init(const char* callpath_, const char* datapath_);
+	// headless: no window and no opengl context are created (the same as setting config screen headless),
+	// the default framebuffer is then only accessible via the pipeline (see pipeline::set_frame_callback)
+	static void init(const char* callpath_, const char* datapath_, const bool headless = false);
 	static void destroy();
 	
 	static void set_active_pipeline(pipeline* active_pipeline);
@@ -68,7 +70,9 @@ public:
 	static string kernel_path(const string& str);
 	static string strip_data_path(const string& str);
 	
-	static void reload_kernels();
+	// reloads all kernels on the next frame: a full reload rebuilds everything, otherwise only kernels that
+	// depend on a changed kernel file are rebuilt (see kernel_reload_event)
+	static void reload_kernels(const bool full_reload = false);
 	
 	static void acquire_context();
 	static void release_context();
@@ -82,7 +86,8 @@ public:
 	static xml::xml_doc& get_config_doc();
 	
 	// screen/window
-	static SDL_Window* get_window();
+	static SDL_Window* get_window(); // nullptr in headless mode
+	static bool is_headless();
 	static unsigned int get_width();
 	static unsigned int get_height();
 	static uint2 get_screen_size();
@@ -113,6 +118,9 @@ public:
 	// opencl
 	static bool get_gl_sharing();
 	static bool get_log_binaries();
+	static bool get_clear_program_cache();
+	static const string& get_kernel_bundle();
+	static bool get_trimmed_image_support();
 	
 	// cuda
 	static const string& get_cuda_base_dir();
@@ -122,6 +130,15 @@ public:
 	static bool get_cuda_keep_binaries();
 	static bool get_cuda_use_cache();
 	
+	// pipeline
+	static size_t get_draw_memory_budget(); // in MB
+	static const string& get_binning(); // "gather" or "scatter"
+	static unsigned int get_coarse_binning_threshold(); // in bins
+	static bool get_kernel_spec_warmup();
+	static bool get_preprocess_cache();
+	static const string& get_tuning_file();
+	static bool get_autotune();
+	
 protected:
 	oclraster(const char* callpath_, const char* datapath_) = delete;
 	~oclraster() = delete;
@@ -132,11 +149,16 @@ protected:
 	static pipeline* active_pipeline;
 	
 	static void init_internal();
+	static void init_window();
+	static void init_window_gl();
+	static void resize_headless();
 	
 	static struct oclraster_config {
 		// screen
 		size_t width = 1280, height = 720, dpi = 0;
 		bool fullscreen = false, vsync = false;
+		bool headless = false;
+		string caption = "oclraster"; // only used in headless mode
 		
 		// projection
 		float fov = 72.0f;
@@ -152,9 +174,12 @@ protected:
 		// opencl
 		string opencl_platform = "0";
 		bool clear_cache = false;
+		bool clear_program_cache = false;
 		bool gl_sharing = true;
 		bool log_binaries = false;
 		set<string> cl_device_restriction;
+		string kernel_bundle = "";
+		bool trimmed_image_support = true;
 		
 		// cuda
 		string cuda_base_dir = "/usr/local/cuda";
@@ -163,6 +188,15 @@ protected:
 		bool cuda_keep_temp = false;
 		bool cuda_keep_binaries = true;
 		bool cuda_use_cache = true;
+		
+		// pipeline
+		size_t draw_memory_budget = 512;
+		string binning = "gather";
+		unsigned int coarse_binning_threshold = 1024;
+		bool kernel_spec_warmup = false;
+		bool preprocess_cache = false;
+		string tuning_file = "tuning.txt";
+		bool autotune = false;
 
 		// sdl
 		SDL_Window* wnd = nullptr;
@@ -190,6 +224,10 @@ protected:
 	static unsigned int frame_time_counter;
 	static bool new_fps_count;
 	
+	// startup timing (-> time to first frame)
+	static unsigned long long int init_start_time;
+	static bool first_frame_done;
+	
 	// cursor
 	static bool cursor_visible;
 	
@@ -199,6 +237,7 @@ protected:
 	
 	// misc
 	static atomic<bool> reload_kernels_flag;
+	static atomic<bool> reload_kernels_full;
 
 };
 
@@ -0,0 +1,259 @@
+/*
+ *  Flexible OpenCL Rasterizer (oclraster)
+ *  Copyright (C) 2012 - 2013 Florian Ziesche
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License only.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "autotuner.h"
+#include "oclraster.h"
+#include "pipeline/pipeline.h"
+#include "pipeline/framebuffer.h"
+#include "program/transform_program.h"
+#include "program/rasterization_program.h"
+
+// candidates (see opencl_base::set_tuning for the valid bin and batch sizes)
+static const vector<unsigned int> bin_size_candidates { 16, 32, 64 };
+static const vector<unsigned int> batch_size_candidates { 128, 256 };
+static const vector<unsigned int> wg_size_candidates { 0, 1, 16, 32, 64, 128, 256 }; // 0 = max kernel wg size
+
+// framebuffer size and #timed frames per scene
+static constexpr unsigned int tuning_width { 1280 };
+static constexpr unsigned int tuning_height { 720 };
+static constexpr unsigned int tuning_iterations { 8 };
+
+static constexpr char tuning_transform_program[] { u8R"OCLRASTER_RAWSTR(
+	oclraster_in tuning_input {
+		float4 vertex;
+	} input_attributes;
+	
+	oclraster_out tuning_output {
+		float4 color;
+	} output_attributes;
+	
+	float4 transform_main() {
+		output_attributes->color = (float4)(input_attributes->vertex.z, 0.5f, 1.0f - input_attributes->vertex.z, 1.0f);
+		return input_attributes->vertex;
+	}
+)OCLRASTER_RAWSTR" };
+
+static constexpr char tuning_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
+	oclraster_out tuning_output {
+		float4 color;
+	} output_attributes;
+	
+	oclraster_framebuffer {
+		image2d color;
+		depth_image depth;
+	};
+	
+	bool rasterize_main() {
+		framebuffer->color = output_attributes->color;
+		return true;
+	}
+)OCLRASTER_RAWSTR" };
+
+vector<autotuner::synthetic_scene> autotuner::create_scenes() {
+	// triangle count, triangle size (in pixels), all scenes are rendered orthographically
+	static const vector<tuple<string, unsigned int, float>> scene_setups {
+		make_tuple("small triangles", 65536u, 4.0f),
+		make_tuple("medium triangles", 4096u, 48.0f),
+		make_tuple("large overlapping triangles", 256u, 480.0f),
+	};
+	
+	// fixed seed -> the same scenes on every run
+	mt19937 gen { 0x0C1Bu };
+	const float aspect_ratio = float(tuning_width) / float(tuning_height);
+	uniform_real_distribution<float> x_dist(0.0f, aspect_ratio);
+	uniform_real_distribution<float> y_dist(0.0f, 1.0f);
+	uniform_real_distribution<float> z_dist(0.1f, 0.9f);
+	uniform_real_distribution<float> offset_dist(-0.5f, 0.5f);
+	
+	vector<synthetic_scene> scenes;
+	for(const auto& setup : scene_setups) {
+		const unsigned int triangle_count = get<1>(setup);
+		const float triangle_size = get<2>(setup) / float(tuning_height);
+		
+		vector<float4> vertices;
+		vector<index3> indices;
+		vertices.reserve(triangle_count * 3);
+		indices.reserve(triangle_count * 2);
+		for(unsigned int i = 0; i < triangle_count; i++) {
+			const float2 center { x_dist(gen), y_dist(gen) };
+			const float depth = z_dist(gen);
+			const unsigned int first_index = (unsigned int)vertices.size();
+			for(unsigned int j = 0; j < 3; j++) {
+				const float2 offset { offset_dist(gen), offset_dist(gen) };
+				vertices.emplace_back(center.x + offset.x * triangle_size,
+									  center.y + offset.y * triangle_size,
+									  depth, 1.0f);
+			}
+			// add both windings, so that exactly one of them passes backface culling
+			indices.emplace_back(first_index, first_index + 1, first_index + 2);
+			indices.emplace_back(first_index, first_index + 2, first_index + 1);
+		}
+		
+		synthetic_scene scene;
+		scene.name = get<0>(setup);
+		scene.vertex_count = (unsigned int)vertices.size();
+		scene.triangle_count = (unsigned int)indices.size();
+		scene.vertex_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ |
+												 opencl::BUFFER_FLAG::INITIAL_COPY |
+												 opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
+												 sizeof(float4) * vertices.size(),
+												 (void*)&vertices[0]);
+		scene.index_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ |
+												opencl::BUFFER_FLAG::INITIAL_COPY |
+												opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
+												sizeof(index3) * indices.size(),
+												(void*)&indices[0]);
+		scenes.emplace_back(scene);
+	}
+	return scenes;
+}
+
+void autotuner::destroy_scenes(vector<synthetic_scene>& scenes) {
+	for(auto& scene : scenes) {
+		if(scene.vertex_buffer != nullptr) ocl->delete_buffer(scene.vertex_buffer);
+		if(scene.index_buffer != nullptr) ocl->delete_buffer(scene.index_buffer);
+	}
+	scenes.clear();
+}
+
+double autotuner::benchmark(const opencl::tuning_parameters& params, const bool reload_kernels,
+							const vector<synthetic_scene>& scenes) {
+	if(!ocl->set_tuning(params)) return -1.0;
+	if(reload_kernels) {
+		// bin and batch size are compiled into all kernels
+		ocl->reload_kernels(true);
+	}
+	
+	// the pipeline picks up the bin and batch size on creation
+	pipeline* p = new pipeline();
+	framebuffer fb = framebuffer::create_with_images(tuning_width, tuning_height,
+													 {{ IMAGE_TYPE::UINT_8, IMAGE_CHANNEL::RGBA }},
+													 { IMAGE_TYPE::FLOAT_32, IMAGE_CHANNEL::R });
+	transform_program* tp = new transform_program(tuning_transform_program, "transform_main");
+	rasterization_program* rp = new rasterization_program(tuning_rasterization_program, "rasterize_main");
+	
+	double time_sum = -1.0;
+	if(tp->is_valid() && rp->is_valid()) {
+		p->bind_framebuffer(&fb);
+		p->start_orthographic_rendering();
+		p->bind_program(*tp);
+		p->bind_program(*rp);
+		
+		time_sum = 0.0;
+		for(const auto& scene : scenes) {
+			p->bind_buffer("index_buffer", *scene.index_buffer);
+			p->bind_buffer("input_attributes", *scene.vertex_buffer);
+			
+			// the first frame also compiles the kernel specialization
+			fb.clear();
+			p->draw(PRIMITIVE_TYPE::TRIANGLE, scene.vertex_count, { 0, scene.triangle_count });
+			ocl->finish();
+			
+			const auto start_time = SDL_GetPerformanceCounter();
+			for(unsigned int i = 0; i < tuning_iterations; i++) {
+				fb.clear();
+				p->draw(PRIMITIVE_TYPE::TRIANGLE, scene.vertex_count, { 0, scene.triangle_count });
+			}
+			ocl->finish();
+			time_sum += (double(SDL_GetPerformanceCounter() - start_time) * 1000.0 /
+						 double(SDL_GetPerformanceFrequency()) / double(tuning_iterations));
+		}
+		p->bind_framebuffer(nullptr);
+	}
+	else oclr_error("failed to create the tuning programs!");
+	
+	delete tp;
+	delete rp;
+	framebuffer::destroy_images(fb);
+	delete p;
+	
+	if(time_sum >= 0.0) {
+		oclr_debug("bin size %u, batch size %u, work-group sizes %u/%u: %fms",
+				   params.bin_size, params.batch_size, params.rasterization_wg_size, params.binning_wg_size, time_sum);
+	}
+	return time_sum;
+}
+
+bool autotuner::run() {
+	const opencl::device_object* device = ocl->get_primary_device();
+	if(device == nullptr) {
+		oclr_error("no device to tune!");
+		return false;
+	}
+	oclr_log("autotuning pipeline parameters for %s (%s) ...", device->name, device->driver_version);
+	
+	vector<synthetic_scene> scenes = create_scenes();
+	const opencl::tuning_parameters initial_params = ocl->get_tuning();
+	opencl::tuning_parameters best_params = initial_params;
+	double best_time = -1.0;
+	const auto try_params = [&](const opencl::tuning_parameters& params, const bool reload_kernels) {
+		const double time = benchmark(params, reload_kernels, scenes);
+		if(time >= 0.0 && (best_time < 0.0 || time < best_time)) {
+			best_time = time;
+			best_params = params;
+		}
+	};
+	
+	// bin and batch size (using the current work-group sizes)
+	for(const auto& bin_size : bin_size_candidates) {
+		for(const auto& batch_size : batch_size_candidates) {
+			opencl::tuning_parameters params = initial_params;
+			params.bin_size = bin_size;
+			params.batch_size = batch_size;
+			try_params(params, true);
+		}
+	}
+	if(best_time < 0.0) {
+		oclr_error("autotuning failed: no valid bin/batch size combination!");
+		destroy_scenes(scenes);
+		ocl->set_tuning(initial_params);
+		ocl->reload_kernels(true);
+		return false;
+	}
+	
+	// work-group sizes (the kernels of the best bin/batch size only need to be compiled once)
+	// note: the rasterization work-group size is fixed to 1 on cpus (see opencl_base::set_tuning)
+	const bool cpu_device = (device->type >= opencl::DEVICE_TYPE::CPU0 && device->type <= opencl::DEVICE_TYPE::CPU255);
+	bool reload_kernels = true;
+	const opencl::tuning_parameters bin_batch_params = best_params;
+	for(const auto& wg_size : wg_size_candidates) {
+		if(cpu_device) break;
+		if(wg_size > device->max_wg_size || wg_size == bin_batch_params.rasterization_wg_size) continue;
+		opencl::tuning_parameters params = bin_batch_params;
+		params.rasterization_wg_size = wg_size;
+		try_params(params, reload_kernels);
+		reload_kernels = false;
+	}
+	const opencl::tuning_parameters raster_params = best_params;
+	for(const auto& wg_size : wg_size_candidates) {
+		if(wg_size > device->max_wg_size || wg_size == raster_params.binning_wg_size) continue;
+		opencl::tuning_parameters params = raster_params;
+		params.binning_wg_size = wg_size;
+		try_params(params, reload_kernels);
+		reload_kernels = false;
+	}
+	destroy_scenes(scenes);
+	
+	// use and store the best parameters
+	ocl->set_tuning(best_params);
+	ocl->reload_kernels(true);
+	oclr_log("autotuning done: bin size %u, batch size %u, work-group sizes %u/%u (%fms)",
+			 best_params.bin_size, best_params.batch_size,
+			 best_params.rasterization_wg_size, best_params.binning_wg_size, best_time);
+	return ocl->save_tuning();
+}
@@ -0,0 +1,54 @@
+/*
+ *  Flexible OpenCL Rasterizer (oclraster)
+ *  Copyright (C) 2012 - 2013 Florian Ziesche
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License only.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __OCLRASTER_AUTOTUNER_H__
+#define __OCLRASTER_AUTOTUNER_H__
+
+#include "oclraster/global.h"
+#include "cl/opencl.h"
+
+// benchmarks bin size, batch size and work-group size candidates on synthetic scenes (small, medium and large
+// overlapping triangles) on the primary device and stores the fastest combination in the tuning file.
+// bin and batch size are tuned together first (each candidate requires a full kernel reload),
+// then the rasterization and binning work-group sizes are tuned one after another.
+// note: this must be called from the thread that owns the context, while no pipeline is drawing
+class autotuner {
+public:
+	static bool run();
+
+protected:
+	autotuner() = delete;
+	~autotuner() = delete;
+	
+	struct synthetic_scene {
+		string name;
+		opencl::buffer_object* vertex_buffer { nullptr };
+		opencl::buffer_object* index_buffer { nullptr };
+		unsigned int vertex_count { 0 };
+		unsigned int triangle_count { 0 };
+	};
+	static vector<synthetic_scene> create_scenes();
+	static void destroy_scenes(vector<synthetic_scene>& scenes);
+	
+	// returns the summed up time (in ms) it took to render all scenes, or a negative value on failure
+	static double benchmark(const opencl::tuning_parameters& params, const bool reload_kernels,
+							const vector<synthetic_scene>& scenes);
+
+};
+
+#endif
@@ -20,15 +20,18 @@
 #include "pipeline.h"
 #include "oclraster.h"
 
-binning_stage::binning_stage() {
+binning_stage::binning_stage() : coarse_binning_threshold(oclraster::get_coarse_binning_threshold()) {
 	bin_distribution_counter = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE |
 												  opencl::BUFFER_FLAG::BLOCK_ON_READ |
 												  opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
 												  sizeof(unsigned int));
-	queue_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE |
-									  opencl::BUFFER_FLAG::BLOCK_ON_READ |
-									  opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
-									  128 * 1024 * 1024); // TODO: actual size
+	const unsigned int zero_statistics[3] { 0u, 0u, 0u };
+	statistics_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE |
+										   opencl::BUFFER_FLAG::BLOCK_ON_READ |
+										   opencl::BUFFER_FLAG::BLOCK_ON_WRITE |
+										   opencl::BUFFER_FLAG::INITIAL_COPY,
+										   sizeof(zero_statistics), zero_statistics);
+	// note: the bin queue is allocated on demand (-> reserve_queue)
 }
 
 binning_stage::~binning_stage() {
@@ -38,9 +41,330 @@ binning_stage::~binning_stage() {
 	if(queue_buffer != nullptr) {
 		ocl->delete_buffer(queue_buffer);
 	}
+	if(mask_buffer != nullptr) {
+		ocl->delete_buffer(mask_buffer);
+	}
+	if(statistics_buffer != nullptr) {
+		ocl->delete_buffer(statistics_buffer);
+	}
+	if(depth_bounds_buffer != nullptr) {
+		ocl->delete_buffer(depth_bounds_buffer);
+	}
+}
+
+// scatter binner: primitive mask words per bin and batch, and bytes per bin list entry (see bin_rasterize.cl)
+// note: these depend on the (tuned) batch size
+static size_t scatter_mask_words() {
+	return ocl->get_tuning().batch_size / 32;
+}
+static size_t scatter_entry_size() {
+	return (scatter_mask_words() + 1) * sizeof(unsigned int);
+}
+// coarse binning: #bins per coarse tile side (see COARSE_BIN_FACTOR in bin_rasterize.cl)
+static constexpr unsigned int coarse_bin_factor { 4u };
+
+// coarse tile offset and count covering all bins of a draw (-> respects the scissor rectangle)
+static void get_coarse_tiles(const draw_state& state, uint2& coarse_offset, uint2& coarse_count) {
+	coarse_offset = { state.bin_offset.x / coarse_bin_factor, state.bin_offset.y / coarse_bin_factor };
+	const uint2 coarse_end {
+		(state.bin_offset.x + state.bin_count.x - 1) / coarse_bin_factor,
+		(state.bin_offset.y + state.bin_count.y - 1) / coarse_bin_factor
+	};
+	coarse_count = { coarse_end.x - coarse_offset.x + 1, coarse_end.y - coarse_offset.y + 1 };
+}
+
+static bool use_coarse_binning(const draw_state& state, const unsigned int threshold) {
+	return (state.binning == BINNING::GATHER && threshold != 0 &&
+			state.bin_count.x * state.bin_count.y >= threshold);
+}
+
+// sign of the edge functions inside a primitive (see bin_edge_test in bin_rasterize.cl)
+static float get_edge_sign(const draw_state& state) {
+	// 0 signals fixed-point data (snapped vertex positions instead of edge functions)
+	if(state.projection == PROJECTION::ORTHOGRAPHIC && state.fixed_point_rasterization) return 0.0f;
+	return (state.projection == PROJECTION::PERSPECTIVE ? -1.0f : 1.0f);
+}
+
+size_t binning_stage::compute_batch_queue_size(const BINNING binning, const size_t bin_count_lin) {
+	return bin_count_lin * (binning == BINNING::SCATTER ? scatter_entry_size() : size_t(ocl->get_tuning().batch_size));
+}
+
+size_t binning_stage::compute_queue_size(const draw_state& state) {
+	const size_t bin_count_lin = size_t(state.bin_count.x) * size_t(state.bin_count.y);
+	const size_t queue_size = compute_batch_queue_size(state.binning, bin_count_lin) * size_t(state.batch_count);
+	if(state.binning == BINNING::SCATTER) {
+		// + per-bin offset header (incl. total #entries)
+		return queue_size + (bin_count_lin + 1) * sizeof(unsigned int);
+	}
+	return queue_size;
+}
+
+size_t binning_stage::get_max_queue_size() const {
+	return ocl->get_active_device()->max_alloc;
+}
+
+unsigned int binning_stage::get_max_batch_count(const BINNING binning, const size_t bin_count_lin) const {
+	if(bin_count_lin == 0) return ~0u;
+	size_t max_queue_size = get_max_queue_size();
+	if(binning == BINNING::SCATTER) {
+		const size_t header_size = (bin_count_lin + 1) * sizeof(unsigned int);
+		max_queue_size = (max_queue_size > header_size ? max_queue_size - header_size : 0);
+	}
+	const size_t max_batch_count = max_queue_size / compute_batch_queue_size(binning, bin_count_lin);
+	return (unsigned int)std::min(max_batch_count, size_t(~0u));
+}
+
+const binning_stage::queue_statistics& binning_stage::get_queue_statistics() const {
+	return queue_stats;
+}
+
+void binning_stage::set_collect_statistics(const bool state) {
+	collect_statistics = state;
+}
+
+bool binning_stage::get_collect_statistics() const {
+	return collect_statistics;
+}
+
+binning_stage::bin_statistics binning_stage::get_bin_statistics() const {
+	unsigned int counters[3] { 0u, 0u, 0u };
+	ocl->read_buffer(counters, statistics_buffer);
+	bin_statistics stats;
+	stats.aabb_pairs = counters[0];
+	stats.edge_pairs = counters[1];
+	stats.depth_rejected_pairs = counters[2];
+	return stats;
+}
+
+void binning_stage::reset_bin_statistics() {
+	const unsigned int zero_statistics[3] { 0u, 0u, 0u };
+	ocl->write_buffer(statistics_buffer, zero_statistics);
+}
+
+const opencl::buffer_object* binning_stage::get_statistics_buffer() const {
+	return statistics_buffer;
+}
+
+void binning_stage::trim_queue() {
+	if(queue_buffer != nullptr) {
+		ocl->delete_buffer(queue_buffer);
+		queue_buffer = nullptr;
+	}
+	if(mask_buffer != nullptr) {
+		ocl->delete_buffer(mask_buffer);
+		mask_buffer = nullptr;
+	}
+	queue_stats.queue_size = 0;
+}
+
+bool binning_stage::reserve_queue(const size_t required_size) {
+	queue_stats.peak_required_size = std::max(queue_stats.peak_required_size, required_size);
+	if(queue_buffer != nullptr && queue_buffer->size >= required_size) {
+		return true;
+	}
+	
+	const size_t max_size = get_max_queue_size();
+	if(required_size > max_size) {
+		oclr_error("bin queue overflow: required size (%u bytes) is larger than the max queue size (%u bytes)!",
+				   required_size, max_size);
+		queue_stats.overflow_count++;
+		return false;
+	}
+	
+	// grow by at least 50% (clamped to the max size), so that slowly increasing sizes don't reallocate all the time
+	const size_t new_size = (queue_buffer == nullptr ? required_size :
+							 std::min(std::max(required_size, queue_buffer->size + queue_buffer->size / 2), max_size));
+	trim_queue();
+	queue_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE |
+									  opencl::BUFFER_FLAG::BLOCK_ON_READ |
+									  opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
+									  new_size);
+	if(queue_buffer == nullptr) {
+		oclr_error("failed to allocate bin queue (%u bytes)!", new_size);
+		queue_stats.overflow_count++;
+		return false;
+	}
+	queue_stats.queue_size = queue_buffer->size;
+	queue_stats.grow_count++;
+	return true;
+}
+
+bool binning_stage::reserve_mask_buffer(const size_t required_size) {
+	if(mask_buffer != nullptr && mask_buffer->size >= required_size) {
+		return true;
+	}
+	
+	// note: the mask buffer is always smaller than the bin lists, so this can't overflow if the lists fit
+	const size_t new_size = (mask_buffer == nullptr ? required_size :
+							 std::min(std::max(required_size, mask_buffer->size + mask_buffer->size / 2), get_max_queue_size()));
+	if(mask_buffer != nullptr) {
+		ocl->delete_buffer(mask_buffer);
+	}
+	mask_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE, new_size);
+	if(mask_buffer == nullptr) {
+		oclr_error("failed to allocate bin mask buffer (%u bytes)!", new_size);
+		queue_stats.overflow_count++;
+		return false;
+	}
+	return true;
+}
+
+void binning_stage::set_coarse_binning_threshold(const unsigned int bin_count_threshold) {
+	coarse_binning_threshold = bin_count_threshold;
+}
+
+unsigned int binning_stage::get_coarse_binning_threshold() const {
+	return coarse_binning_threshold;
+}
+
+void binning_stage::set_depth_bounds_culling(const bool state) {
+	// the bounds haven't been updated while culling was disabled
+	if(state && !depth_bounds_culling) invalidate_depth_bounds();
+	depth_bounds_culling = state;
+}
+
+bool binning_stage::get_depth_bounds_culling() const {
+	return depth_bounds_culling;
+}
+
+void binning_stage::invalidate_depth_bounds() {
+	if(depth_bounds_buffer == nullptr) return;
+	fill_depth_bounds(float2 { -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() }, false);
+}
+
+void binning_stage::clear_depth_bounds(const image* depth_buffer, const uint2& framebuffer_size,
+									   const float clear_depth, const bool partial) {
+	if(!depth_bounds_culling || depth_buffer == nullptr) return;
+	// a partial clear of an untracked depth buffer doesn't make its bounds known
+	if(partial && depth_buffer != depth_bounds_image) return;
+	if(!reserve_depth_bounds(depth_buffer, framebuffer_size)) return;
+	fill_depth_bounds(float2 { clear_depth, clear_depth }, partial);
+}
+
+bool binning_stage::reserve_depth_bounds(const image* depth_buffer, const uint2& framebuffer_size) {
+	const unsigned int bin_size = ocl->get_tuning().bin_size;
+	const uint2 bin_count {
+		(framebuffer_size.x / bin_size) + ((framebuffer_size.x % bin_size) != 0 ? 1 : 0),
+		(framebuffer_size.y / bin_size) + ((framebuffer_size.y % bin_size) != 0 ? 1 : 0)
+	};
+	if(depth_bounds_buffer != nullptr && depth_buffer == depth_bounds_image &&
+	   bin_count.x == depth_bounds_bin_count.x && bin_count.y == depth_bounds_bin_count.y) {
+		return true;
+	}
+	
+	// different depth buffer or size -> the bounds are unknown
+	const size_t required_size = size_t(bin_count.x) * size_t(bin_count.y) * sizeof(float2);
+	if(depth_bounds_buffer == nullptr || depth_bounds_buffer->size < required_size) {
+		if(depth_bounds_buffer != nullptr) {
+			ocl->delete_buffer(depth_bounds_buffer);
+		}
+		depth_bounds_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE, required_size);
+		if(depth_bounds_buffer == nullptr) {
+			oclr_error("failed to allocate depth bounds buffer (%u bytes)!", required_size);
+			depth_bounds_image = nullptr;
+			depth_bounds_bin_count = { 0u, 0u };
+			return false;
+		}
+	}
+	depth_bounds_image = depth_buffer;
+	depth_bounds_bin_count = bin_count;
+	invalidate_depth_bounds();
+	return true;
+}
+
+void binning_stage::fill_depth_bounds(const float2 bounds, const bool merge) {
+	const unsigned int bin_count_lin = depth_bounds_bin_count.x * depth_bounds_bin_count.y;
+	if(bin_count_lin == 0) return;
+	ocl->use_kernel("BIN_DEPTH_BOUNDS.CLEAR");
+	ocl->set_kernel_argument(0, depth_bounds_buffer);
+	ocl->set_kernel_argument(1, bin_count_lin);
+	ocl->set_kernel_argument(2, bounds);
+	ocl->set_kernel_argument(3, (unsigned int)(merge ? 1 : 0));
+	ocl->set_kernel_range(ocl->compute_kernel_ranges(bin_count_lin));
+	ocl->run_kernel();
+}
+
+unsigned int binning_stage::get_depth_bounds_func(const draw_state& state) const {
+	// see DEPTH_BOUNDS_* in bin_rasterize.cl
+	if(!depth_bounds_culling || depth_bounds_image == nullptr ||
+	   !state.depth.depth_test || state.depth.depth_override) {
+		return 0;
+	}
+	
+	// the depth test is only performed if the rasterization program actually uses the framebuffer depth
+	const auto images = state.rasterize_prog->get_images();
+	bool has_framebuffer_depth = false;
+	for(size_t i = 0, img_count = images.image_names.size(); i < img_count; i++) {
+		if(images.is_framebuffer[i] && images.image_types[i] == oclraster_program::IMAGE_VAR_TYPE::DEPTH_IMAGE) {
+			has_framebuffer_depth = true;
+			break;
+		}
+	}
+	if(!has_framebuffer_depth) return 0;
+	
+	switch(state.depth.depth_func) {
+		case DEPTH_FUNCTION::LESS: return 1;
+		case DEPTH_FUNCTION::LESS_OR_EQUAL: return 2;
+		case DEPTH_FUNCTION::GREATER: return 3;
+		case DEPTH_FUNCTION::GREATER_OR_EQUAL: return 4;
+		case DEPTH_FUNCTION::EQUAL: return 5;
+		// never/not equal/always/custom: nothing can be said about these
+		default: break;
+	}
+	return 0;
 }
 
 const opencl::buffer_object* binning_stage::bin(draw_state& state) {
+	opencl_base::profiling_stage_scope profiling_scope(opencl_base::PROFILING_STAGE::BINNING);
+	
+	// make sure the queue is large enough to hold all batches of all bins
+	if(!reserve_queue(compute_queue_size(state))) {
+		return nullptr;
+	}
+	
+	// note: the depth bounds buffer is always needed as a kernel argument (even if no depth buffer is bound)
+	const image* depth_buffer = (state.active_framebuffer != nullptr ? state.active_framebuffer->get_depth_buffer() : nullptr);
+	if(!reserve_depth_bounds(depth_buffer, state.framebuffer_size)) {
+		return nullptr;
+	}
+	state.depth_bounds_buffer = depth_bounds_buffer;
+	state.depth_bounds_pitch = depth_bounds_bin_count.x;
+	state.update_depth_bounds = (depth_bounds_culling && depth_buffer != nullptr);
+	
+	if(state.binning == BINNING::SCATTER) {
+		const size_t bin_count_lin = size_t(state.bin_count.x) * size_t(state.bin_count.y);
+		if(!reserve_mask_buffer(bin_count_lin * size_t(state.batch_count) * scatter_mask_words() * sizeof(unsigned int))) {
+			return nullptr;
+		}
+		bin_scatter(state);
+	}
+	else {
+		if(use_coarse_binning(state, coarse_binning_threshold)) {
+			uint2 coarse_offset, coarse_count;
+			get_coarse_tiles(state, coarse_offset, coarse_count);
+			if(!reserve_mask_buffer(size_t(coarse_count.x) * size_t(coarse_count.y) * size_t(state.batch_count) *
+									scatter_mask_words() * sizeof(unsigned int))) {
+				return nullptr;
+			}
+			bin_coarse(state);
+		}
+		bin_gather(state);
+	}
+	
+	//
+#if 0
+	static bool dumped = false;
+	if(!dumped) {
+		dumped = true;
+		ocl->dump_buffer(queue_buffer, oclraster::data_path("dump/queue.bin"));
+		ocl->dump_buffer(bin_distribution_counter, oclraster::data_path("dump/bindist.bin"));
+	}
+#endif
+	
+	return queue_buffer;
+}
+
+void binning_stage::bin_gather(draw_state& state) {
 	////
 	// bin rasterizer
 	unsigned int argc = 0;
@@ -50,7 +374,7 @@ const opencl::buffer_object* binning_stage::bin(draw_state& state) {
 	const size_t unit_count = ocl->get_active_device()->units;
 	const size_t bin_count_lin = state.bin_count.x * state.bin_count.y;
 	
-	const size_t wg_size = ocl->get_kernel_work_group_size();
+	const size_t wg_size = ocl->get_tuned_work_group_size(ocl->get_tuning().binning_wg_size);
 	const size_t bin_local_size = std::min(wg_size, bin_count_lin);
 	
 	ocl->set_kernel_argument(argc++, bin_distribution_counter);
@@ -62,6 +386,22 @@ const opencl::buffer_object* binning_stage::bin(draw_state& state) {
 	ocl->set_kernel_argument(argc++, state.primitive_count);
 	
 	ocl->set_kernel_argument(argc++, state.primitive_bounds_buffer);
+	ocl->set_kernel_argument(argc++, state.transformed_buffer);
+	ocl->set_kernel_argument(argc++, get_edge_sign(state));
+	ocl->set_kernel_argument(argc++, statistics_buffer);
+	ocl->set_kernel_argument(argc++, (unsigned int)(collect_statistics ? 1 : 0));
+	ocl->set_kernel_argument(argc++, state.depth_bounds_buffer);
+	ocl->set_kernel_argument(argc++, state.depth_bounds_pitch);
+	ocl->set_kernel_argument(argc++, get_depth_bounds_func(state));
+	
+	// note: if coarse binning is disabled, the coarse mask buffer is never accessed (-> any buffer will do)
+	const bool coarse_binning = use_coarse_binning(state, coarse_binning_threshold);
+	uint2 coarse_offset, coarse_count;
+	get_coarse_tiles(state, coarse_offset, coarse_count);
+	ocl->set_kernel_argument(argc++, (coarse_binning ? mask_buffer : queue_buffer));
+	ocl->set_kernel_argument(argc++, coarse_count);
+	ocl->set_kernel_argument(argc++, coarse_offset);
+	ocl->set_kernel_argument(argc++, (unsigned int)(coarse_binning ? 1 : 0));
 	ocl->set_kernel_argument(argc++, state.framebuffer_size);
 	
 	if(ocl->get_active_device()->type >= opencl::DEVICE_TYPE::CPU0 &&
@@ -76,16 +416,90 @@ const opencl::buffer_object* binning_stage::bin(draw_state& state) {
 		ocl->set_kernel_range({ unit_count * bin_local_size, bin_local_size });
 	}
 	ocl->run_kernel();
+}
+
+void binning_stage::bin_coarse(draw_state& state) {
+	uint2 coarse_offset, coarse_count;
+	get_coarse_tiles(state, coarse_offset, coarse_count);
+	const unsigned int mask_word_count = coarse_count.x * coarse_count.y * state.batch_count * (unsigned int)scatter_mask_words();
 	
-	//
-#if 0
-	static bool dumped = false;
-	if(!dumped) {
-		dumped = true;
-		ocl->dump_buffer(queue_buffer, oclraster::data_path("dump/queue.bin"));
-		ocl->dump_buffer(bin_distribution_counter, oclraster::data_path("dump/bindist.bin"));
-	}
-#endif
+	// clear all coarse primitive masks
+	ocl->use_kernel("BIN_SCATTER.CLEAR");
+	ocl->set_kernel_argument(0, mask_buffer);
+	ocl->set_kernel_argument(1, mask_word_count);
+	ocl->set_kernel_range(ocl->compute_kernel_ranges(mask_word_count));
+	ocl->run_kernel();
 	
-	return queue_buffer;
+	// scatter each primitive into all coarse tiles it overlaps
+	unsigned int argc = 0;
+	ocl->use_kernel("BIN_COARSE");
+	ocl->set_kernel_argument(argc++, mask_buffer);
+	ocl->set_kernel_argument(argc++, coarse_count);
+	ocl->set_kernel_argument(argc++, coarse_offset);
+	ocl->set_kernel_argument(argc++, state.batch_count);
+	ocl->set_kernel_argument(argc++, state.primitive_count);
+	ocl->set_kernel_argument(argc++, state.primitive_bounds_buffer);
+	ocl->set_kernel_argument(argc++, state.transformed_buffer);
+	ocl->set_kernel_argument(argc++, get_edge_sign(state));
+	ocl->set_kernel_argument(argc++, state.framebuffer_size);
+	ocl->set_kernel_range(ocl->compute_kernel_ranges(state.primitive_count));
+	ocl->run_kernel();
+}
+
+void binning_stage::bin_scatter(draw_state& state) {
+	const unsigned int bin_count_lin = state.bin_count.x * state.bin_count.y;
+	const unsigned int mask_word_count = bin_count_lin * state.batch_count * (unsigned int)scatter_mask_words();
+	
+	// clear all primitive masks
+	ocl->use_kernel("BIN_SCATTER.CLEAR");
+	ocl->set_kernel_argument(0, mask_buffer);
+	ocl->set_kernel_argument(1, mask_word_count);
+	ocl->set_kernel_range(ocl->compute_kernel_ranges(mask_word_count));
+	ocl->run_kernel();
+	
+	// scatter each primitive into all bins it overlaps
+	unsigned int argc = 0;
+	ocl->use_kernel("BIN_SCATTER");
+	ocl->set_kernel_argument(argc++, mask_buffer);
+	ocl->set_kernel_argument(argc++, (uint2)state.bin_count);
+	ocl->set_kernel_argument(argc++, state.bin_offset);
+	ocl->set_kernel_argument(argc++, state.batch_count);
+	ocl->set_kernel_argument(argc++, state.primitive_count);
+	ocl->set_kernel_argument(argc++, state.primitive_bounds_buffer);
+	ocl->set_kernel_argument(argc++, state.transformed_buffer);
+	ocl->set_kernel_argument(argc++, get_edge_sign(state));
+	ocl->set_kernel_argument(argc++, statistics_buffer);
+	ocl->set_kernel_argument(argc++, (unsigned int)(collect_statistics ? 1 : 0));
+	ocl->set_kernel_argument(argc++, state.depth_bounds_buffer);
+	ocl->set_kernel_argument(argc++, state.depth_bounds_pitch);
+	ocl->set_kernel_argument(argc++, get_depth_bounds_func(state));
+	ocl->set_kernel_argument(argc++, state.framebuffer_size);
+	ocl->set_kernel_range(ocl->compute_kernel_ranges(state.primitive_count));
+	ocl->run_kernel();
+	
+	// count the non-empty batches per bin
+	ocl->use_kernel("BIN_SCATTER.COUNT");
+	ocl->set_kernel_argument(0, mask_buffer);
+	ocl->set_kernel_argument(1, queue_buffer);
+	ocl->set_kernel_argument(2, bin_count_lin);
+	ocl->set_kernel_argument(3, state.batch_count);
+	ocl->set_kernel_range(ocl->compute_kernel_ranges(bin_count_lin));
+	ocl->run_kernel();
+	
+	// -> per-bin list offsets (single work-group, max 256 work-items)
+	ocl->use_kernel("BIN_SCATTER.PREFIX_SUM");
+	const size_t scan_size = std::min(size_t(256), ocl->get_kernel_work_group_size());
+	ocl->set_kernel_argument(0, queue_buffer);
+	ocl->set_kernel_argument(1, bin_count_lin);
+	ocl->set_kernel_range({ scan_size, scan_size });
+	ocl->run_kernel();
+	
+	// write the compact bin lists
+	ocl->use_kernel("BIN_SCATTER.WRITE");
+	ocl->set_kernel_argument(0, mask_buffer);
+	ocl->set_kernel_argument(1, queue_buffer);
+	ocl->set_kernel_argument(2, bin_count_lin);
+	ocl->set_kernel_argument(3, state.batch_count);
+	ocl->set_kernel_range(ocl->compute_kernel_ranges(bin_count_lin));
+	ocl->run_kernel();
 }
@@ -21,18 +21,95 @@
 
 #include "oclraster/global.h"
 #include "cl/opencl.h"
+#include "program/oclraster_program.h"
 
 struct draw_state;
+class image;
 class binning_stage {
 public:
 	binning_stage();
 	~binning_stage();
 	
+	// returns nullptr if the bin queue for this draw state can't be allocated (-> draw must be split up)
+	// note: depending on state.binning, this either returns the gather queue or the scatter bin lists
 	const opencl::buffer_object* bin(draw_state& state);
+	
+	// gather: the bin queue requires BATCH_SIZE bytes per bin and batch
+	// scatter: the bin lists require (worst case) one entry (batch index + primitive mask) per bin and batch,
+	// plus a per-bin offset header (the primitive masks need an additional, slightly smaller buffer)
+	static size_t compute_queue_size(const draw_state& state);
+	static size_t compute_batch_queue_size(const BINNING binning, const size_t bin_count_lin);
+	// max bin queue size on the active device
+	size_t get_max_queue_size() const;
+	// max #batches that can be binned at once (for the given #bins)
+	unsigned int get_max_batch_count(const BINNING binning, const size_t bin_count_lin) const;
+	
+	struct queue_statistics {
+		size_t queue_size { 0 }; // currently allocated queue size
+		size_t peak_required_size { 0 }; // max queue size any draw has required
+		unsigned int grow_count { 0 }; // how often the queue had to be reallocated
+		unsigned int overflow_count { 0 }; // #draws that didn't fit into the max queue size
+	};
+	const queue_statistics& get_queue_statistics() const;
+	
+	// bin/primitive pair counters (accumulated on the device until reset, only collected if enabled)
+	struct bin_statistics {
+		unsigned int aabb_pairs { 0 }; // #pairs whose aabb overlaps the bin
+		unsigned int edge_pairs { 0 }; // #pairs that also pass the exact edge test
+		unsigned int depth_rejected_pairs { 0 }; // #edge test pairs that are rejected by the depth bounds test
+	};
+	void set_collect_statistics(const bool state);
+	bool get_collect_statistics() const;
+	bin_statistics get_bin_statistics() const; // note: this blocks until all binning has finished
+	void reset_bin_statistics();
+	// device buffer of the pair counters (3 uints in bin_statistics order, -> device side copies)
+	const opencl::buffer_object* get_statistics_buffer() const;
+	
+	// releases the bin queue (it will be reallocated on demand)
+	void trim_queue();
+	
+	// per-bin depth bounds (hi-z): min/max depth of all fragments in each bin of the active depth buffer.
+	// the binner rejects bin/primitive pairs that can't pass the depth test against these bounds and
+	// the rasterizer keeps them up-to-date. the bounds are reset when the depth buffer is cleared (framebuffer::clear)
+	// note: if the depth buffer is modified in any other way, invalidate_depth_bounds must be called
+	void set_depth_bounds_culling(const bool state);
+	bool get_depth_bounds_culling() const;
+	// partial: only a part of the depth buffer is cleared (-> scissor)
+	void clear_depth_bounds(const image* depth_buffer, const uint2& framebuffer_size,
+							const float clear_depth, const bool partial);
+	// resets the bounds to "unknown" (nothing is rejected until the depth buffer is cleared)
+	void invalidate_depth_bounds();
+	
+	// two-level binning (gather binner only): if the #bins of a draw is at least this threshold, primitives are
+	// first binned into coarse tiles (4x4 bins), so that each bin only has to consider the primitives of its tile
+	// (0 = disabled)
+	void set_coarse_binning_threshold(const unsigned int bin_count_threshold);
+	unsigned int get_coarse_binning_threshold() const;
 
 protected:
 	opencl::buffer_object* bin_distribution_counter = nullptr;
 	opencl::buffer_object* queue_buffer = nullptr;
+	opencl::buffer_object* mask_buffer = nullptr; // only used by the scatter binner and coarse binning
+	opencl::buffer_object* statistics_buffer = nullptr;
+	queue_statistics queue_stats;
+	bool collect_statistics { false };
+	
+	opencl::buffer_object* depth_bounds_buffer = nullptr; // float2 per bin
+	const image* depth_bounds_image = nullptr; // the depth buffer the bounds belong to
+	uint2 depth_bounds_bin_count { 0u, 0u };
+	bool depth_bounds_culling { true };
+	
+	unsigned int coarse_binning_threshold;
+	
+	bool reserve_queue(const size_t required_size);
+	bool reserve_mask_buffer(const size_t required_size);
+	bool reserve_depth_bounds(const image* depth_buffer, const uint2& framebuffer_size);
+	void fill_depth_bounds(const float2 bounds, const bool merge);
+	unsigned int get_depth_bounds_func(const draw_state& state) const;
+	
+	void bin_gather(draw_state& state);
+	void bin_coarse(draw_state& state);
+	void bin_scatter(draw_state& state);
 
 };
 
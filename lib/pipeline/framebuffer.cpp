@@ -87,6 +87,7 @@ public:
 	static weak_ptr<opencl::kernel_object> build_kernel(const image_spec& spec);
 	
 	static void delete_kernels();
+	static void delete_kernels(const set<string>& changed_files);
 	
 };
 vector<framebuffer_program::image_spec*> framebuffer_program::compiled_image_kernels;
@@ -166,11 +167,30 @@ void framebuffer_program::delete_kernels() {
 	compiled_image_kernels.clear();
 	kernels.clear();
 }
+
+void framebuffer_program::delete_kernels(const set<string>& changed_files) {
+	// only delete the clear kernels that depend on one of the changed files, all others stay valid
+	for(auto iter = kernels.begin(); iter != kernels.end();) {
+		if(!ocl->kernel_depends_on(iter->second, changed_files)) {
+			iter++;
+			continue;
+		}
+		ocl->delete_kernel(iter->second);
+		const auto spec_iter = find(begin(compiled_image_kernels), end(compiled_image_kernels), iter->first);
+		if(spec_iter != compiled_image_kernels.end()) compiled_image_kernels.erase(spec_iter);
+		delete iter->first;
+		iter = kernels.erase(iter);
+	}
+}
 	
 void delete_clear_kernels() {
 	framebuffer_program::delete_kernels();
 }
 
+void delete_clear_kernels(const set<string>& changed_files) {
+	framebuffer_program::delete_kernels(changed_files);
+}
+
 //
 framebuffer framebuffer::create_with_images(const unsigned int& width, const unsigned int& height,
 											initializer_list<pair<IMAGE_TYPE, IMAGE_CHANNEL>> image_types,
@@ -348,6 +368,7 @@ void framebuffer::detach_stencil_buffer() {
 }
 
 void framebuffer::clear(const vector<size_t> image_indices, const bool depth_clear, const bool stencil_clear) const {
+	opencl_base::profiling_stage_scope profiling_scope(opencl_base::PROFILING_STAGE::CLEAR);
 	const vector<size_t>* indices = &image_indices;
 	vector<size_t> all_indices;
 	if(image_indices.size() == 1 && image_indices[0] == ~0u) {
@@ -374,6 +395,12 @@ void framebuffer::clear(const vector<size_t> image_indices, const bool depth_cle
 		spec.stencil_image = stencil_buffer->get_image_type();
 	}
 	
+	// recorded (deferred) draws must be executed before the framebuffer is cleared
+	const auto active_pipeline = oclraster::get_active_pipeline();
+	if(active_pipeline != nullptr) {
+		active_pipeline->flush();
+	}
+	
 	//
 	unsigned int argc = 0;
 	auto clear_kernel = framebuffer_program::get_clear_kernel(spec);
@@ -396,7 +423,6 @@ void framebuffer::clear(const vector<size_t> image_indices, const bool depth_cle
 	
 	//
 	uint4 scissor_rectangle { 0u, 0u, ~0u, ~0u };
-	const auto active_pipeline = oclraster::get_active_pipeline();
 	if(active_pipeline != nullptr && active_pipeline->get_scissor_test()) {
 		scissor_rectangle = active_pipeline->get_scissor_rectangle();
 		const uint2 scissor_size { scissor_rectangle.z, scissor_rectangle.w };
@@ -411,6 +437,14 @@ void framebuffer::clear(const vector<size_t> image_indices, const bool depth_cle
 	}
 	ocl->set_kernel_argument(argc++, scissor_rectangle);
 	ocl->run_kernel();
+	
+	// reset the per-bin depth bounds of the depth buffer
+	if(active_pipeline != nullptr && depth_clear && depth_buffer != nullptr) {
+		const bool partial = (active_pipeline->get_scissor_test() &&
+							  (scissor_rectangle.x > 0 || scissor_rectangle.y > 0 ||
+							   scissor_rectangle.z < size.x || scissor_rectangle.w < size.y));
+		active_pipeline->clear_depth_bounds(depth_buffer, size, clear_depth, partial);
+	}
 }
 
 void framebuffer::set_clear_color(const ulong4 value) {
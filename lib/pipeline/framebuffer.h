@@ -96,5 +96,6 @@ protected:
 
 // only used internally!
 extern void delete_clear_kernels();
+extern void delete_clear_kernels(const set<string>& changed_files);
 
 #endif
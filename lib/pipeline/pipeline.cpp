@@ -33,6 +33,13 @@ struct __attribute__((packed, aligned(16))) constant_camera_data {
 	uint2 viewport;
 };
 
+// pipeline statistics counters on the device: 4 cull counters (processing), 4 fragment counters (rasterization)
+static constexpr size_t statistics_counter_count { 8 };
+// per draw record: the pipeline counters + the (accumulated) binner pair counters
+static constexpr size_t statistics_record_size { statistics_counter_count + 3 };
+// note: static, since writes from this are non-blocking
+static const unsigned int zero_statistics[statistics_counter_count] {};
+
 pipeline::pipeline() :
 default_framebuffer(0, 0),
 event_handler_fnctr(this, &pipeline::event_handler) {
@@ -42,13 +49,27 @@ event_handler_fnctr(this, &pipeline::event_handler) {
 	state.camera_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ |
 											 opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
 											 sizeof(constant_camera_data));
+	// note: the counters are never read back directly and only reset with non-blocking writes (-> record_draw_statistics)
+	state.statistics_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE |
+												 opencl::BUFFER_FLAG::INITIAL_COPY,
+												 sizeof(zero_statistics), zero_statistics);
+	// written from the host right before the merged draws are rasterized
+	state.merged_draw_offsets_scratch.flags = (opencl::BUFFER_FLAG::READ | opencl::BUFFER_FLAG::BLOCK_ON_WRITE);
+	
+	state.bin_size = uint2 { ocl->get_tuning().bin_size };
+	state.batch_size = ocl->get_tuning().batch_size;
 	
 	state.scissor_test = 0;
 	state.backface_culling = 1;
+	state.fixed_point_rasterization = 0;
+	
+	draw_memory_budget = oclraster::get_draw_memory_budget() * 1024 * 1024; // config value is in MB
+	state.binning = (oclraster::get_binning() == "scatter" ? BINNING::SCATTER : BINNING::GATHER);
 	
 	oclraster::get_event()->add_internal_event_handler(event_handler_fnctr, EVENT_TYPE::WINDOW_RESIZE, EVENT_TYPE::KERNEL_RELOAD);
 	
 #if defined(OCLRASTER_IOS)
+	if(oclraster::is_headless()) return;
 	static const float fullscreen_triangle[6] { 1.0f, 1.0f, 1.0f, -3.0f, -3.0f, 1.0f };
 	glGenBuffers(1, &vbo_fullscreen_triangle);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_fullscreen_triangle);
@@ -61,23 +82,38 @@ pipeline::~pipeline() {
 	oclraster::get_event()->remove_event_handler(event_handler_fnctr);
 	
 	destroy_framebuffers();
+	trim_scratch_buffers(true);
 	
 	ocl->delete_buffer(state.camera_buffer);
+	ocl->delete_buffer(state.statistics_buffer);
+	if(statistics_records_buffer != nullptr) ocl->delete_buffer(statistics_records_buffer);
+	delete_debug_outputs();
 	
 #if defined(OCLRASTER_IOS)
-	if(glIsBuffer(vbo_fullscreen_triangle)) glDeleteBuffers(1, &vbo_fullscreen_triangle);
+	if(!oclraster::is_headless() && glIsBuffer(vbo_fullscreen_triangle)) glDeleteBuffers(1, &vbo_fullscreen_triangle);
 #endif
 }
 
 bool pipeline::event_handler(EVENT_TYPE type, shared_ptr<event_object> obj) {
 	if(type == EVENT_TYPE::WINDOW_RESIZE) {
 		const window_resize_event& evt = (const window_resize_event&)*obj;
+		flush(); // recorded draws might still reference the old default framebuffer
 		create_framebuffers(evt.size);
 	}
 	else if(type == EVENT_TYPE::KERNEL_RELOAD) {
-		// unbind user programs, since those are invalid now
-		state.transform_prog = nullptr;
-		state.rasterize_prog = nullptr;
+		// execute all recorded draws first (-> with the programs they were recorded with, none of them are dropped)
+		flush();
+		
+		// unbind user programs that are invalid now (all on a full reload, otherwise only affected ones)
+		const kernel_reload_event& reload_evt = (const kernel_reload_event&)*obj;
+		if(state.transform_prog != nullptr &&
+		   (reload_evt.full_reload || state.transform_prog->depends_on(reload_evt.changed_files))) {
+			state.transform_prog = nullptr;
+		}
+		if(state.rasterize_prog != nullptr &&
+		   (reload_evt.full_reload || state.rasterize_prog->depends_on(reload_evt.changed_files))) {
+			state.rasterize_prog = nullptr;
+		}
 	}
 	return true;
 }
@@ -96,6 +132,20 @@ void pipeline::create_framebuffers(const uint2& size) {
 														  { { IMAGE_TYPE::UINT_8, IMAGE_CHANNEL::RGBA } },
 														  { IMAGE_TYPE::FLOAT_32, IMAGE_CHANNEL::R });
 	
+	if(!oclraster::is_headless()) {
+		create_copy_framebuffer(scaled_size);
+	}
+	
+	// rebind new default framebuffer (+set correct state)
+	if(is_default_framebuffer) {
+		bind_framebuffer(nullptr);
+	}
+	
+	// do an initial clear
+	default_framebuffer.clear();
+}
+
+void pipeline::create_copy_framebuffer(const uint2& scaled_size) {
 	// create a fbo for copying the color framebuffer every frame and displaying it
 	// (there is no other way, unfortunately)
 	glGenFramebuffers(1, &copy_fbo_id);
@@ -118,18 +168,11 @@ void pipeline::create_framebuffers(const uint2& size) {
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, copy_fbo_tex_id, 0);
 	glBindFramebuffer(GL_FRAMEBUFFER, OCLRASTER_DEFAULT_FRAMEBUFFER);
 	glBindTexture(GL_TEXTURE_2D, 0);
-	
-	// rebind new default framebuffer (+set correct state)
-	if(is_default_framebuffer) {
-		bind_framebuffer(nullptr);
-	}
-	
-	// do an initial clear
-	default_framebuffer.clear();
 }
 
 void pipeline::destroy_framebuffers() {
 	framebuffer::destroy_images(default_framebuffer);
+	if(oclraster::is_headless()) return;
 	
 	glBindFramebuffer(GL_FRAMEBUFFER, OCLRASTER_DEFAULT_FRAMEBUFFER);
 	glBindTexture(GL_TEXTURE_2D, 0);
@@ -140,12 +183,16 @@ void pipeline::destroy_framebuffers() {
 }
 
 void pipeline::swap() {
+	// execute all remaining recorded draws
+	flush();
+	
 	const uint2 default_fb_size = default_framebuffer.get_size();
 	image* fbo_img = default_framebuffer.get_image(0);
 	
 #if defined(OCLRASTER_FXAA)
 	if(fxaa_state) {
 		// fxaa
+		opencl_base::profiling_stage_scope profiling_scope(opencl_base::PROFILING_STAGE::FXAA);
 		ocl->use_kernel("FXAA.LUMA");
 		ocl->set_kernel_argument(0, fbo_img->get_buffer());
 		ocl->set_kernel_argument(1, default_fb_size);
@@ -160,6 +207,41 @@ void pipeline::swap() {
 	}
 #endif
 	
+	if(!oclraster::is_headless()) {
+		display_framebuffer();
+	}
+	else if(frame_cb) {
+		// no window -> hand the mapped color data directly to the user
+		void* fbo_data = nullptr;
+		{
+			opencl_base::profiling_stage_scope profiling_scope(opencl_base::PROFILING_STAGE::SWAP_READBACK);
+			fbo_data = fbo_img->map(opencl::MAP_BUFFER_FLAG::READ | opencl::MAP_BUFFER_FLAG::BLOCK);
+		}
+		if(fbo_data != nullptr) {
+			frame_cb((const unsigned char*)fbo_data, default_fb_size);
+			fbo_img->unmap(fbo_data);
+		}
+	}
+	
+	default_framebuffer.clear();
+	
+	// new frame -> reset scratch allocation counters
+	state.last_scratch_stats = state.scratch_stats;
+	state.scratch_stats.allocations = 0;
+	state.scratch_stats.avoided_allocations = 0;
+	
+	// new frame -> reset pipeline statistics and debug outputs
+	resolve_draw_statistics();
+	last_draw_stats.swap(draw_stats);
+	draw_stats.clear();
+	resolved_draw_stats = 0;
+	if(state.overdraw_buffer != nullptr) clear_debug_outputs();
+}
+
+void pipeline::display_framebuffer() {
+	const uint2 default_fb_size = default_framebuffer.get_size();
+	image* fbo_img = default_framebuffer.get_image(0);
+	
 	// draw/blit to screen
 #if defined(OCLRASTER_IOS)
 	glBindFramebuffer(GL_FRAMEBUFFER, OCLRASTER_DEFAULT_FRAMEBUFFER);
@@ -167,7 +249,11 @@ void pipeline::swap() {
 	glViewport(0, 0, oclraster::get_width(), oclraster::get_height());
 	
 	// copy opencl framebuffer to blit framebuffer/texture
-	auto fbo_data = fbo_img->map(opencl::MAP_BUFFER_FLAG::READ | opencl::MAP_BUFFER_FLAG::BLOCK);
+	void* fbo_data = nullptr;
+	{
+		opencl_base::profiling_stage_scope profiling_scope(opencl_base::PROFILING_STAGE::SWAP_READBACK);
+		fbo_data = fbo_img->map(opencl::MAP_BUFFER_FLAG::READ | opencl::MAP_BUFFER_FLAG::BLOCK);
+	}
 #if !defined(OCLRASTER_IOS)
 	glBindFramebuffer(GL_FRAMEBUFFER, copy_fbo_id);
 #endif
@@ -206,8 +292,10 @@ void pipeline::swap() {
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, OCLRASTER_DEFAULT_FRAMEBUFFER);
 	glBindTexture(GL_TEXTURE_2D, 0);
 #endif
-	
-	default_framebuffer.clear();
+}
+
+void pipeline::set_frame_callback(frame_callback callback) {
+	frame_cb = callback;
 }
 
 void pipeline::draw(const PRIMITIVE_TYPE type,
@@ -226,16 +314,28 @@ void pipeline::draw_instanced(const PRIMITIVE_TYPE type,
 		return;
 	}
 	
+	const unsigned int instance_primitive_count = (element_range.second - element_range.first);
+	if(deferred_drawing) {
+		deferred_draws.emplace_back(make_deferred_draw(type, vertex_count, instance_primitive_count, instance_count));
+		return;
+	}
+	execute_draw(type, vertex_count, instance_primitive_count, instance_count);
+}
+
+bool pipeline::setup_draw_state(const PRIMITIVE_TYPE type,
+								const unsigned int vertex_count,
+								const unsigned int instance_primitive_count,
+								const unsigned int instance_count) {
 	if(state.scissor_test &&
 	   (state.scissor_rectangle.z == 0 || state.scissor_rectangle.w == 0 ||
 		state.scissor_rectangle.x >= state.framebuffer_size.x ||
 		state.scissor_rectangle.y >= state.framebuffer_size.y)) {
-		return; // scissor rectangle size is 0 or offset is beyond the framebuffer size
+		return false; // scissor rectangle size is 0 or offset is beyond the framebuffer size
 	}
 	
 	// initialize draw state
 	state.instance_count = instance_count;
-	state.instance_primitive_count = (element_range.second - element_range.first);
+	state.instance_primitive_count = instance_primitive_count;
 	state.primitive_count = state.instance_primitive_count * state.instance_count;
 	state.vertex_count = vertex_count;
 	switch(type) {
@@ -272,47 +372,840 @@ void pipeline::draw_instanced(const PRIMITIVE_TYPE type,
 	state.batch_count = ((state.primitive_count / state.batch_size) +
 						 ((state.primitive_count % state.batch_size) != 0 ? 1 : 0));
 	
-	// TODO: this should be static!
-	// note: internal transformed buffer size must be a multiple of "batch size" primitives (necessary for the binner)
-	const unsigned int pc_mod_batch_size = (state.primitive_count % OCLRASTER_BATCH_SIZE);
-	const unsigned int primitive_padding = (pc_mod_batch_size == 0 ? 0 : OCLRASTER_BATCH_SIZE - pc_mod_batch_size);
-	state.transformed_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE,
-												  state.transformed_primitive_size * (state.primitive_count + primitive_padding));
-	state.primitive_bounds_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE,
-													   sizeof(float) * 4 * (state.primitive_count + primitive_padding));
-	state.transformed_vertices_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE,
-														   sizeof(float) * 4 * state.vertex_count * state.instance_count);
-	
-	// create user transformed buffers (transform program outputs)
+	if((state.collect_statistics & 2u) != 0u) {
+		resize_debug_outputs(state.framebuffer_size);
+	}
+	return true;
+}
+
+void pipeline::execute_draw(const PRIMITIVE_TYPE type,
+							const unsigned int vertex_count,
+							const unsigned int instance_primitive_count,
+							const unsigned int instance_count) {
+	if(!setup_draw_state(type, vertex_count, instance_primitive_count, instance_count)) return;
+	ocl->next_profiling_draw();
+	
+	// vertex data can't be split up -> always transform all vertices at once
+	size_t vertex_memory = sizeof(float) * 4 * state.vertex_count * state.instance_count;
+	state.transformed_vertices_buffer = acquire_scratch_buffer(state.transformed_vertices_scratch, vertex_memory);
+	
+	// get user transformed buffers (transform program outputs)
 	const auto active_device = ocl->get_active_device();
+	size_t output_index = 0;
 	for(const auto& tp_struct : state.transform_prog->get_structs()) {
 		if(tp_struct->type == oclraster_program::STRUCT_TYPE::OUTPUT) {
-			opencl::buffer_object* buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE,
-															   // get device specific size from program
-															   tp_struct->device_infos.at(active_device).struct_size * vertex_count * state.instance_count);
+			if(output_index >= state.user_transformed_scratch.size()) {
+				state.user_transformed_scratch.emplace_back();
+			}
+			// get device specific size from program
+			const size_t output_size = tp_struct->device_infos.at(active_device).struct_size * vertex_count * state.instance_count;
+			opencl::buffer_object* buffer = acquire_scratch_buffer(state.user_transformed_scratch[output_index++], output_size);
 			state.user_transformed_buffers.push_back(buffer);
 			bind_buffer(tp_struct->object_name, *buffer);
+			vertex_memory += output_size;
 		}
 	}
 	
 	// pipeline
 	transform.transform(state);
+	
+	const unsigned int chunk_size = compute_chunk_size(vertex_memory);
+	if(chunk_size >= state.primitive_count) {
+		rasterize_primitives(type);
+	}
+	else {
+		// split the primitives into chunks that fit into the draw memory budget:
+		// all chunks use the same scratch buffers and the whole index buffer, the processing and rasterization
+		// kernels add the chunk offset to the chunk-relative primitive id (-> index lookups, instance ids and the
+		// primitive_id inside a rasterization program are relative to the draw call, not the chunk)
+		// note: chunks are processed sequentially on the in-order device queue (processing of the next chunk
+		// can't overlap with the rasterization of the current one, since they share the same scratch buffers)
+		const unsigned int primitive_count = state.primitive_count;
+		for(unsigned int chunk_offset = 0; chunk_offset < primitive_count; chunk_offset += chunk_size) {
+			const unsigned int chunk_primitive_count = std::min(chunk_size, primitive_count - chunk_offset);
+			state.primitive_offset = chunk_offset;
+			state.primitive_count = chunk_primitive_count;
+			state.batch_count = ((chunk_primitive_count / state.batch_size) +
+								 ((chunk_primitive_count % state.batch_size) != 0 ? 1 : 0));
+			rasterize_primitives(type);
+		}
+		state.primitive_offset = 0;
+		state.primitive_count = primitive_count;
+	}
+	
+	// note: scratch buffers are kept alive for the next draw call
+	state.user_transformed_buffers.clear();
+	
+	record_draw_statistics(1,
+						   (unsigned long long int)vertex_count * (unsigned long long int)instance_count,
+						   (unsigned long long int)instance_primitive_count * (unsigned long long int)instance_count);
+}
+
+void pipeline::rasterize_primitives(const PRIMITIVE_TYPE type) {
+	// note: internal transformed buffer size must be a multiple of "batch size" primitives (necessary for the binner)
+	const unsigned int pc_mod_batch_size = (state.primitive_count % state.batch_size);
+	const unsigned int primitive_padding = (pc_mod_batch_size == 0 ? 0 : state.batch_size - pc_mod_batch_size);
+	state.transformed_buffer = acquire_scratch_buffer(state.transformed_scratch,
+													  state.transformed_primitive_size * (state.primitive_count + primitive_padding));
+	state.primitive_bounds_buffer = acquire_scratch_buffer(state.primitive_bounds_scratch,
+														   sizeof(float) * 4 * (state.primitive_count + primitive_padding));
+	
 	processing.process(state, type);
 	const auto queue_buffer = binning.bin(state);
-	
-	// TODO: pipelining/splitting
 	rasterization.rasterize(state, type, queue_buffer);
+}
+
+unsigned int pipeline::compute_chunk_size(const size_t vertex_memory) const {
+	// per primitive: transformed data and bounds, per batch: the bin queue entries of all bins
+	const size_t bin_count_lin = state.bin_count.x * state.bin_count.y;
+	const size_t primitive_memory = state.transformed_primitive_size + sizeof(float) * 4;
+	const size_t batch_memory = (primitive_memory * state.batch_size +
+								 binning_stage::compute_batch_queue_size(state.binning, bin_count_lin));
 	
-	//
-	ocl->delete_buffer(state.transformed_buffer);
-	ocl->delete_buffer(state.primitive_bounds_buffer);
-	ocl->delete_buffer(state.transformed_vertices_buffer);
+	// the bin queue must always fit into the max bin queue size (-> use multiple passes otherwise)
+	// note: this applies to all primitive types, triangle fans can be split as well, since the first
+	// index is always read from the start of the draw's index buffer (primitive ids are draw-relative)
+	size_t chunk_batch_count = std::min(size_t(state.batch_count), size_t(binning.get_max_batch_count(state.binning, bin_count_lin)));
+	
+	if(draw_memory_budget != 0) {
+		if(vertex_memory + batch_memory * chunk_batch_count > draw_memory_budget) {
+			const size_t available_memory = (draw_memory_budget > vertex_memory ? draw_memory_budget - vertex_memory : 0);
+			chunk_batch_count = std::min(chunk_batch_count, available_memory / batch_memory);
+		}
+	}
+	
+	// always process at least one batch per chunk
+	chunk_batch_count = std::max(chunk_batch_count, size_t(1));
+	if(chunk_batch_count >= state.batch_count) {
+		return state.primitive_count;
+	}
+	return (unsigned int)(chunk_batch_count * state.batch_size);
+}
+
+void pipeline::set_draw_memory_budget(const size_t budget_bytes) {
+	draw_memory_budget = budget_bytes;
+}
+
+size_t pipeline::get_draw_memory_budget() const {
+	return draw_memory_budget;
+}
+
+void pipeline::set_deferred_drawing(const bool state_) {
+	if(!state_) flush();
+	deferred_drawing = state_;
+}
+
+bool pipeline::get_deferred_drawing() const {
+	return deferred_drawing;
+}
+
+size_t pipeline::get_deferred_draw_count() const {
+	return deferred_draws.size();
+}
+
+void pipeline::flush() {
+	if(deferred_draws.empty()) return;
+	
+	// save the current draw state, this is restored once all recorded draws have been executed
+	const deferred_draw current_state { make_deferred_draw(PRIMITIVE_TYPE::TRIANGLE, 0, 0, 0) };
+	
+	// execute all recorded draws in submission order, merging consecutive draws where possible
+	const auto draw_batch_count = [this](const deferred_draw& draw) {
+		return (draw.instance_primitive_count + state.batch_size - 1) / state.batch_size;
+	};
+	for(size_t first = 0, draw_count = deferred_draws.size(); first < draw_count;) {
+		// merged draws must still fit into a single bin queue
+		const uint2 fb_size = deferred_draws[first].active_framebuffer->get_size();
+		const size_t max_bin_count = (size_t((fb_size.x + state.bin_size.x - 1) / state.bin_size.x) *
+									  size_t((fb_size.y + state.bin_size.y - 1) / state.bin_size.y));
+		const unsigned int max_batch_count = binning.get_max_batch_count(state.binning, max_bin_count);
+		unsigned int merged_batch_count = draw_batch_count(deferred_draws[first]);
+		
+		size_t count = 1;
+		while(first + count < draw_count &&
+			  is_mergeable_draw(deferred_draws[first], deferred_draws[first + count]) &&
+			  merged_batch_count + draw_batch_count(deferred_draws[first + count]) <= max_batch_count) {
+			merged_batch_count += draw_batch_count(deferred_draws[first + count]);
+			count++;
+		}
+		execute_merged_draws(first, count);
+		first += count;
+	}
+	deferred_draws.clear();
+	
+	restore_deferred_draw_state(current_state);
+}
+
+pipeline::deferred_draw pipeline::make_deferred_draw(const PRIMITIVE_TYPE type,
+													 const unsigned int vertex_count,
+													 const unsigned int instance_primitive_count,
+													 const unsigned int instance_count) const {
+	deferred_draw draw {
+		type, vertex_count, instance_primitive_count, instance_count,
+		state.flags, state.projection, state.depth, state.scissor_rectangle,
+		state.active_framebuffer, state.transform_prog, state.rasterize_prog,
+		{}, {}, state.cam_setup
+	};
+	for(const auto& buffer : state.user_buffers) {
+		draw.user_buffers.emplace_back(buffer.first, &buffer.second);
+	}
+	for(const auto& img : state.user_images) {
+		draw.user_images.emplace_back(img.first, &img.second);
+	}
+	// sort by name, so that bindings can easily be compared
+	sort(draw.user_buffers.begin(), draw.user_buffers.end(),
+		 [](const pair<string, const opencl_base::buffer_object*>& lhs,
+			const pair<string, const opencl_base::buffer_object*>& rhs) {
+			 return (lhs.first < rhs.first);
+		 });
+	sort(draw.user_images.begin(), draw.user_images.end(),
+		 [](const pair<string, const image*>& lhs, const pair<string, const image*>& rhs) {
+			 return (lhs.first < rhs.first);
+		 });
+	return draw;
+}
+
+void pipeline::restore_deferred_draw_state(const deferred_draw& draw) {
+	const uint2 prev_framebuffer_size = state.framebuffer_size;
+	state.flags = draw.flags;
+	state.projection = draw.projection;
+	state.depth = draw.depth;
+	state.scissor_rectangle = draw.scissor_rectangle;
+	state.active_framebuffer = draw.active_framebuffer;
+	state.framebuffer_size = draw.active_framebuffer->get_size();
+	state.transform_prog = draw.transform_prog;
+	state.rasterize_prog = draw.rasterize_prog;
+	
+	state.user_buffers.clear();
+	for(const auto& buffer : draw.user_buffers) {
+		state.user_buffers.emplace(buffer.first, *buffer.second);
+	}
+	state.user_images.clear();
+	for(const auto& img : draw.user_images) {
+		state.user_images.emplace(img.first, *img.second);
+	}
+	
+	// only update the camera buffer if the camera setup (or viewport) has actually changed
+	if(memcmp(&state.cam_setup, &draw.cam_setup, sizeof(draw_state::camera_setup)) != 0 ||
+	   prev_framebuffer_size.x != state.framebuffer_size.x ||
+	   prev_framebuffer_size.y != state.framebuffer_size.y) {
+		state.cam_setup = draw.cam_setup;
+		update_camera_buffer();
+	}
+}
+
+bool pipeline::is_mergeable_draw(const deferred_draw& first_draw, const deferred_draw& draw) const {
+	// only non-instanced triangle lists can be merged (indices of strips and fans can't be concatenated)
+	if(first_draw.type != PRIMITIVE_TYPE::TRIANGLE || draw.type != PRIMITIVE_TYPE::TRIANGLE) return false;
+	if(first_draw.instance_count != 1 || draw.instance_count != 1) return false;
+	if(first_draw.vertex_count == 0 || draw.vertex_count == 0) return false;
+	if(draw.transform_prog == nullptr || draw.rasterize_prog == nullptr) return false;
+	
+	// same programs, framebuffer and draw state
+	if(first_draw.transform_prog != draw.transform_prog ||
+	   first_draw.rasterize_prog != draw.rasterize_prog ||
+	   first_draw.active_framebuffer != draw.active_framebuffer ||
+	   first_draw.flags != draw.flags ||
+	   first_draw.projection != draw.projection ||
+	   first_draw.depth != draw.depth ||
+	   memcmp(&first_draw.scissor_rectangle, &draw.scissor_rectangle, sizeof(uint4)) != 0 ||
+	   memcmp(&first_draw.cam_setup, &draw.cam_setup, sizeof(draw_state::camera_setup)) != 0) {
+		return false;
+	}
+	if(first_draw.user_images != draw.user_images) return false;
+	
+	// all bound buffers, except for the index buffer and transform program input and output buffers, must be the same
+	const auto shared_buffers = [&draw](const deferred_draw& ddraw) {
+		vector<pair<string, const opencl_base::buffer_object*>> buffers;
+		for(const auto& buffer : ddraw.user_buffers) {
+			if(buffer.first == "index_buffer") continue;
+			bool per_draw_buffer = false;
+			for(const auto& tp_struct : draw.transform_prog->get_structs()) {
+				if((tp_struct->type == oclraster_program::STRUCT_TYPE::INPUT ||
+					tp_struct->type == oclraster_program::STRUCT_TYPE::OUTPUT) &&
+				   tp_struct->object_name == buffer.first) {
+					per_draw_buffer = true;
+					break;
+				}
+			}
+			if(!per_draw_buffer) buffers.emplace_back(buffer);
+		}
+		return buffers;
+	};
+	return (shared_buffers(first_draw) == shared_buffers(draw));
+}
+
+void pipeline::execute_merged_draws(const size_t first, const size_t count) {
+	if(count == 1) {
+		const deferred_draw& draw = deferred_draws[first];
+		restore_deferred_draw_state(draw);
+		execute_draw(draw.type, draw.vertex_count, draw.instance_primitive_count, draw.instance_count);
+		return;
+	}
+	
+	// compute the vertex and primitive offset of each draw inside the merged ranges
+	// note: offsets must be aligned, so that sub-buffers can be created at these offsets (the byte offset of each
+	// sub-buffer must be a multiple of the device base address alignment) and primitive offsets are additionally
+	// aligned to the batch size (the padding primitives are culled)
+	const auto active_device = ocl->get_active_device();
+	const size_t base_addr_align = std::max(size_t(active_device->base_addr_align), size_t(1));
+	const auto element_alignment = [&base_addr_align](const size_t element_size) {
+		// min #elements so that the byte offset is a multiple of the base address alignment
+		return base_addr_align / core::gcd(base_addr_align, element_size);
+	};
+	size_t vertex_alignment = element_alignment(sizeof(float) * 4);
+	for(const auto& tp_struct : deferred_draws[first].transform_prog->get_structs()) {
+		if(tp_struct->type == oclraster_program::STRUCT_TYPE::OUTPUT) {
+			vertex_alignment = core::lcm(vertex_alignment,
+										 element_alignment(tp_struct->device_infos.at(active_device).struct_size));
+		}
+	}
+	size_t primitive_alignment = core::lcm(state.batch_size, element_alignment(sizeof(float) * 4));
+	primitive_alignment = core::lcm(primitive_alignment, element_alignment(sizeof(unsigned int) * 3));
+	primitive_alignment = core::lcm(primitive_alignment, element_alignment(state.transformed_primitive_size));
+	const auto align = [](const unsigned int value, const size_t alignment) {
+		return (unsigned int)(((value + alignment - 1) / alignment) * alignment);
+	};
+	vector<uint2> offsets(count + 1); // .x = vertex offset, .y = primitive offset
+	for(size_t i = 0; i < count; i++) {
+		const deferred_draw& draw = deferred_draws[first + i];
+		offsets[i + 1].set(offsets[i].x + align(draw.vertex_count, vertex_alignment),
+						   offsets[i].y + align(draw.instance_primitive_count, primitive_alignment));
+	}
+	const unsigned int merged_vertex_count = offsets[count].x;
+	const unsigned int merged_primitive_count = offsets[count].y;
+	
+	restore_deferred_draw_state(deferred_draws[first]);
+	if(!setup_draw_state(PRIMITIVE_TYPE::TRIANGLE, merged_vertex_count, merged_primitive_count, 1)) return;
+	ocl->next_profiling_draw(); // all merged draws share one draw index
+	
+	// get merged scratch buffers
+	opencl::buffer_object* merged_transformed_buffer = acquire_scratch_buffer(state.transformed_scratch,
+																			   state.transformed_primitive_size * merged_primitive_count);
+	opencl::buffer_object* merged_bounds_buffer = acquire_scratch_buffer(state.primitive_bounds_scratch,
+																		 sizeof(float) * 4 * merged_primitive_count);
+	opencl::buffer_object* merged_vertices_buffer = acquire_scratch_buffer(state.transformed_vertices_scratch,
+																		   sizeof(float) * 4 * merged_vertex_count);
+	opencl::buffer_object* merged_index_buffer = acquire_scratch_buffer(state.merged_index_scratch,
+																		sizeof(unsigned int) * 3 * merged_primitive_count);
+	
+	vector<pair<const oclraster_program::oclraster_struct_info*, size_t>> output_structs; // + device specific struct size
+	for(const auto& tp_struct : state.transform_prog->get_structs()) {
+		if(tp_struct->type == oclraster_program::STRUCT_TYPE::OUTPUT) {
+			const size_t output_index = output_structs.size();
+			if(output_index >= state.user_transformed_scratch.size()) {
+				state.user_transformed_scratch.emplace_back();
+			}
+			const size_t struct_size = tp_struct->device_infos.at(active_device).struct_size;
+			state.user_transformed_buffers.push_back(acquire_scratch_buffer(state.user_transformed_scratch[output_index],
+																			struct_size * merged_vertex_count));
+			output_structs.emplace_back(tp_struct, struct_size);
+		}
+	}
 	
-	// delete user transformed buffers
-	for(const auto& ut_buffer : state.user_transformed_buffers) {
-		ocl->delete_buffer(ut_buffer);
+	// transform and process each draw into its part of the merged ranges
+	vector<opencl::buffer_object*> sub_buffers;
+	const auto create_sub_buffer = [&sub_buffers](const opencl::buffer_object* buffer, const size_t offset, const size_t size) {
+		opencl::buffer_object* sub_buffer = ocl->create_sub_buffer(buffer, opencl::BUFFER_FLAG::READ_WRITE, offset, size);
+		if(sub_buffer != nullptr) sub_buffers.push_back(sub_buffer);
+		return sub_buffer;
+	};
+	for(size_t i = 0; i < count; i++) {
+		const deferred_draw& draw = deferred_draws[first + i];
+		if(i > 0) restore_deferred_draw_state(draw);
+		
+		const unsigned int vertex_offset = offsets[i].x;
+		const unsigned int primitive_offset = offsets[i].y;
+		const unsigned int padded_vertex_count = offsets[i + 1].x - vertex_offset;
+		const unsigned int padded_primitive_count = offsets[i + 1].y - primitive_offset;
+		state.transformed_vertices_buffer = create_sub_buffer(merged_vertices_buffer,
+															  sizeof(float) * 4 * vertex_offset,
+															  sizeof(float) * 4 * padded_vertex_count);
+		state.transformed_buffer = create_sub_buffer(merged_transformed_buffer,
+													 state.transformed_primitive_size * primitive_offset,
+													 state.transformed_primitive_size * padded_primitive_count);
+		state.primitive_bounds_buffer = create_sub_buffer(merged_bounds_buffer,
+														  sizeof(float) * 4 * primitive_offset,
+														  sizeof(float) * 4 * padded_primitive_count);
+		opencl::buffer_object* index_sub_buffer = create_sub_buffer(merged_index_buffer,
+																	sizeof(unsigned int) * 3 * primitive_offset,
+																	sizeof(unsigned int) * 3 * padded_primitive_count);
+		bool valid_sub_buffers = (state.transformed_vertices_buffer != nullptr &&
+								  state.transformed_buffer != nullptr &&
+								  state.primitive_bounds_buffer != nullptr &&
+								  index_sub_buffer != nullptr);
+		for(size_t j = 0, output_count = output_structs.size(); j < output_count; j++) {
+			opencl::buffer_object* output_sub_buffer = create_sub_buffer(state.user_transformed_buffers[j],
+																		 output_structs[j].second * vertex_offset,
+																		 output_structs[j].second * padded_vertex_count);
+			if(output_sub_buffer == nullptr) {
+				valid_sub_buffers = false;
+				break;
+			}
+			bind_buffer(output_structs[j].first->object_name, *output_sub_buffer);
+		}
+		
+		const auto index_buffer = state.user_buffers.find("index_buffer");
+		if(!valid_sub_buffers || index_buffer == state.user_buffers.cend()) {
+			oclr_error("failed to merge draw call #%u!", i);
+		}
+		else {
+			state.vertex_count = draw.vertex_count;
+			state.primitive_count = draw.instance_primitive_count;
+			state.instance_primitive_count = draw.instance_primitive_count;
+			state.instance_index_count = draw.instance_primitive_count * 3;
+			transform.transform(state);
+			processing.process(state, PRIMITIVE_TYPE::TRIANGLE);
+			
+			// offset the indices of this draw by its vertex offset and write them into the merged index buffer
+			opencl_base::profiling_stage_scope profiling_scope(opencl_base::PROFILING_STAGE::PROCESSING);
+			ocl->use_kernel("PROCESSING.REBASE_INDICES");
+			ocl->set_kernel_argument(0, &index_buffer->second);
+			ocl->set_kernel_argument(1, index_sub_buffer);
+			ocl->set_kernel_argument(2, state.instance_index_count);
+			ocl->set_kernel_argument(3, vertex_offset);
+			ocl->set_kernel_range(ocl->compute_kernel_ranges(state.instance_index_count));
+			ocl->run_kernel();
+		}
+		
+		for(const auto& sub_buffer : sub_buffers) {
+			ocl->delete_buffer(sub_buffer);
+		}
+		sub_buffers.clear();
 	}
+	
+	// bin and rasterize all merged draws at once
+	setup_draw_state(PRIMITIVE_TYPE::TRIANGLE, merged_vertex_count, merged_primitive_count, 1);
+	
+	// per batch: the primitive offset of the draw it belongs to (-> draw-relative primitive ids in the rasterizer)
+	vector<unsigned int> batch_draw_offsets(merged_primitive_count / state.batch_size);
+	for(size_t i = 0; i < count; i++) {
+		for(unsigned int batch = offsets[i].y / state.batch_size; batch < offsets[i + 1].y / state.batch_size; batch++) {
+			batch_draw_offsets[batch] = offsets[i].y;
+		}
+	}
+	state.merged_draw_offsets_buffer = acquire_scratch_buffer(state.merged_draw_offsets_scratch,
+															  sizeof(unsigned int) * batch_draw_offsets.size());
+	if(state.merged_draw_offsets_buffer != nullptr) {
+		ocl->write_buffer(state.merged_draw_offsets_buffer, &batch_draw_offsets[0],
+						  0, sizeof(unsigned int) * batch_draw_offsets.size());
+	}
+	state.transformed_buffer = merged_transformed_buffer;
+	state.primitive_bounds_buffer = merged_bounds_buffer;
+	state.transformed_vertices_buffer = merged_vertices_buffer;
+	bind_buffer("index_buffer", *merged_index_buffer);
+	for(size_t j = 0, output_count = output_structs.size(); j < output_count; j++) {
+		bind_buffer(output_structs[j].first->object_name, *state.user_transformed_buffers[j]);
+	}
+	
+	const auto queue_buffer = binning.bin(state);
+	rasterization.rasterize(state, PRIMITIVE_TYPE::TRIANGLE, queue_buffer);
+	state.merged_draw_offsets_buffer = nullptr;
+	
 	state.user_transformed_buffers.clear();
+	
+	// -> one statistics entry for all merged draws
+	unsigned long long int draws_vertex_count = 0, draws_primitive_count = 0;
+	for(size_t i = 0; i < count; i++) {
+		draws_vertex_count += deferred_draws[first + i].vertex_count;
+		draws_primitive_count += deferred_draws[first + i].instance_primitive_count;
+	}
+	record_draw_statistics((unsigned int)count, draws_vertex_count, draws_primitive_count);
+}
+
+opencl::buffer_object* pipeline::acquire_scratch_buffer(draw_state::scratch_buffer& scratch, const size_t size) {
+	scratch.high_water_mark = std::max(scratch.high_water_mark, size);
+	if(scratch.buffer != nullptr && scratch.buffer->size >= size) {
+		state.scratch_stats.avoided_allocations++;
+		return scratch.buffer;
+	}
+	
+	// grow by at least 50%, so slowly increasing draw sizes don't cause a reallocation every time
+	const size_t new_size = (scratch.buffer == nullptr ? size : std::max(size, scratch.buffer->size + scratch.buffer->size / 2));
+	release_scratch_buffer(scratch);
+	scratch.buffer = ocl->create_buffer(scratch.flags, new_size);
+	if(scratch.buffer != nullptr) {
+		state.scratch_stats.allocated_size += scratch.buffer->size;
+		state.scratch_stats.peak_allocated_size = std::max(state.scratch_stats.peak_allocated_size,
+														   state.scratch_stats.allocated_size);
+	}
+	state.scratch_stats.allocations++;
+	return scratch.buffer;
+}
+
+void pipeline::release_scratch_buffer(draw_state::scratch_buffer& scratch) {
+	if(scratch.buffer == nullptr) return;
+	state.scratch_stats.allocated_size -= scratch.buffer->size;
+	ocl->delete_buffer(scratch.buffer);
+	scratch.buffer = nullptr;
+}
+
+void pipeline::trim_scratch_buffers(const bool release_all) {
+	const auto trim = [this, &release_all](draw_state::scratch_buffer& scratch) {
+		if(release_all || scratch.high_water_mark == 0) {
+			release_scratch_buffer(scratch);
+		}
+		else if(scratch.buffer != nullptr && scratch.buffer->size > scratch.high_water_mark) {
+			// shrink to the high-water mark
+			const size_t hwm = scratch.high_water_mark;
+			release_scratch_buffer(scratch);
+			acquire_scratch_buffer(scratch, hwm);
+		}
+		scratch.high_water_mark = 0;
+	};
+	trim(state.transformed_scratch);
+	trim(state.primitive_bounds_scratch);
+	trim(state.transformed_vertices_scratch);
+	trim(state.merged_index_scratch);
+	trim(state.merged_draw_offsets_scratch);
+	for(auto& scratch : state.user_transformed_scratch) {
+		trim(scratch);
+	}
+	while(!state.user_transformed_scratch.empty() &&
+		  state.user_transformed_scratch.back().buffer == nullptr) {
+		state.user_transformed_scratch.pop_back();
+	}
+	
+	// the bin queue is reallocated on demand
+	if(release_all) {
+		binning.trim_queue();
+	}
+}
+
+const draw_state::scratch_statistics& pipeline::get_scratch_statistics() const {
+	return state.last_scratch_stats;
+}
+
+const binning_stage::queue_statistics& pipeline::get_bin_queue_statistics() const {
+	return binning.get_queue_statistics();
+}
+
+void pipeline::set_collect_bin_statistics(const bool state_) {
+	collect_bin_statistics = state_;
+	binning.set_collect_statistics(collect_bin_statistics || (state.collect_statistics & 1u) != 0u);
+}
+
+bool pipeline::get_collect_bin_statistics() const {
+	return collect_bin_statistics;
+}
+
+binning_stage::bin_statistics pipeline::get_bin_statistics() const {
+	return binning.get_bin_statistics();
+}
+
+void pipeline::reset_bin_statistics() {
+	binning.reset_bin_statistics();
+	bin_statistics_snapshot = binning_stage::bin_statistics {};
+}
+
+draw_statistics& draw_statistics::operator+=(const draw_statistics& stats) {
+	draws += stats.draws;
+	vertices += stats.vertices;
+	primitives += stats.primitives;
+	culled_discarded += stats.culled_discarded;
+	culled_near_plane += stats.culled_near_plane;
+	culled_frustum += stats.culled_frustum;
+	culled_area += stats.culled_area;
+	bin_pairs += stats.bin_pairs;
+	fragments_tested += stats.fragments_tested;
+	fragments_depth_passed += stats.fragments_depth_passed;
+	rasterization_invocations += stats.rasterization_invocations;
+	fragments_written += stats.fragments_written;
+	return *this;
+}
+
+void pipeline::set_collect_statistics(const bool state_) {
+	if(state_ == ((state.collect_statistics & 1u) != 0u)) return;
+	flush(); // recorded draws belong to the previous mode
+	resolve_draw_statistics(); // the bin pair deltas of these draws are relative to the current snapshot
+	if(state_) {
+		state.collect_statistics |= 1u;
+		// the per-draw bin pair counts are computed from the binner counters
+		binning.set_collect_statistics(true);
+		bin_statistics_snapshot = binning.get_bin_statistics();
+		ocl->write_buffer(state.statistics_buffer, zero_statistics);
+	}
+	else {
+		state.collect_statistics &= ~1u;
+		binning.set_collect_statistics(collect_bin_statistics);
+	}
+}
+
+bool pipeline::get_collect_statistics() const {
+	return ((state.collect_statistics & 1u) != 0u);
+}
+
+const vector<draw_statistics>& pipeline::get_draw_statistics() const {
+	return last_draw_stats;
+}
+
+draw_statistics pipeline::get_frame_statistics() const {
+	draw_statistics frame_stats;
+	for(const auto& stats : last_draw_stats) {
+		frame_stats += stats;
+	}
+	return frame_stats;
+}
+
+void pipeline::record_draw_statistics(const unsigned int draw_count,
+									  const unsigned long long int vertex_count,
+									  const unsigned long long int primitive_count) {
+	if((state.collect_statistics & 1u) == 0u) return;
+	
+	// copy the device counters and the accumulated binner counters into the record of this draw and reset
+	// the counters, all on the device (-> doesn't wait for the draw, the records are read back on swap)
+	const size_t record_index = draw_stats.size();
+	if(!reserve_statistics_records(record_index + 1)) return;
+	const size_t record_offset = sizeof(unsigned int) * statistics_record_size * record_index;
+	ocl->copy_buffer(state.statistics_buffer, statistics_records_buffer,
+					 0, record_offset, sizeof(unsigned int) * statistics_counter_count);
+	ocl->copy_buffer(binning.get_statistics_buffer(), statistics_records_buffer,
+					 0, record_offset + sizeof(unsigned int) * statistics_counter_count, sizeof(unsigned int) * 3);
+	ocl->write_buffer(state.statistics_buffer, zero_statistics);
+	
+	draw_statistics stats;
+	stats.draws = draw_count;
+	stats.vertices = vertex_count;
+	stats.primitives = primitive_count;
+	draw_stats.push_back(stats);
+}
+
+bool pipeline::reserve_statistics_records(const size_t record_count) {
+	if(statistics_records_buffer != nullptr && statistics_record_capacity >= record_count) {
+		return true;
+	}
+	
+	// grow by at least 2x (the capacity is kept across frames)
+	const size_t new_capacity = std::max(std::max(record_count, statistics_record_capacity * 2), size_t(64));
+	opencl::buffer_object* records_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE |
+															   opencl::BUFFER_FLAG::BLOCK_ON_READ,
+															   sizeof(unsigned int) * statistics_record_size * new_capacity);
+	if(records_buffer == nullptr) {
+		oclr_error("failed to create the pipeline statistics buffer (%u draws)!", new_capacity);
+		return false;
+	}
+	if(statistics_records_buffer != nullptr) {
+		// keep the records of the current frame
+		if(draw_stats.size() > 0) {
+			ocl->copy_buffer(statistics_records_buffer, records_buffer, 0, 0,
+							 sizeof(unsigned int) * statistics_record_size * draw_stats.size());
+		}
+		ocl->delete_buffer(statistics_records_buffer);
+	}
+	statistics_records_buffer = records_buffer;
+	statistics_record_capacity = new_capacity;
+	return true;
+}
+
+void pipeline::resolve_draw_statistics() {
+	const size_t record_count = draw_stats.size() - resolved_draw_stats;
+	if(record_count == 0 || statistics_records_buffer == nullptr) return;
+	
+	// read back all unresolved records at once (-> blocks until these draws have finished)
+	vector<unsigned int> records(statistics_record_size * record_count);
+	ocl->read_buffer(&records[0], statistics_records_buffer,
+					 sizeof(unsigned int) * statistics_record_size * resolved_draw_stats,
+					 sizeof(unsigned int) * records.size());
+	
+	for(size_t i = 0; i < record_count; i++) {
+		const unsigned int* counters = &records[i * statistics_record_size];
+		draw_statistics& stats = draw_stats[resolved_draw_stats + i];
+		
+		// emitted bin/primitive pairs = pairs that pass the edge test, but aren't rejected by the depth bounds test
+		binning_stage::bin_statistics bin_stats;
+		bin_stats.aabb_pairs = counters[statistics_counter_count];
+		bin_stats.edge_pairs = counters[statistics_counter_count + 1];
+		bin_stats.depth_rejected_pairs = counters[statistics_counter_count + 2];
+		const unsigned int emitted_pairs = bin_stats.edge_pairs - bin_stats.depth_rejected_pairs;
+		const unsigned int prev_emitted_pairs = (bin_statistics_snapshot.edge_pairs -
+												 bin_statistics_snapshot.depth_rejected_pairs);
+		bin_statistics_snapshot = bin_stats;
+		
+		stats.culled_discarded = counters[0];
+		stats.culled_near_plane = counters[1];
+		stats.culled_frustum = counters[2];
+		stats.culled_area = counters[3];
+		stats.bin_pairs = emitted_pairs - prev_emitted_pairs;
+		stats.fragments_tested = counters[4];
+		stats.fragments_depth_passed = counters[5];
+		stats.rasterization_invocations = counters[6];
+		stats.fragments_written = counters[7];
+	}
+	resolved_draw_stats = draw_stats.size();
+}
+
+void pipeline::set_debug_outputs(const bool state_) {
+	if(state_ == ((state.collect_statistics & 2u) != 0u)) return;
+	flush();
+	if(state_) {
+		state.collect_statistics |= 2u;
+	}
+	else {
+		state.collect_statistics &= ~2u;
+		delete_debug_outputs();
+	}
+}
+
+bool pipeline::get_debug_outputs() const {
+	return ((state.collect_statistics & 2u) != 0u);
+}
+
+static uint2 debug_output_bin_count(const uint2& framebuffer_size, const uint2& bin_size) {
+	return uint2 {
+		(framebuffer_size.x + bin_size.x - 1u) / bin_size.x,
+		(framebuffer_size.y + bin_size.y - 1u) / bin_size.y
+	};
+}
+
+void pipeline::resize_debug_outputs(const uint2& framebuffer_size) {
+	// grow-only: the outputs always cover the largest framebuffer drawn to (-> no reallocation when
+	// draws alternate between differently sized framebuffers)
+	if(state.overdraw_buffer != nullptr &&
+	   debug_output_size.x >= framebuffer_size.x && debug_output_size.y >= framebuffer_size.y) {
+		return;
+	}
+	const uint2 new_size {
+		std::max(debug_output_size.x, framebuffer_size.x),
+		std::max(debug_output_size.y, framebuffer_size.y)
+	};
+	const uint2 bin_count = debug_output_bin_count(new_size, state.bin_size);
+	opencl::buffer_object* overdraw_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE |
+																opencl::BUFFER_FLAG::BLOCK_ON_READ |
+																opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
+																sizeof(unsigned int) * new_size.x * new_size.y);
+	opencl::buffer_object* bin_primitives_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE |
+																	  opencl::BUFFER_FLAG::BLOCK_ON_READ |
+																	  opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
+																	  sizeof(unsigned int) * bin_count.x * bin_count.y);
+	if(overdraw_buffer == nullptr || bin_primitives_buffer == nullptr) {
+		// the previous buffers are too small for this framebuffer -> disable the debug outputs
+		oclr_error("failed to create the debug output buffers, disabling debug outputs!");
+		if(overdraw_buffer != nullptr) ocl->delete_buffer(overdraw_buffer);
+		if(bin_primitives_buffer != nullptr) ocl->delete_buffer(bin_primitives_buffer);
+		delete_debug_outputs();
+		state.collect_statistics &= ~2u;
+		return;
+	}
+	
+	opencl::buffer_object* prev_overdraw_buffer = state.overdraw_buffer;
+	opencl::buffer_object* prev_bin_primitives_buffer = state.bin_primitives_buffer;
+	const uint2 prev_size = debug_output_size;
+	const uint2 prev_bin_count = debug_output_bin_count(prev_size, state.bin_size);
+	state.overdraw_buffer = overdraw_buffer;
+	state.bin_primitives_buffer = bin_primitives_buffer;
+	debug_output_size = new_size;
+	state.debug_output_pitch = new_size.x;
+	clear_debug_outputs();
+	
+	// keep the counts of the current frame (-> copy them into the top-left part of the new buffers)
+	if(prev_overdraw_buffer != nullptr) {
+		ocl->copy_buffer_rect(prev_overdraw_buffer, state.overdraw_buffer,
+							  size3 { 0, 0, 0 }, size3 { 0, 0, 0 },
+							  size3 { sizeof(unsigned int) * prev_size.x, prev_size.y, 1 },
+							  sizeof(unsigned int) * prev_size.x, 0,
+							  sizeof(unsigned int) * new_size.x, 0);
+		ocl->copy_buffer_rect(prev_bin_primitives_buffer, state.bin_primitives_buffer,
+							  size3 { 0, 0, 0 }, size3 { 0, 0, 0 },
+							  size3 { sizeof(unsigned int) * prev_bin_count.x, prev_bin_count.y, 1 },
+							  sizeof(unsigned int) * prev_bin_count.x, 0,
+							  sizeof(unsigned int) * bin_count.x, 0);
+		ocl->delete_buffer(prev_overdraw_buffer);
+		ocl->delete_buffer(prev_bin_primitives_buffer);
+	}
+}
+
+void pipeline::clear_debug_outputs() {
+	const uint2 bin_count = debug_output_bin_count(debug_output_size, state.bin_size);
+	const vector<unsigned int> zero_overdraw(debug_output_size.x * debug_output_size.y, 0u);
+	const vector<unsigned int> zero_bin_primitives(bin_count.x * bin_count.y, 0u);
+	ocl->write_buffer(state.overdraw_buffer, &zero_overdraw[0]);
+	ocl->write_buffer(state.bin_primitives_buffer, &zero_bin_primitives[0]);
+}
+
+void pipeline::delete_debug_outputs() {
+	if(state.overdraw_buffer != nullptr) {
+		ocl->delete_buffer(state.overdraw_buffer);
+		state.overdraw_buffer = nullptr;
+	}
+	if(state.bin_primitives_buffer != nullptr) {
+		ocl->delete_buffer(state.bin_primitives_buffer);
+		state.bin_primitives_buffer = nullptr;
+	}
+	debug_output_size = uint2 { 0u, 0u };
+	state.debug_output_pitch = 0;
+}
+
+vector<unsigned int> pipeline::get_debug_output(const DEBUG_OUTPUT output, uint2& size) {
+	flush();
+	if(state.overdraw_buffer == nullptr) {
+		size = uint2 { 0u, 0u };
+		return vector<unsigned int> {};
+	}
+	
+	size = (output == DEBUG_OUTPUT::OVERDRAW ? debug_output_size : debug_output_bin_count(debug_output_size, state.bin_size));
+	vector<unsigned int> counts(size.x * size.y);
+	ocl->read_buffer(&counts[0], (output == DEBUG_OUTPUT::OVERDRAW ? state.overdraw_buffer : state.bin_primitives_buffer));
+	return counts;
+}
+
+image* pipeline::create_debug_heatmap(const DEBUG_OUTPUT output, const unsigned int max_count) {
+	uint2 size;
+	const vector<unsigned int> counts = get_debug_output(output, size);
+	if(counts.empty()) return nullptr;
+	
+	const unsigned int max_value = (max_count != 0 ? max_count :
+									std::max(*max_element(counts.cbegin(), counts.cend()), 1u));
+	// black -> blue -> green -> yellow -> red
+	static const array<float3, 5> gradient {{
+		float3 { 0.0f, 0.0f, 0.0f },
+		float3 { 0.0f, 0.0f, 1.0f },
+		float3 { 0.0f, 1.0f, 0.0f },
+		float3 { 1.0f, 1.0f, 0.0f },
+		float3 { 1.0f, 0.0f, 0.0f }
+	}};
+	vector<uchar4> pixels(counts.size());
+	for(size_t i = 0, count = counts.size(); i < count; i++) {
+		const float value = (std::min(float(counts[i]) / float(max_value), 1.0f) * float(gradient.size() - 1));
+		const size_t idx = std::min(size_t(value), gradient.size() - 2);
+		const float3 color = float3::mix(gradient[idx + 1], gradient[idx], value - float(idx)) * 255.0f;
+		pixels[i] = uchar4 { (unsigned char)color.x, (unsigned char)color.y, (unsigned char)color.z, 255 };
+	}
+	return new image(size.x, size.y, image::BACKING::BUFFER, IMAGE_TYPE::UINT_8, IMAGE_CHANNEL::RGBA, &pixels[0]);
+}
+
+void pipeline::set_depth_bounds_culling(const bool state_) {
+	binning.set_depth_bounds_culling(state_);
+}
+
+bool pipeline::get_depth_bounds_culling() const {
+	return binning.get_depth_bounds_culling();
+}
+
+void pipeline::invalidate_depth_bounds() {
+	binning.invalidate_depth_bounds();
+}
+
+void pipeline::clear_depth_bounds(const image* depth_buffer, const uint2& framebuffer_size,
+								  const float clear_depth, const bool partial) {
+	binning.clear_depth_bounds(depth_buffer, framebuffer_size, clear_depth, partial);
+}
+
+void pipeline::set_binning(const BINNING binning_) {
+	if(binning_ == state.binning) return;
+	flush();
+	state.binning = binning_;
+}
+
+BINNING pipeline::get_binning() const {
+	return state.binning;
+}
+
+void pipeline::set_coarse_binning_threshold(const unsigned int bin_count_threshold) {
+	binning.set_coarse_binning_threshold(bin_count_threshold);
+}
+
+unsigned int pipeline::get_coarse_binning_threshold() const {
+	return binning.get_coarse_binning_threshold();
 }
 
 void pipeline::bind_buffer(const string& name, const opencl_base::buffer_object& buffer) {
@@ -510,6 +1403,14 @@ const uint4& pipeline::get_scissor_rectangle() const {
 	return state.scissor_rectangle;
 }
 
+void pipeline::set_fixed_point_rasterization(const bool fixed_point_state) {
+	state.fixed_point_rasterization = fixed_point_state;
+}
+
+bool pipeline::get_fixed_point_rasterization() const {
+	return state.fixed_point_rasterization;
+}
+
 void pipeline::set_depth_function(const DEPTH_FUNCTION depth_func,
 								  const string custom_depth_func) {
 	state.depth.depth_func = depth_func;
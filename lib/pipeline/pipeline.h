@@ -38,9 +38,10 @@ struct draw_state {
 		struct {
 			unsigned int scissor_test : 1;
 			unsigned int backface_culling : 1;
+			unsigned int fixed_point_rasterization : 1;
 			
 			//
-			unsigned int _unused : 30;
+			unsigned int _unused : 29;
 		};
 		unsigned int flags;
 	};
@@ -48,6 +49,7 @@ struct draw_state {
 	//
 	PROJECTION projection = PROJECTION::PERSPECTIVE;
 	depth_state depth;
+	BINNING binning = BINNING::GATHER;
 	uint4 scissor_rectangle { 0u, 0u, ~0u, ~0u };
 	uint4 scissor_rectangle_abs { 0u, 0u, ~0u, ~0u }; // absolute, inclusive
 	
@@ -62,23 +64,60 @@ struct draw_state {
 	opencl::buffer_object* transformed_vertices_buffer = nullptr;
 	opencl::buffer_object* transformed_buffer = nullptr;
 	opencl::buffer_object* primitive_bounds_buffer = nullptr;
+	// per-bin depth bounds of the active depth buffer (owned by the binning stage, set on each binning call)
+	opencl::buffer_object* depth_bounds_buffer = nullptr;
+	unsigned int depth_bounds_pitch = 0;
+	bool update_depth_bounds = false;
 	unordered_map<string, const opencl_base::buffer_object&> user_buffers;
 	unordered_map<string, const image&> user_images;
 	vector<opencl::buffer_object*> user_transformed_buffers;
 	
+	// persistent, grow-only scratch buffers (reused across draw calls, the buffers above point into these)
+	struct scratch_buffer {
+		opencl::buffer_object* buffer = nullptr;
+		size_t high_water_mark = 0; // max requested size since the last trim
+		opencl::BUFFER_FLAG flags = opencl::BUFFER_FLAG::READ_WRITE;
+	};
+	scratch_buffer transformed_scratch;
+	scratch_buffer primitive_bounds_scratch;
+	scratch_buffer transformed_vertices_scratch;
+	vector<scratch_buffer> user_transformed_scratch;
+	scratch_buffer merged_index_scratch; // only used for merged deferred draws
+	scratch_buffer merged_draw_offsets_scratch; // only used for merged deferred draws
+	
+	struct scratch_statistics {
+		unsigned int allocations { 0 }; // scratch buffer (re)allocations
+		unsigned int avoided_allocations { 0 }; // requests that could be served by an existing scratch buffer
+		size_t allocated_size { 0 }; // currently allocated scratch memory
+		size_t peak_allocated_size { 0 };
+	};
+	scratch_statistics scratch_stats; // current frame
+	scratch_statistics last_scratch_stats; // last completed frame
+	
+	// pipeline statistics (owned by the pipeline, see pipeline::set_collect_statistics):
+	// bit 0 of collect_statistics = statistics counters, bit 1 = per-pixel/per-bin debug outputs
+	// note: the debug output buffers are only allocated while debug outputs are enabled
+	opencl::buffer_object* statistics_buffer = nullptr;
+	opencl::buffer_object* overdraw_buffer = nullptr;
+	opencl::buffer_object* bin_primitives_buffer = nullptr;
+	unsigned int debug_output_pitch = 0; // row pitch of the overdraw buffer in pixels (-> largest framebuffer width)
+	unsigned int collect_statistics = 0;
+	
 	//
 	transform_program* transform_prog = nullptr;
 	rasterization_program* rasterize_prog = nullptr;
 	
-	//
-	const uint2 bin_size { OCLRASTER_BIN_SIZE };
+	// bin and batch size are set from the tuning parameters on pipeline creation
+	uint2 bin_size { OCLRASTER_BIN_SIZE };
 	uint2 bin_count { 1, 1 };
 	uint2 bin_offset { 0, 0 };
-	const unsigned int batch_size { OCLRASTER_BATCH_SIZE };
+	unsigned int batch_size { OCLRASTER_BATCH_SIZE };
 	unsigned int batch_count { 0 };
 	unsigned int primitive_count { 0 };
 	unsigned int instance_primitive_count { 0 };
 	unsigned int instance_index_count { 0 };
+	unsigned int primitive_offset { 0 }; // offset of the current chunk inside the draw call (chunked draws)
+	opencl::buffer_object* merged_draw_offsets_buffer = nullptr; // per batch: primitive offset of its draw (merged draws)
 	unsigned int vertex_count { 0 };
 	unsigned int instance_count { 1 };
 	
@@ -96,6 +135,31 @@ struct draw_state {
 	opencl::buffer_object* camera_buffer = nullptr;
 };
 
+// per-draw/per-frame pipeline statistics (similar to gl pipeline statistics queries)
+struct draw_statistics {
+	unsigned long long int draws { 0 }; // #draw calls (merged deferred draws are recorded as a single entry)
+	unsigned long long int vertices { 0 }; // #transformed vertices (-> transform program invocations)
+	unsigned long long int primitives { 0 }; // #submitted primitives
+	// culled primitives (by reason)
+	unsigned long long int culled_discarded { 0 }; // a vertex was discarded by the transform program
+	unsigned long long int culled_near_plane { 0 }; // all vertices are behind the camera
+	unsigned long long int culled_frustum { 0 }; // outside of the view frustum or scissor rectangle
+	unsigned long long int culled_area { 0 }; // backfacing, tiny or zero area
+	unsigned long long int bin_pairs { 0 }; // #bin/primitive pairs emitted by the binner
+	unsigned long long int fragments_tested { 0 }; // #fragments inside a primitive (-> depth tested)
+	unsigned long long int fragments_depth_passed { 0 };
+	unsigned long long int rasterization_invocations { 0 }; // #rasterization program invocations
+	unsigned long long int fragments_written { 0 }; // #fragments that weren't discarded and passed all tests
+	
+	draw_statistics& operator+=(const draw_statistics& stats);
+};
+
+// debug outputs (see pipeline::set_debug_outputs)
+enum class DEBUG_OUTPUT : unsigned int {
+	OVERDRAW, //!< #written fragments per pixel
+	BIN_PRIMITIVES //!< #binned primitives per rasterized bin
+};
+
 //
 enum class PRIMITIVE_TYPE : unsigned int {
 	TRIANGLE,
@@ -110,8 +174,15 @@ public:
 	virtual ~pipeline();
 	
 	// "swaps"/displays the default framebuffer (-> blits the default framebuffer to the window framebuffer)
+	// in headless mode, nothing is displayed and the frame callback is called instead (if one is set)
 	void swap();
 	
+	// headless mode only: called on swap with the mapped default framebuffer color data (rgba8, tightly packed).
+	// the data is not copied and only valid inside the callback. without a callback, the default framebuffer
+	// can also be mapped directly (-> get_default_framebuffer()->get_image(0)->map(...)) before swap
+	typedef std::function<void(const unsigned char* data, const uint2& size)> frame_callback;
+	void set_frame_callback(frame_callback callback);
+	
 	// binds a transform_program or rasterization_program (or any derived class thereof)
 	template <class program_type> void bind_program(const program_type& program);
 	
@@ -138,6 +209,26 @@ public:
 						const pair<unsigned int, unsigned int> element_range,
 						const unsigned int instance_count);
 	
+	// draw memory budget in bytes (0 = unlimited, default is taken from the config, where it is specified in MB)
+	// draws whose internal buffers would exceed this budget (or whose bin queue would exceed the max
+	// device allocation size) are automatically split into multiple chunks of primitives, which are
+	// processed one after another (the primitive_id inside a rasterization program stays relative to the draw call).
+	// note that transformed vertex data can't be split up.
+	void set_draw_memory_budget(const size_t budget_bytes);
+	size_t get_draw_memory_budget() const; // in bytes
+	
+	// deferred drawing
+	// when enabled, draw calls are only recorded and executed when the pipeline is flushed (at the latest on swap).
+	// consecutive triangle draws that use the same programs, framebuffer, draw state and camera setup, and that
+	// only differ in their index buffer and transform program input buffers, are transformed and processed into
+	// one primitive range, binned together and rasterized in a single pass (in submission order).
+	// NOTE: buffers and images used by recorded draws must not be modified until these have been flushed
+	// NOTE: for merged draws, the primitive_id inside the rasterization program is still relative to its own draw call
+	void set_deferred_drawing(const bool state);
+	bool get_deferred_drawing() const;
+	void flush();
+	size_t get_deferred_draw_count() const;
+	
 	// camera
 	// NOTE: the camera class and these functions are only provided to make things easier.
 	// meaning, they don't have to be used if you don't want to use them and roll your own camera code instead.
@@ -192,6 +283,75 @@ public:
 	void set_scissor_rectangle(const uint2& offset, const uint2& size);
 	const uint4& get_scissor_rectangle() const;
 	
+	// fixed-point rasterization (orthographic rendering only, ignored for perspective rendering)
+	// vertices are snapped to a 1/OCLRASTER_SUBPIXEL_SCALE pixel grid and edge functions are evaluated
+	// exactly with integer math (-> watertight edges, no cracks or double hits between adjacent triangles)
+	void set_fixed_point_rasterization(const bool state);
+	bool get_fixed_point_rasterization() const;
+	
+	// scratch buffers
+	// releases all scratch memory above the per-buffer high-water mark since the last trim
+	// (or all scratch memory + the bin queue if release_all is set) and resets the high-water marks
+	void trim_scratch_buffers(const bool release_all = false);
+	// allocation counters are reset every frame (on swap), this returns the counters of the last frame
+	const draw_state::scratch_statistics& get_scratch_statistics() const;
+	
+	// bin queue size and growth/overflow counters (the bin queue is sized on demand)
+	const binning_stage::queue_statistics& get_bin_queue_statistics() const;
+	
+	// bin/primitive pair counters: #pairs whose aabb overlaps a bin vs. #pairs that pass the exact edge test
+	// (-> shows how many pairs the edge test rejects) and #pairs thereof that are rejected by the depth bounds test.
+	// disabled by default, counters accumulate until reset
+	void set_collect_bin_statistics(const bool state);
+	bool get_collect_bin_statistics() const;
+	binning_stage::bin_statistics get_bin_statistics() const;
+	void reset_bin_statistics();
+	
+	// pipeline statistics (disabled by default): per-draw counters of the processed vertices, primitives,
+	// culled primitives, bin/primitive pairs and fragments (-> draw_statistics)
+	// note: the counters of each draw are copied on the device, they are only read back once per frame (on swap)
+	void set_collect_statistics(const bool state);
+	bool get_collect_statistics() const;
+	// counters are reset every frame (on swap), these return the counters of the last frame
+	const vector<draw_statistics>& get_draw_statistics() const;
+	draw_statistics get_frame_statistics() const;
+	
+	// debug outputs (disabled by default): per-pixel overdraw (#written fragments) and per-bin primitive counts
+	// of the current frame, these are cleared on swap (after the frame callback has been called)
+	// note: the outputs cover the largest framebuffer drawn to since they were enabled (smaller framebuffers
+	// use the top-left part), growing them keeps the counts of the current frame
+	void set_debug_outputs(const bool state);
+	bool get_debug_outputs() const;
+	// returns the counts in row-major order (size = debug output size or its #bins), this blocks until all draws have finished
+	vector<unsigned int> get_debug_output(const DEBUG_OUTPUT output, uint2& size);
+	// creates an rgba8 heatmap of the counts (black -> blue -> green -> yellow -> red, red = max_count or the max count if 0)
+	// note: the returned image must be deleted by the user
+	image* create_debug_heatmap(const DEBUG_OUTPUT output, const unsigned int max_count = 0);
+	
+	// per-bin depth bounds culling (hi-z, enabled by default): the binner rejects primitives that are occluded
+	// within a bin (the bounds are updated by the rasterizer and reset by framebuffer::clear)
+	// note: if the depth buffer is written in any other way, invalidate_depth_bounds must be called
+	void set_depth_bounds_culling(const bool state);
+	bool get_depth_bounds_culling() const;
+	void invalidate_depth_bounds();
+	// only used internally (framebuffer::clear)
+	void clear_depth_bounds(const image* depth_buffer, const uint2& framebuffer_size,
+							const float clear_depth, const bool partial);
+	
+	// binning mode (default is taken from the config)
+	// GATHER: every bin scans all primitive batches and stores a fixed size queue per bin and batch
+	// SCATTER: every primitive is scattered into the bins it overlaps, which results in compact per-bin lists
+	// (the rasterizer then skips empty bins and batches entirely)
+	// note: changing the binning mode flushes all deferred draws
+	void set_binning(const BINNING binning);
+	BINNING get_binning() const;
+	
+	// two-level (coarse/fine) binning for large framebuffers, only used by the gather binner:
+	// draws with at least this many bins first bin all primitives into coarse tiles of 4x4 bins
+	// (default is taken from the config, 0 = disabled)
+	void set_coarse_binning_threshold(const unsigned int bin_count_threshold);
+	unsigned int get_coarse_binning_threshold() const;
+	
 	//
 	void _set_fxaa_state(const bool state);
 	bool _get_fxaa_state() const;
@@ -209,8 +369,76 @@ protected:
 	framebuffer default_framebuffer;
 	bool fxaa_state { true };
 	
-	// map/copy fbo
+	// recorded draw call + all draw state necessary to execute it later on
+	struct deferred_draw {
+		PRIMITIVE_TYPE type;
+		unsigned int vertex_count;
+		unsigned int instance_primitive_count;
+		unsigned int instance_count;
+		unsigned int flags;
+		PROJECTION projection;
+		depth_state depth;
+		uint4 scissor_rectangle;
+		framebuffer* active_framebuffer;
+		transform_program* transform_prog;
+		rasterization_program* rasterize_prog;
+		vector<pair<string, const opencl_base::buffer_object*>> user_buffers; // sorted by name
+		vector<pair<string, const image*>> user_images; // sorted by name
+		draw_state::camera_setup cam_setup;
+	};
+	bool deferred_drawing { false };
+	vector<deferred_draw> deferred_draws;
+	deferred_draw make_deferred_draw(const PRIMITIVE_TYPE type,
+									 const unsigned int vertex_count,
+									 const unsigned int instance_primitive_count,
+									 const unsigned int instance_count) const;
+	void restore_deferred_draw_state(const deferred_draw& draw);
+	bool is_mergeable_draw(const deferred_draw& first_draw, const deferred_draw& draw) const;
+	void execute_merged_draws(const size_t first, const size_t count);
+	
+	//
+	size_t draw_memory_budget { 0 }; // in bytes
+	unsigned int compute_chunk_size(const size_t vertex_memory) const;
+	void rasterize_primitives(const PRIMITIVE_TYPE type);
+	
+	//
+	bool setup_draw_state(const PRIMITIVE_TYPE type,
+						  const unsigned int vertex_count,
+						  const unsigned int instance_primitive_count,
+						  const unsigned int instance_count);
+	void execute_draw(const PRIMITIVE_TYPE type,
+					  const unsigned int vertex_count,
+					  const unsigned int instance_primitive_count,
+					  const unsigned int instance_count);
+	
+	// pipeline statistics
+	bool collect_bin_statistics { false }; // user setting (the binner always collects while statistics are enabled)
+	binning_stage::bin_statistics bin_statistics_snapshot; // -> per-draw bin pair deltas
+	vector<draw_statistics> draw_stats; // current frame
+	vector<draw_statistics> last_draw_stats; // last completed frame
+	// per-draw device counters of the current frame (copied on the device, read back at once on swap)
+	opencl::buffer_object* statistics_records_buffer = nullptr;
+	size_t statistics_record_capacity { 0 }; // #draws
+	size_t resolved_draw_stats { 0 }; // #draw_stats entries whose device counters have been read back
+	uint2 debug_output_size { 0u, 0u };
+	void record_draw_statistics(const unsigned int draw_count,
+								const unsigned long long int vertex_count,
+								const unsigned long long int primitive_count);
+	bool reserve_statistics_records(const size_t record_count);
+	void resolve_draw_statistics();
+	void resize_debug_outputs(const uint2& framebuffer_size);
+	void clear_debug_outputs();
+	void delete_debug_outputs();
+	
+	//
+	opencl::buffer_object* acquire_scratch_buffer(draw_state::scratch_buffer& scratch, const size_t size);
+	void release_scratch_buffer(draw_state::scratch_buffer& scratch);
+	
+	// map/copy fbo (not used in headless mode)
 	GLuint copy_fbo_id { 0 }, copy_fbo_tex_id { 0 };
+	void create_copy_framebuffer(const uint2& scaled_size);
+	void display_framebuffer();
+	frame_callback frame_cb;
 #if defined(OCLRASTER_IOS)
 	GLuint vbo_fullscreen_triangle { 0 };
 #endif
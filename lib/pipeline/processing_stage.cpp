@@ -27,8 +27,11 @@ processing_stage::~processing_stage() {
 }
 
 void processing_stage::process(draw_state& state, const PRIMITIVE_TYPE type) {
+	opencl_base::profiling_stage_scope profiling_scope(opencl_base::PROFILING_STAGE::PROCESSING);
+	
 	// -> 1D kernel, with max #work-items per work-group
-	ocl->use_kernel(string("PROCESSING.") + (state.projection == PROJECTION::PERSPECTIVE ? "PERSPECTIVE" : "ORTHOGRAPHIC"));
+	ocl->use_kernel(state.projection == PROJECTION::PERSPECTIVE ? "PROCESSING.PERSPECTIVE" :
+					(state.fixed_point_rasterization ? "PROCESSING.ORTHOGRAPHIC.FIXED_POINT" : "PROCESSING.ORTHOGRAPHIC"));
 	
 	unsigned int argc = 0;
 	
@@ -48,7 +51,13 @@ void processing_stage::process(draw_state& state, const PRIMITIVE_TYPE type) {
 	ocl->set_kernel_argument(argc++, state.primitive_count);
 	ocl->set_kernel_argument(argc++, state.instance_primitive_count);
 	ocl->set_kernel_argument(argc++, state.instance_index_count);
+	ocl->set_kernel_argument(argc++, state.primitive_offset);
 	ocl->set_kernel_argument(argc++, state.scissor_rectangle_abs);
-	ocl->set_kernel_range(ocl->compute_kernel_ranges(state.primitive_count));
+	ocl->set_kernel_argument(argc++, state.statistics_buffer);
+	ocl->set_kernel_argument(argc++, state.collect_statistics);
+	// note: this also covers the padding primitives up to the next batch boundary (these are marked as culled)
+	const unsigned int padded_primitive_count = (((state.primitive_count + state.batch_size - 1) / state.batch_size) *
+												 state.batch_size);
+	ocl->set_kernel_range(ocl->compute_kernel_ranges(padded_primitive_count));
 	ocl->run_kernel();
 }
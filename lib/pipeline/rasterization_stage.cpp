@@ -36,22 +36,24 @@ rasterization_stage::~rasterization_stage() {
 void rasterization_stage::rasterize(draw_state& state,
 									const PRIMITIVE_TYPE type,
 									const opencl_base::buffer_object* queue_buffer) {
+	if(queue_buffer == nullptr) return; // binning failed
+	opencl_base::profiling_stage_scope profiling_scope(opencl_base::PROFILING_STAGE::RASTERIZATION);
+	
 	////
 	// render / rasterization
 	oclraster_program::kernel_spec spec;
 	if(!create_kernel_spec(state, *state.rasterize_prog, spec)) {
 		return;
 	}
+	// only affect the rasterization program
+	spec.binning = state.binning;
+	spec.fixed_point = (state.projection == PROJECTION::ORTHOGRAPHIC && state.fixed_point_rasterization);
 	ocl->use_kernel(state.rasterize_prog->get_kernel(spec));
 	
 	// determine per-bin work-group size and how many iterations/splits are necessary per bin
 	const size_t bin_size = state.bin_size.x * state.bin_size.y;
-	size_t wg_size = ocl->get_kernel_work_group_size();;
-	if(ocl->get_active_device()->type >= opencl::DEVICE_TYPE::CPU0 &&
-	   ocl->get_active_device()->type <= opencl::DEVICE_TYPE::CPU255) {
-		// for whatever reason, using a work-group size of 1 runs a lot faster than using 128 (most cpu implementations)
-		wg_size = 1;
-	}
+	// note: this defaults to 1 on cpus (see opencl_base::load_tuning)
+	const size_t wg_size = ocl->get_tuned_work_group_size(ocl->get_tuning().rasterization_wg_size);
 	
 	const size_t local_size = std::min(wg_size, bin_size);
 	const size_t intra_bin_groups = (bin_size / local_size) + (bin_size % local_size != 0 ? 1 : 0);
@@ -78,8 +80,21 @@ void rasterization_stage::rasterize(draw_state& state,
 	ocl->set_kernel_argument(argc++, (underlying_type<PRIMITIVE_TYPE>::type)type);
 	ocl->set_kernel_argument(argc++, state.instance_primitive_count);
 	ocl->set_kernel_argument(argc++, state.instance_index_count);
+	ocl->set_kernel_argument(argc++, state.primitive_offset);
+	ocl->set_kernel_argument(argc++, (state.merged_draw_offsets_buffer != nullptr ? state.merged_draw_offsets_buffer : state.statistics_buffer));
+	ocl->set_kernel_argument(argc++, (unsigned int)(state.merged_draw_offsets_buffer != nullptr ? 1 : 0));
 	ocl->set_kernel_argument(argc++, state.framebuffer_size);
 	ocl->set_kernel_argument(argc++, state.scissor_rectangle_abs);
+	ocl->set_kernel_argument(argc++, state.depth_bounds_buffer);
+	ocl->set_kernel_argument(argc++, state.depth_bounds_pitch);
+	ocl->set_kernel_argument(argc++, (unsigned int)(state.update_depth_bounds ? 1 : 0));
+	
+	// pipeline statistics and debug outputs (the debug output buffers only exist while enabled)
+	ocl->set_kernel_argument(argc++, state.statistics_buffer);
+	ocl->set_kernel_argument(argc++, (state.overdraw_buffer != nullptr ? state.overdraw_buffer : state.statistics_buffer));
+	ocl->set_kernel_argument(argc++, (state.bin_primitives_buffer != nullptr ? state.bin_primitives_buffer : state.statistics_buffer));
+	ocl->set_kernel_argument(argc++, state.debug_output_pitch);
+	ocl->set_kernel_argument(argc++, state.collect_statistics);
 	
 	if(ocl->get_active_device()->type >= opencl::DEVICE_TYPE::CPU0 &&
 	   ocl->get_active_device()->type <= opencl::DEVICE_TYPE::CPU255) {
@@ -27,7 +27,8 @@ transform_stage::~transform_stage() {
 }
 
 void transform_stage::transform(draw_state& state) {
-	//
+	opencl_base::profiling_stage_scope profiling_scope(opencl_base::PROFILING_STAGE::TRANSFORM);
+	
 	oclraster_program::kernel_spec spec;
 	if(!create_kernel_spec(state, *state.transform_prog, spec)) {
 		return;
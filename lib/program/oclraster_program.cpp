@@ -25,6 +25,15 @@ extern "C" {
 #include "tcc.h"
 }
 
+recursive_mutex oclraster_program::struct_layout_lock;
+unordered_map<uint64, oclraster_program::oclraster_struct_info::device_struct_info> oclraster_program::struct_layouts;
+bool oclraster_program::struct_layouts_loaded { false };
+bool oclraster_program::struct_probe_batch { false };
+vector<oclraster_program::oclraster_struct_info*> oclraster_program::pending_struct_probes;
+mutex oclraster_program::image_support_sections_lock;
+unordered_map<string, string> oclraster_program::image_support_sections;
+bool oclraster_program::image_support_sections_loaded { false };
+
 oclraster_program::oclraster_program(const string& code oclr_unused,
 									 const string entry_function_,
 									 const string build_options_,
@@ -33,19 +42,32 @@ entry_function(entry_function_), build_options(build_options_), kernel_function_
 }
 
 oclraster_program::~oclraster_program() {
-	for(auto& spec : compiled_kernels) {
-		delete spec;
+	finish_background_compilation();
+	{
+		// remove all structs of this program that haven't been probed yet
+		lock_guard<recursive_mutex> lock(struct_layout_lock);
+		for(auto& oclr_struct : structs) {
+			pending_struct_probes.erase(remove(begin(pending_struct_probes), end(pending_struct_probes), oclr_struct),
+										end(pending_struct_probes));
+		}
 	}
 	for(auto& oclr_struct : structs) {
 		delete oclr_struct;
 	}
 	if(ocl != nullptr) {
 		for(const auto& kernel : kernels) {
-			ocl->delete_kernel(kernel.second);
+			ocl->delete_kernel(kernel.second.kernel);
 		}
 	}
 }
 
+void oclraster_program::finish_background_compilation() {
+	for(auto& compile_thread : compile_threads) {
+		if(compile_thread.joinable()) compile_thread.join();
+	}
+	compile_threads.clear();
+}
+
 void oclraster_program::process_program(const string& raw_code, const kernel_spec default_spec) {
 	// preprocess
 	const string code = preprocess_code(raw_code);
@@ -199,11 +221,20 @@ void oclraster_program::process_program(const string& raw_code, const kernel_spe
 			}
 		}
 		
-		// process found structs
-		for(auto& oclr_struct : structs) {
-			if(oclr_struct->empty) continue;
-			if(oclr_struct->type == STRUCT_TYPE::BUFFERS) continue;
-			generate_struct_info_cl_program(*oclr_struct);
+		// process found structs (use cached layouts or probe all uncached structs at once)
+		{
+			lock_guard<recursive_mutex> lock(struct_layout_lock);
+			vector<oclraster_struct_info*> probe_structs;
+			for(auto& oclr_struct : structs) {
+				if(oclr_struct->empty) continue;
+				if(oclr_struct->type == STRUCT_TYPE::BUFFERS) continue;
+				if(lookup_struct_layouts(*oclr_struct)) continue;
+				probe_structs.emplace_back(oclr_struct);
+			}
+			if(struct_probe_batch) {
+				pending_struct_probes.insert(pending_struct_probes.end(), probe_structs.begin(), probe_structs.end());
+			}
+			else probe_struct_layouts(probe_structs);
 		}
 		
 		// order
@@ -318,25 +349,43 @@ void oclraster_program::process_program(const string& raw_code, const kernel_spe
 			spec.image_spec.clear();
 		}
 		// else: no images in kernel/program -> just one kernel / "empty image spec"
-		build_kernel(spec);
+		image_spec_size = spec.image_spec.size();
+		{
+			lock_guard<mutex> lock(kernels_lock);
+			kernels.emplace(spec, kernel_entry { opencl::null_kernel_object, true });
+		}
+		compile_kernel(spec);
 	}
 	catch(oclraster_exception& ex) {
 		invalidate(ex.what());
 	}
 	valid = true;
+	
+	if(oclraster::get_kernel_spec_warmup()) {
+		warmup_recorded_specs(raw_code);
+	}
+}
+
+weak_ptr<opencl::kernel_object> oclraster_program::compile_kernel(const kernel_spec& spec) {
+	const auto kernel = build_kernel(spec);
+	{
+		lock_guard<mutex> lock(kernels_lock);
+		auto& entry = kernels.at(spec);
+		entry.kernel = kernel;
+		entry.pending = false;
+	}
+	kernels_cv.notify_all();
+	if(kernel.use_count() > 0) record_spec(spec);
+	return kernel;
 }
 
 weak_ptr<opencl::kernel_object> oclraster_program::build_kernel(const kernel_spec& spec) {
-	kernel_spec* new_spec = new kernel_spec(spec);
-	compiled_kernels.emplace_back(new_spec);
-	
 	// if any device doesn't support doubles and the user tries to use a double image format,
 	// fail immediately and return a null kernel (better here than crashing during compilation)
 	if(!ocl->is_full_double_support()) {
 		for(const auto& img_type : spec.image_spec) {
 			if(img_type.data_type == IMAGE_TYPE::FLOAT_64) {
 				oclr_error("can't use a double/FLOAT_64 image format when one or more opencl devices do not support doubles!");
-				kernels.emplace(new_spec, opencl::null_kernel_object);
 				return opencl::null_kernel_object;
 			}
 		}
@@ -365,6 +414,9 @@ weak_ptr<opencl::kernel_object> oclraster_program::build_kernel(const kernel_spe
 	if(!has_framebuffer_depth) framebuffer_options += " -DOCLRASTER_NO_DEPTH";
 	if(!spec.depth.depth_test) framebuffer_options += " -DOCLRASTER_NO_DEPTH_TEST";
 	if(spec.depth.depth_override) framebuffer_options += " -DOCLRASTER_DEPTH_OVERRIDE";
+	if(spec.binning == BINNING::SCATTER) framebuffer_options += " -DOCLRASTER_BINNING_SCATTER";
+	const bool fixed_point = (spec.fixed_point && spec.projection == PROJECTION::ORTHOGRAPHIC);
+	if(fixed_point) framebuffer_options += " -DOCLRASTER_FIXED_POINT_RASTERIZATION";
 	
 	string depth_spec_str = "";
 	depth_spec_str += (spec.depth.depth_test ? ".depth_test" : ".no_depth_test");
@@ -384,10 +436,28 @@ weak_ptr<opencl::kernel_object> oclraster_program::build_kernel(const kernel_spe
 	
 	// finally: call the specialized processing function of inheriting classes/programs
 	// note: this should inject the user code into their respective code templates
-	const string program_code { specialized_processing(processed_code, *new_spec) };
+	string program_code { specialized_processing(processed_code, spec) };
+	
+	// only add the image support functions of the used image types (instead of including all of them)
+	if(oclraster::get_trimmed_image_support()) {
+		static const string image_include { "#include \"oclr_image.h\"" };
+		const size_t image_include_pos = program_code.find(image_include);
+		if(image_include_pos != string::npos) {
+			const auto sections = get_image_support_sections();
+			string image_support_code = "\n";
+			for(const auto& img_type : img_types) {
+				const auto section = sections.find(core::str_to_upper(img_type));
+				if(section != sections.end()) image_support_code += section->second;
+			}
+			program_code.insert(image_include_pos + image_include.size(), image_support_code);
+			image_defines += " -DOCLRASTER_TRIMMED_IMAGE_SUPPORT";
+		}
+	}
 	
 	//
 	const string proj_spec_str = (spec.projection == PROJECTION::PERSPECTIVE ? "perspective" : "orthographic");
+	const string binning_spec_str = (spec.binning == BINNING::SCATTER ? ".scatter" : "");
+	const string fixed_point_spec_str = (fixed_point ? ".fixed_point" : "");
 	string img_spec_str = "";
 	for(const auto& type : spec.image_spec) {
 		img_spec_str += "." + type.to_string();
@@ -396,11 +466,10 @@ weak_ptr<opencl::kernel_object> oclraster_program::build_kernel(const kernel_spe
 	stringstream id_stream;
 	id_stream << dec << this_thread::get_id();
 	const string identifier = ("USER_PROGRAM."+kernel_function_name+"."+entry_function+"."+
-							   proj_spec_str+depth_spec_str+img_spec_str+"."+
+							   proj_spec_str+depth_spec_str+binning_spec_str+fixed_point_spec_str+img_spec_str+"."+
 							   ull2string(SDL_GetPerformanceCounter())+"."+id_stream.str());
 	weak_ptr<opencl::kernel_object> kernel = ocl->add_kernel_src(identifier, program_code, kernel_function_name,
-																 " -DBIN_SIZE="+uint2string(OCLRASTER_BIN_SIZE)+
-																 " -DBATCH_SIZE="+uint2string(OCLRASTER_BATCH_SIZE)+
+																 ocl->get_tuning_options()+
 																 " -DOCLRASTER_PROJECTION_"+(spec.projection == PROJECTION::PERSPECTIVE ? "PERSPECTIVE" : "ORTHOGRAPHIC")+
 																 image_defines+
 																 framebuffer_options+
@@ -411,7 +480,6 @@ weak_ptr<opencl::kernel_object> oclraster_program::build_kernel(const kernel_spe
 		oclr_debug("kernel source: %s", program_code);
 	}
 #endif
-	kernels.emplace(new_spec, kernel);
 	return kernel;
 }
 
@@ -655,29 +723,141 @@ void oclraster_program::process_image_struct(const vector<string>& variable_name
 	images.is_framebuffer.insert(images.is_framebuffer.end(), variable_names.size(), is_framebuffer);
 }
 
-void oclraster_program::generate_struct_info_cl_program(oclraster_struct_info& struct_info) {
-	// TODO: combine this for all program structs, so it has to be run only once
-	// TODO: also: no need to use atomics (use if global_id == 0 instead) + use __builtin_offsetof?
-	static const string kernel_header = "#include \"oclr_global.h\"\n#include \"oclr_matrix.h\"\n";
-	static const string kernel_start = "kernel void struct_info(global int* info_buffer) {\nint index = 0;\n";
-	static const string kernel_end = "}";
+void oclraster_program::begin_struct_probe_batch() {
+	lock_guard<recursive_mutex> lock(struct_layout_lock);
+	struct_probe_batch = true;
+}
+
+void oclraster_program::end_struct_probe_batch() {
+	lock_guard<recursive_mutex> lock(struct_layout_lock);
+	struct_probe_batch = false;
+	if(pending_struct_probes.empty()) return;
+	probe_struct_layouts(pending_struct_probes);
+	pending_struct_probes.clear();
+}
+
+uint64 oclraster_program::struct_layout_hash(const oclraster_struct_info& struct_info, const opencl::device_object* device) {
+	// struct layouts only depend on the member types (not the names), the device/driver and the types defined
+	// in the kernel headers (-> also hash their content, so that the cache is invalidated when they change)
+	static const string header_src {
+		file_io::file_to_string(oclraster::kernel_path("oclr_global.h")) +
+		file_io::file_to_string(oclraster::kernel_path("oclr_matrix.h")) +
+		uint2string(OCLRASTER_STRUCT_ALIGNMENT)
+	};
+	string layout_src = header_src;
+	layout_src += '\0' + device->name + '\0' + device->vendor + '\0' + device->version + '\0' + device->driver_version;
+	for(const auto& var_type : struct_info.variable_types) {
+		layout_src += '\0' + var_type;
+	}
+	return CityHash64(layout_src.c_str(), layout_src.size());
+}
+
+// struct layout cache format (data/cache/struct_layouts.txt, one layout per line):
+// layout-hash struct-size #members [member-size member-offset]*
+// note: kernel bundles contain these entries as well (-> seeds the cache)
+string oclraster_program::make_struct_layout_entry(const uint64 hash, const oclraster_struct_info::device_struct_info& dev_info) {
+	stringstream entry;
+	entry << hex << hash << dec << " " << dev_info.struct_size << " " << dev_info.sizes.size();
+	for(size_t i = 0, member_count = dev_info.sizes.size(); i < member_count; i++) {
+		entry << " " << dev_info.sizes[i] << " " << dev_info.offsets[i];
+	}
+	return entry.str();
+}
+
+void oclraster_program::load_struct_layouts() {
+	if(struct_layouts_loaded) return;
+	struct_layouts_loaded = true;
 	
-	string kernel_code = kernel_header;
+	const auto add_layout = [](const string& entry) {
+		stringstream layout_line(entry);
+		uint64 hash;
+		size_t member_count;
+		oclraster_struct_info::device_struct_info dev_info;
+		if(!(layout_line >> hex >> hash >> dec >> dev_info.struct_size >> member_count)) return;
+		dev_info.sizes.resize(member_count);
+		dev_info.offsets.resize(member_count);
+		for(size_t i = 0; i < member_count; i++) {
+			layout_line >> dev_info.sizes[i] >> dev_info.offsets[i];
+		}
+		if(layout_line.fail()) return;
+		struct_layouts.emplace(hash, dev_info);
+	};
 	
-	// struct decl
-	kernel_code += "oclraster_struct {\n";
-	for(size_t i = 0; i < struct_info.variables.size(); i++) {
-		kernel_code += struct_info.variable_types[i] + " " + struct_info.variables[i] + ";\n";
+	fstream layout_file(oclraster::data_path("cache/struct_layouts.txt"), fstream::in);
+	if(layout_file.is_open()) {
+		string line;
+		while(getline(layout_file, line)) {
+			add_layout(line);
+		}
+		layout_file.close();
+	}
+	
+	// seed the cache with the layouts of the loaded kernel bundle (-> no probing for bundled programs)
+	for(const auto& entry : ocl->get_bundle_struct_layouts()) {
+		add_layout(entry);
+	}
+}
+
+bool oclraster_program::lookup_struct_layouts(oclraster_struct_info& struct_info) {
+	lock_guard<recursive_mutex> lock(struct_layout_lock);
+	load_struct_layouts();
+	
+	vector<pair<opencl::device_object*, const oclraster_struct_info::device_struct_info*>> dev_infos;
+	for(const auto& device : ocl->get_devices()) {
+		const auto layout = struct_layouts.find(struct_layout_hash(struct_info, device));
+		if(layout == struct_layouts.end() ||
+		   layout->second.sizes.size() != struct_info.variables.size()) {
+			return false;
+		}
+		dev_infos.emplace_back(device, &layout->second);
+	}
+	for(const auto& dev_info : dev_infos) {
+		struct_info.device_infos.emplace(dev_info.first, *dev_info.second);
+		// cached layouts must also end up in a kernel bundle that is currently being recorded
+		ocl->record_struct_layout(dev_info.first, make_struct_layout_entry(struct_layout_hash(struct_info, dev_info.first),
+																		   *dev_info.second));
+	}
+	return true;
+}
+
+void oclraster_program::probe_struct_layouts(const vector<oclraster_struct_info*>& probe_structs) {
+	lock_guard<recursive_mutex> lock(struct_layout_lock);
+	
+	// structs with the same member types have the same layout -> only probe each layout once
+	// note: all probed structs have the same member type list on all devices (-> use the first device)
+	const auto& devices = ocl->get_devices();
+	if(devices.empty() || probe_structs.empty()) return;
+	vector<const oclraster_struct_info*> layouts;
+	unordered_map<uint64, size_t> layout_indices;
+	for(const auto& struct_info : probe_structs) {
+		const uint64 hash = struct_layout_hash(*struct_info, devices[0]);
+		if(layout_indices.count(hash) > 0) continue;
+		layout_indices.emplace(hash, layouts.size());
+		layouts.emplace_back(struct_info);
 	}
-	kernel_code += "} " + struct_info.name + ";\n";
 	
-	// actual kernel
-	kernel_code += kernel_start;
-	kernel_code += "atomic_xchg(&info_buffer[index++], (int)sizeof("+struct_info.name+"));\n";
-	for(const auto& var : struct_info.variables) {
-		// standard c ftw
-		kernel_code += "atomic_xchg(&info_buffer[index++], (int)((size_t)sizeof(("+struct_info.name+"*)0)->"+var+"));\n"; // size
-		kernel_code += "atomic_xchg(&info_buffer[index++], (int)((size_t)&((("+struct_info.name+"*)0)->"+var+")));\n"; // offset
+	// generate a single kernel that writes the size of and the member sizes/offsets of all structs
+	static const string kernel_header = "#include \"oclr_global.h\"\n#include \"oclr_matrix.h\"\n";
+	string kernel_code = kernel_header;
+	size_t info_buffer_size = 0;
+	for(size_t i = 0; i < layouts.size(); i++) {
+		kernel_code += "oclraster_struct {\n";
+		for(size_t j = 0; j < layouts[i]->variable_types.size(); j++) {
+			kernel_code += layouts[i]->variable_types[j] + " m" + size_t2string(j) + ";\n";
+		}
+		kernel_code += "} oclr_probe_" + size_t2string(i) + ";\n";
+		info_buffer_size += 1 + layouts[i]->variable_types.size() * 2;
+	}
+	kernel_code += "kernel void struct_info(global int* info_buffer) {\nint index = 0;\n";
+	for(size_t i = 0; i < layouts.size(); i++) {
+		const string struct_name = "oclr_probe_" + size_t2string(i);
+		kernel_code += "info_buffer[index++] = (int)sizeof("+struct_name+");\n";
+		for(size_t j = 0; j < layouts[i]->variable_types.size(); j++) {
+			// standard c ftw
+			const string member = "m" + size_t2string(j);
+			kernel_code += "info_buffer[index++] = (int)((size_t)sizeof(("+struct_name+"*)0)->"+member+");\n"; // size
+			kernel_code += "info_buffer[index++] = (int)((size_t)&((("+struct_name+"*)0)->"+member+"));\n"; // offset
+		}
 	}
 	kernel_code += "}"; // eol
 	
@@ -694,19 +874,16 @@ void oclraster_program::generate_struct_info_cl_program(oclraster_struct_info& s
 		return;
 	}
 	
-	const size_t info_buffer_size = 1 + struct_info.variables.size() * 2;
-	int* info_buffer_results = new int[info_buffer_size];
+	vector<int> info_buffer_results(info_buffer_size);
+	stringstream new_layouts;
 	
 	ocl->lock();
 	auto active_device = ocl->get_active_device();
-	const auto& devices = ocl->get_devices();
 	for(size_t dev_num = 0; dev_num < devices.size(); dev_num++) {
 		// this has to be executed for all devices, since each device can have its own struct/member sizes/offsets
 		ocl->set_active_device(devices[dev_num]->type);
-		//oclr_msg("DEVICE: %s", devices[dev_num]->name);
 		
-		// read/write is necessary, because of atomic_xchg
-		opencl::buffer_object* info_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ_WRITE |
+		opencl::buffer_object* info_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::WRITE |
 																opencl::BUFFER_FLAG::BLOCK_ON_READ,
 																info_buffer_size * sizeof(int));
 		
@@ -715,30 +892,89 @@ void oclraster_program::generate_struct_info_cl_program(oclraster_struct_info& s
 		ocl->set_kernel_range({1, 1});
 		ocl->run_kernel();
 		
-		ocl->read_buffer(info_buffer_results, info_buffer);
-		
-		oclraster_struct_info::device_struct_info dev_info;
-		dev_info.struct_size = info_buffer_results[0];
-		//oclr_msg("struct \"%s\" size: %d", struct_info.name, dev_info.struct_size);
-		dev_info.sizes.resize(struct_info.variables.size());
-		dev_info.offsets.resize(struct_info.variables.size());
-		for(size_t i = 0; i < struct_info.variables.size(); i++) {
-			dev_info.sizes[i] = info_buffer_results[(i*2) + 1];
-			dev_info.offsets[i] = info_buffer_results[(i*2) + 2];
-			//oclr_msg("\tmember \"%s\": size: %d, offset: %d",
-			//		 struct_info.variables[i], dev_info.sizes[i], dev_info.offsets[i]);
-		}
-		struct_info.device_infos.emplace(devices[dev_num], dev_info);
-		
+		ocl->read_buffer(info_buffer_results.data(), info_buffer);
 		ocl->delete_buffer(info_buffer);
+		
+		size_t index = 0;
+		for(const auto& layout : layouts) {
+			oclraster_struct_info::device_struct_info dev_info;
+			const size_t member_count = layout->variable_types.size();
+			dev_info.struct_size = info_buffer_results[index++];
+			dev_info.sizes.resize(member_count);
+			dev_info.offsets.resize(member_count);
+			for(size_t i = 0; i < member_count; i++) {
+				dev_info.sizes[i] = info_buffer_results[index++];
+				dev_info.offsets[i] = info_buffer_results[index++];
+			}
+			
+			const uint64 hash = struct_layout_hash(*layout, devices[dev_num]);
+			struct_layouts[hash] = dev_info;
+			const string entry = make_struct_layout_entry(hash, dev_info);
+			new_layouts << entry << endl;
+			ocl->record_struct_layout(devices[dev_num], entry);
+		}
 	}
 	ocl->set_active_device(active_device->type);
 	ocl->unlock();
 	
 	// cleanup
-	delete [] info_buffer_results;
 	kernel_ptr = nullptr;
 	ocl->delete_kernel(kernel_obj);
+	
+	// set the device infos of all probed structs
+	for(const auto& struct_info : probe_structs) {
+		for(const auto& device : devices) {
+			struct_info->device_infos.emplace(device, struct_layouts.at(struct_layout_hash(*struct_info, device)));
+		}
+	}
+	oclr_debug("probed %u struct layouts (%u structs)", layouts.size(), probe_structs.size());
+	
+	// append the new layouts to the cache file
+	fstream layout_file(oclraster::data_path("cache/struct_layouts.txt"), fstream::out | fstream::app);
+	if(!layout_file.is_open()) {
+		oclr_error("couldn't write the struct layout cache!");
+		return;
+	}
+	layout_file << new_layouts.str();
+	layout_file.close();
+}
+
+unordered_map<string, string> oclraster_program::get_image_support_sections() {
+	lock_guard<mutex> lock(image_support_sections_lock);
+	if(image_support_sections_loaded) return image_support_sections;
+	
+	// splits the generated oclr_image_support.h into its per image type sections
+	// (each one is guarded by "#if defined(OCLRASTER_IMAGE_<TYPE>)", types may have multiple sections)
+	image_support_sections.clear();
+	static const string section_start { "#if defined(OCLRASTER_IMAGE_" };
+	stringstream image_support;
+	if(!file_io::file_to_buffer(oclraster::kernel_path("oclr_image_support.h"), image_support)) {
+		oclr_error("couldn't open oclr_image_support.h!");
+		return image_support_sections;
+	}
+	string line, cur_type = "";
+	size_t depth = 0;
+	while(getline(image_support, line)) {
+		if(cur_type.empty()) {
+			if(line.compare(0, section_start.size(), section_start) != 0) continue;
+			cur_type = line.substr(section_start.size(), line.find(')') - section_start.size());
+			depth = 1;
+			continue;
+		}
+		if(line.compare(0, 3, "#if") == 0) depth++;
+		else if(line.compare(0, 6, "#endif") == 0 && --depth == 0) {
+			cur_type = "";
+			continue;
+		}
+		image_support_sections[cur_type] += line + "\n";
+	}
+	image_support_sections_loaded = true;
+	return image_support_sections;
+}
+
+void oclraster_program::invalidate_image_support_sections() {
+	lock_guard<mutex> lock(image_support_sections_lock);
+	image_support_sections_loaded = false;
 }
 
 bool oclraster_program::is_valid() const {
@@ -761,34 +997,254 @@ const oclraster_program::oclraster_image_info& oclraster_program::get_images() c
 
 weak_ptr<opencl::kernel_object> oclraster_program::get_kernel(const kernel_spec spec) {
 	//
-	if(kernels.empty() || compiled_kernels.empty()) {
+	unique_lock<mutex> lock(kernels_lock);
+	if(kernels.empty()) {
 		oclr_error("no kernel has been compiled for this program!");
 		return opencl::null_kernel_object;
 	}
-	if(spec.image_spec.size() != compiled_kernels[0]->image_spec.size()) {
+	if(spec.image_spec.size() != image_spec_size) {
 		oclr_error("invalid kernel image spec size (%u) - should be (%u)!",
-				   spec.image_spec.size(), compiled_kernels[0]->image_spec.size());
+				   spec.image_spec.size(), image_spec_size);
 		return opencl::null_kernel_object;
 	}
 	
 	//
+	if(kernels.count(spec) == 0) {
+		// new kernel spec -> compile new kernel
+		kernels.emplace(spec, kernel_entry { opencl::null_kernel_object, true });
+		lock.unlock();
+		return compile_kernel(spec);
+	}
+	// still being compiled in the background -> wait
+	kernels_cv.wait(lock, [this, &spec]() { return !kernels.at(spec).pending; });
+	return kernels.at(spec).kernel;
+}
+
+bool oclraster_program::depends_on(const set<string>& files) {
+	for(const auto& file : files) {
+		if(source_dependencies.count(file) > 0) return true;
+	}
+	lock_guard<mutex> lock(kernels_lock);
 	for(const auto& kernel : kernels) {
-		if(*kernel.first != spec) continue;
-		return kernel.second;
+		if(ocl->kernel_depends_on(kernel.second.kernel, files)) return true;
+	}
+	return false;
+}
+
+void oclraster_program::precompile(const vector<kernel_spec>& specs) {
+	vector<kernel_spec> new_specs;
+	{
+		lock_guard<mutex> lock(kernels_lock);
+		for(const auto& spec : specs) {
+			if(spec.image_spec.size() != image_spec_size) {
+				oclr_error("invalid kernel image spec size (%u) - should be (%u)!",
+						   spec.image_spec.size(), image_spec_size);
+				continue;
+			}
+			if(kernels.count(spec) > 0) continue;
+			kernels.emplace(spec, kernel_entry { opencl::null_kernel_object, true });
+			new_specs.emplace_back(spec);
+		}
+	}
+	if(new_specs.empty()) return;
+	
+	// if kernels can't be compiled on other threads (cuda), compile them right away
+	if(!ocl->has_parallel_kernel_compilation()) {
+		for(const auto& spec : new_specs) {
+			compile_kernel(spec);
+		}
+		return;
+	}
+	compile_threads.emplace_back([this, new_specs]() {
+		for(const auto& spec : new_specs) {
+			compile_kernel(spec);
+		}
+	});
+}
+
+// recorded spec format (one spec per line):
+// projection depth_func depth_test depth_override binning fixed_point #images [data_type channel_type native]*
+// note: specs with a custom depth function are not recorded
+void oclraster_program::record_spec(const kernel_spec& spec) {
+	if(spec_record_filename.empty() || spec.depth.depth_func == DEPTH_FUNCTION::CUSTOM) return;
+	
+	lock_guard<mutex> lock(kernels_lock);
+	if(!recorded_specs.insert(spec).second) return;
+	
+	stringstream spec_line;
+	spec_line << (unsigned int)spec.projection << " " << (unsigned int)spec.depth.depth_func << " ";
+	spec_line << spec.depth.depth_test << " " << spec.depth.depth_override << " ";
+	spec_line << (unsigned int)spec.binning << " " << spec.fixed_point << " " << spec.image_spec.size();
+	for(const auto& img_type : spec.image_spec) {
+		spec_line << " " << (unsigned int)img_type.data_type << " " << (unsigned int)img_type.channel_type;
+		spec_line << " " << img_type.native;
+	}
+	spec_line << endl;
+	
+	fstream record_file(spec_record_filename, fstream::out | fstream::app);
+	if(!record_file.is_open()) {
+		oclr_error("couldn't open kernel spec record file \"%s\"!", spec_record_filename);
+		return;
+	}
+	record_file << spec_line.str();
+	record_file.close();
+}
+
+void oclraster_program::warmup_recorded_specs(const string& raw_code) {
+	// programs are identified by their code, build options and type
+	const string program_id { raw_code + '\0' + entry_function + '\0' + build_options + '\0' + kernel_function_name };
+	const uint128 program_hash = CityHash128(program_id.c_str(), program_id.size());
+	stringstream sstr_upper; sstr_upper << hex << program_hash.first;
+	stringstream sstr_lower; sstr_lower << hex << program_hash.second;
+	string upper_hash { sstr_upper.str() };
+	string lower_hash { sstr_lower.str() };
+	if(upper_hash.size() < 16) upper_hash.insert(0, 16 - upper_hash.size(), '0');
+	if(lower_hash.size() < 16) lower_hash.insert(0, 16 - lower_hash.size(), '0');
+	const string record_filename = oclraster::data_path("cache/specs_" + upper_hash + lower_hash + ".txt");
+	
+	vector<kernel_spec> specs;
+	fstream record_file(record_filename, fstream::in);
+	if(record_file.is_open()) {
+		string line;
+		while(getline(record_file, line)) {
+			stringstream spec_line(line);
+			unsigned int projection, depth_func, binning, image_count;
+			bool depth_test, depth_override, fixed_point;
+			if(!(spec_line >> projection >> depth_func >> depth_test >> depth_override >>
+				 binning >> fixed_point >> image_count)) continue;
+			if(image_count != image_spec_size ||
+			   projection > (unsigned int)PROJECTION::ORTHOGRAPHIC ||
+			   depth_func >= (unsigned int)DEPTH_FUNCTION::CUSTOM ||
+			   binning > (unsigned int)BINNING::SCATTER) {
+				continue;
+			}
+			
+			vector<image_type> image_spec;
+			for(unsigned int i = 0; i < image_count; i++) {
+				unsigned int data_type, channel_type;
+				bool native;
+				if(!(spec_line >> data_type >> channel_type >> native)) break;
+				if(data_type >= (unsigned int)IMAGE_TYPE::__MAX_TYPE ||
+				   channel_type >= (unsigned int)IMAGE_CHANNEL::__MAX_CHANNEL) {
+					break;
+				}
+				image_spec.emplace_back((IMAGE_TYPE)data_type, (IMAGE_CHANNEL)channel_type, native);
+			}
+			if(image_spec.size() != image_count) continue;
+			
+			specs.emplace_back(image_spec, (PROJECTION)projection, (DEPTH_FUNCTION)depth_func, "",
+							   depth_test, depth_override, (BINNING)binning, fixed_point);
+		}
+		record_file.close();
+	}
+	
+	{
+		lock_guard<mutex> lock(kernels_lock);
+		spec_record_filename = record_filename;
+		for(const auto& spec : specs) {
+			recorded_specs.insert(spec);
+		}
+	}
+	// also record the already compiled (default) spec
+	vector<kernel_spec> compiled_specs;
+	{
+		lock_guard<mutex> lock(kernels_lock);
+		for(const auto& kernel : kernels) {
+			if(!kernel.second.pending && kernel.second.kernel.use_count() > 0) {
+				compiled_specs.emplace_back(kernel.first);
+			}
+		}
+	}
+	for(const auto& spec : compiled_specs) {
+		record_spec(spec);
+	}
+	
+	if(!specs.empty()) {
+		oclr_debug("warming up %u recorded kernel specs for \"%s\"", specs.size(), kernel_function_name);
+		precompile(specs);
+	}
+}
+
+static void append_include_sources(const string& src, const vector<string>& include_paths,
+								   string& hash_src, set<string>& included) {
+	// resolves "..." and <...> includes in all include paths (in order, same as tcc)
+	static const string include_directive { "#include" };
+	for(size_t pos = src.find(include_directive); pos != string::npos; pos = src.find(include_directive, pos + 1)) {
+		const size_t name_start = src.find_first_not_of(" \t", pos + include_directive.size());
+		if(name_start == string::npos || (src[name_start] != '\"' && src[name_start] != '<')) continue;
+		const size_t name_end = src.find(src[name_start] == '<' ? '>' : '\"', name_start + 1);
+		if(name_end == string::npos) continue;
+		
+		const string include_name = src.substr(name_start + 1, name_end - name_start - 1);
+		if(!included.insert(include_name).second) continue;
+		
+		string include_src;
+		bool found = false;
+		for(const auto& include_path : include_paths) {
+			if(file_io::file_to_string(include_path + include_name, include_src)) {
+				found = true;
+				break;
+			}
+		}
+		if(!found) {
+			// system header (or it doesn't exist) -> at least consider the name
+			hash_src += '\0' + include_name;
+			continue;
+		}
+		hash_src += '\0' + include_src;
+		append_include_sources(include_src, include_paths, hash_src, included);
 	}
-	// new kernel image spec -> compile new kernel
-	return build_kernel(spec);
 }
 
 string oclraster_program::preprocess_code(const string& raw_code) {
+	// preprocessed code is cached, keyed by the code, build options and content of all included headers
+	// -> identical programs and kernel reloads of unchanged programs don't need to be preprocessed again
+	static mutex preprocess_cache_lock;
+	static map<uint128, string> preprocess_cache;
+	
+	const string kernels_include_path = "-I" + core::strip_path(oclraster::kernel_path("")) + " ";
+	const auto build_option_args = core::tokenize(kernels_include_path+build_options, ' ');
+	vector<string> include_paths;
+	for(const auto& arg : build_option_args) {
+		if(arg.size() > 2 && arg.compare(0, 2, "-I") == 0) {
+			include_paths.emplace_back(arg.substr(2) + (arg.back() != '/' ? "/" : ""));
+		}
+	}
+	string hash_src = raw_code + '\0' + kernels_include_path + build_options;
+	set<string> included;
+	append_include_sources(raw_code, include_paths, hash_src, included);
+	source_dependencies = included;
+	const uint128 code_hash = CityHash128(hash_src.c_str(), hash_src.size());
+	
+	stringstream sstr_upper; sstr_upper << hex << code_hash.first;
+	stringstream sstr_lower; sstr_lower << hex << code_hash.second;
+	string upper_hash { sstr_upper.str() };
+	string lower_hash { sstr_lower.str() };
+	if(upper_hash.size() < 16) upper_hash.insert(0, 16 - upper_hash.size(), '0');
+	if(lower_hash.size() < 16) lower_hash.insert(0, 16 - lower_hash.size(), '0');
+	const string cache_filename = oclraster::data_path("cache/" + upper_hash + lower_hash + ".pp");
+	
+	{
+		lock_guard<mutex> lock(preprocess_cache_lock);
+		const auto cached_code = preprocess_cache.find(code_hash);
+		if(cached_code != preprocess_cache.end()) {
+			return cached_code->second;
+		}
+		
+		string disk_code;
+		if(oclraster::get_preprocess_cache() && file_io::is_file(cache_filename) &&
+		   file_io::file_to_string(cache_filename, disk_code)) {
+			preprocess_cache.emplace(code_hash, disk_code);
+			return disk_code;
+		}
+	}
+	
 	// init
 	string ret_code = "";
 	TCCState* state = tcc_new();
 	state->output_type = TCC_OUTPUT_PREPROCESS;
 	
-	// split build options and let tcc parse them
-	const string kernels_include_path = "-I" + core::strip_path(oclraster::kernel_path("")) + " ";
-	const auto build_option_args = core::tokenize(kernels_include_path+build_options, ' ');
+	// let tcc parse the build options
 	const size_t argc = build_option_args.size();
 	vector<const char*> argv;
 	for(const auto& arg : build_option_args) {
@@ -803,9 +1259,18 @@ string oclraster_program::preprocess_code(const string& raw_code) {
 								 *(string*)ret += str;
 							 });
 	
-	// cleanup + return
+	// cleanup
 	tcc_delete(state);
 	//oclr_msg("preprocessed code: %s", ret_code);
+	
+	// cache + return
+	{
+		lock_guard<mutex> lock(preprocess_cache_lock);
+		preprocess_cache.emplace(code_hash, ret_code);
+	}
+	if(oclraster::get_preprocess_cache() && !file_io::string_to_file(cache_filename, ret_code)) {
+		oclr_error("couldn't write preprocessed program \"%s\"!", cache_filename);
+	}
 	return ret_code;
 }
 
@@ -28,6 +28,10 @@ enum class PROJECTION : unsigned int {
 	PERSPECTIVE,
 	ORTHOGRAPHIC
 };
+enum class BINNING : unsigned int {
+	GATHER, // each bin gathers its primitives from all batches (fixed size queue per bin and batch)
+	SCATTER // primitives are scattered into compact per-bin lists (empty bins are skipped)
+};
 enum class DEPTH_FUNCTION : unsigned int {
 	NEVER,
 	LESS,
@@ -74,10 +78,14 @@ public:
 		vector<image_type> image_spec;
 		PROJECTION projection;
 		depth_state depth;
+		BINNING binning;
+		bool fixed_point; // fixed-point rasterization (orthographic only)
 		
 		kernel_spec(const kernel_spec& spec) :
-		image_spec(spec.image_spec), projection(spec.projection), depth(spec.depth) {}
-		kernel_spec(kernel_spec&& spec) : image_spec(), projection(spec.projection), depth(spec.depth) {
+		image_spec(spec.image_spec), projection(spec.projection), depth(spec.depth), binning(spec.binning),
+		fixed_point(spec.fixed_point) {}
+		kernel_spec(kernel_spec&& spec) : image_spec(), projection(spec.projection), depth(spec.depth), binning(spec.binning),
+		fixed_point(spec.fixed_point) {
 			this->image_spec.swap(spec.image_spec);
 		}
 		kernel_spec(const vector<image_type> image_spec_ = vector<image_type> {},
@@ -85,15 +93,19 @@ public:
 					const DEPTH_FUNCTION depth_func_ = DEPTH_FUNCTION::LESS,
 					const string custom_depth_func_ = "",
 					const bool depth_test_ = true,
-					const bool depth_override_ = false) :
+					const bool depth_override_ = false,
+					const BINNING binning_ = BINNING::GATHER,
+					const bool fixed_point_ = false) :
 		image_spec(image_spec_), projection(projection_),
 		depth(depth_func_, depth_func_ == DEPTH_FUNCTION::CUSTOM ? custom_depth_func_ : "",
-			  depth_test_, depth_override_) {}
+			  depth_test_, depth_override_), binning(binning_), fixed_point(fixed_point_) {}
 		
 		bool operator==(const kernel_spec& spec) const {
 			if(spec.projection != projection) return false;
 			if(spec.depth != depth) return false;
-			if(spec.image_spec.size() != spec.image_spec.size()) return false;
+			if(spec.binning != binning) return false;
+			if(spec.fixed_point != fixed_point) return false;
+			if(spec.image_spec.size() != image_spec.size()) return false;
 			for(size_t i = 0, spec_size = image_spec.size(); i < spec_size; i++) {
 				if(image_spec[i] != spec.image_spec[i]) return false;
 			}
@@ -102,6 +114,29 @@ public:
 		bool operator!=(const kernel_spec& spec) const {
 			return !(*this == spec);
 		}
+		
+		size_t hash() const {
+			const auto combine = [](size_t& seed, const size_t value) {
+				seed ^= value + 0x9e3779b9u + (seed << 6u) + (seed >> 2u);
+			};
+			size_t seed = image_spec.size();
+			combine(seed, (size_t)projection);
+			combine(seed, (size_t)binning);
+			combine(seed, (fixed_point ? 1u : 0u));
+			combine(seed, (size_t)depth.depth_func);
+			combine(seed, (depth.depth_test ? 1u : 0u) | (depth.depth_override ? 2u : 0u));
+			if(depth.depth_func == DEPTH_FUNCTION::CUSTOM) combine(seed, std::hash<string>()(depth.custom_depth_func));
+			for(const auto& img_type : image_spec) {
+				combine(seed, ((size_t)img_type.data_type << 16u) | ((size_t)img_type.channel_type << 1u) |
+						(img_type.native ? 1u : 0u));
+			}
+			return seed;
+		}
+	};
+	struct kernel_spec_hash {
+		size_t operator()(const kernel_spec& spec) const {
+			return spec.hash();
+		}
 	};
 	
 	//
@@ -162,7 +197,29 @@ public:
 	const oclraster_image_info& get_images() const;
 	
 	bool is_valid() const;
+	// returns the kernel for this spec (compiles it if it doesn't exist yet or waits until its
+	// background compilation has finished)
 	weak_ptr<opencl::kernel_object> get_kernel(const kernel_spec spec = kernel_spec {});
+	
+	// pre-declares kernel specs that will be needed later on -> these are compiled in the background
+	// note: if kernel spec warmup is enabled in the config, all specs that are compiled for this program are
+	// recorded (in data/cache/) and compiled in the background the next time this program is created
+	void precompile(const vector<kernel_spec>& specs);
+	
+	// returns true if this program (its code or any of its compiled kernels) depends on any of the specified
+	// kernel files (relative to the kernel path, see kernel_reload_event) -> must be recreated on kernel reload
+	bool depends_on(const set<string>& files);
+	
+	// struct layouts (per-device struct sizes/offsets) are cached (in memory and in data/cache/) and probed
+	// with one opencl program for all uncached structs of a program
+	// -> to probe the structs of all programs at once, create them in between these two calls
+	// note: programs created inside a batch can't be used (drawn with) before end_struct_probe_batch
+	static void begin_struct_probe_batch();
+	static void end_struct_probe_batch();
+	
+	// the image support sections (-> trimmed image support) are read once from oclr_image_support.h and cached,
+	// this must be called when the kernel files have been reloaded (-> oclraster kernel reload handler)
+	static void invalidate_image_support_sections();
 
 protected:
 	string entry_function = "main";
@@ -171,9 +228,27 @@ protected:
 	
 	//
 	string processed_code = ""; // created once on program creation (pre-specialized processing)
-	vector<kernel_spec*> compiled_kernels;
-	unordered_map<kernel_spec*, weak_ptr<opencl::kernel_object>> kernels;
+	set<string> source_dependencies; // all headers included by the program code
+	struct kernel_entry {
+		weak_ptr<opencl::kernel_object> kernel;
+		bool pending; // still being compiled
+	};
+	unordered_map<kernel_spec, kernel_entry, kernel_spec_hash> kernels;
+	size_t image_spec_size = 0;
+	mutex kernels_lock;
+	condition_variable kernels_cv;
+	vector<thread> compile_threads;
 	weak_ptr<opencl::kernel_object> build_kernel(const kernel_spec& spec);
+	// builds the kernel of an already added (pending) kernel entry
+	weak_ptr<opencl::kernel_object> compile_kernel(const kernel_spec& spec);
+	// must be called by inheriting classes on destruction (background compilation uses specialized_processing)
+	void finish_background_compilation();
+	
+	// kernel spec recording (-> warmup)
+	string spec_record_filename = "";
+	unordered_set<kernel_spec, kernel_spec_hash> recorded_specs;
+	void record_spec(const kernel_spec& spec);
+	void warmup_recorded_specs(const string& raw_code);
 	
 	//
 	void process_program(const string& code, const kernel_spec default_spec);
@@ -197,10 +272,29 @@ protected:
 	//
 	vector<oclraster_struct_info*> structs;
 	oclraster_image_info images;
-	void generate_struct_info_cl_program(oclraster_struct_info& struct_info);
+	
+	// struct layout cache: layout hash (member types + device + kernel headers) -> device struct info
+	static recursive_mutex struct_layout_lock;
+	static unordered_map<uint64, oclraster_struct_info::device_struct_info> struct_layouts;
+	static bool struct_layouts_loaded;
+	static bool struct_probe_batch;
+	static vector<oclraster_struct_info*> pending_struct_probes;
+	static uint64 struct_layout_hash(const oclraster_struct_info& struct_info, const opencl::device_object* device);
+	static string make_struct_layout_entry(const uint64 hash, const oclraster_struct_info::device_struct_info& dev_info);
+	static void load_struct_layouts();
+	// returns true if the layouts of all devices were cached (-> device_infos have been set)
+	static bool lookup_struct_layouts(oclraster_struct_info& struct_info);
+	static void probe_struct_layouts(const vector<oclraster_struct_info*>& probe_structs);
 	
 	//
 	virtual string preprocess_code(const string& raw_code);
+	
+	// image type (e.g. "UCHAR4") -> image support functions
+	// note: returns a copy, since the cache can be invalidated while programs are compiled in the background
+	static mutex image_support_sections_lock;
+	static unordered_map<string, string> image_support_sections;
+	static bool image_support_sections_loaded;
+	static unordered_map<string, string> get_image_support_sections();
 
 };
 
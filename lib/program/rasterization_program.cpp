@@ -36,6 +36,82 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 		float data[10];
 	} transformed_data;
 
+#if !defined(CPU)
+	// hierarchical rasterization (requires work-group barriers -> not used on cpus):
+	// each bin is split up into 4x4 sub-tiles, which are classified per primitive as empty, partially or fully covered.
+	// fragments in empty sub-tiles skip the primitive entirely, fragments in fully covered sub-tiles skip the inside test.
+#define OCLRASTER_HIERARCHICAL_RASTERIZATION
+#define SUBTILE_SIZE (BIN_SIZE / 4u)
+#define SUBTILE_EPSILON 0.00001f
+#if defined(OCLRASTER_PROJECTION_PERSPECTIVE)
+#define EDGE_SIGN -1.0f // inside: all edge functions < 0
+#else
+#define EDGE_SIGN 1.0f // inside: all edge functions >= 0
+#endif
+	
+#if defined(OCLRASTER_FIXED_POINT_RASTERIZATION)
+	// computes the (pixel space) edge function i from the fixed-point edge setup (see processing.cl)
+	float3 fixed_point_edge(global const float* data, const unsigned int i) {
+		global const int* fixed_data = (global const int*)data;
+		const float a = (i == 0u ? -(convert_float(fixed_data[0]) + convert_float(fixed_data[2])) : convert_float(fixed_data[i * 2u - 2u]));
+		const float b = (i == 0u ? -(convert_float(fixed_data[1]) + convert_float(fixed_data[3])) : convert_float(fixed_data[i * 2u - 1u]));
+		const float c = (i == 0u ? convert_float(((long)fixed_data[7] << 32) | (long)(uint)fixed_data[6]) : 0.0f);
+		return (float3)(a * (float)OCLRASTER_SUBPIXEL_SCALE, b * (float)OCLRASTER_SUBPIXEL_SCALE,
+						c - mad(a, convert_float(fixed_data[4]), b * convert_float(fixed_data[5])));
+	}
+#endif
+	
+	// returns the coverage mask of all sub-tiles of a bin:
+	// bit i: sub-tile i is (at least partially) covered, bit 16 + i: sub-tile i is fully covered
+	// note: this is conservative, a sub-tile is only flagged as empty or fully covered if this holds for all its fragments
+	unsigned int classify_subtiles(global const transformed_data* primitive, const uint2 bin_location) {
+		unsigned int covered = 0xFFFFu, fully_covered = 0xFFFFu;
+		const float2 origin = convert_float2(bin_location * BIN_SIZE) + 0.5f; // first fragment coordinate in the bin
+		const float extent = convert_float(SUBTILE_SIZE - 1u);
+		for(unsigned int i = 0; i < 3; i++) {
+#if defined(OCLRASTER_FIXED_POINT_RASTERIZATION)
+			const float3 edge = fixed_point_edge(primitive->data, i);
+#else
+			const float3 edge = (float3)(primitive->data[i * 3],
+										 primitive->data[i * 3 + 1],
+										 primitive->data[i * 3 + 2]) * EDGE_SIGN;
+#endif
+			// min/max edge function offset inside a sub-tile (relative to its first fragment)
+			const float max_offset = (fmax(edge.x, 0.0f) + fmax(edge.y, 0.0f)) * extent;
+			const float min_offset = (fmin(edge.x, 0.0f) + fmin(edge.y, 0.0f)) * extent;
+			// allow for fp imprecision (and the barycentric snapping in the orthographic case)
+			const float margin = mad(SUBTILE_EPSILON,
+									 fabs(edge.x) * (origin.x + BIN_SIZE) + fabs(edge.y) * (origin.y + BIN_SIZE) + fabs(edge.z),
+									 SUBTILE_EPSILON);
+			for(unsigned int sy = 0; sy < 4u; sy++) {
+				const float row_value = mad(origin.y + convert_float(sy * SUBTILE_SIZE), edge.y, edge.z);
+				for(unsigned int sx = 0; sx < 4u; sx++) {
+					const float value = mad(origin.x + convert_float(sx * SUBTILE_SIZE), edge.x, row_value);
+					const unsigned int bit = 1u << (sy * 4u + sx);
+					if(value + max_offset < -margin) covered &= ~bit;
+					if(!(value + min_offset > margin)) fully_covered &= ~bit;
+				}
+			}
+		}
+		return covered | ((covered & fully_covered) << 16u);
+	}
+#endif
+	
+#if !defined(OCLRASTER_NO_DEPTH) && !defined(OCLRASTER_NO_DEPTH_TEST)
+	// per-bin depth bounds (min/max depth of all fragments in a bin, see bin_rasterize.cl)
+#define OCLRASTER_DEPTH_BOUNDS
+#if !defined(CPU)
+	// order preserving float <-> uint mapping (-> atomic min/max)
+	unsigned int depth_to_ordered(const float depth) {
+		const unsigned int bits = as_uint(depth);
+		return ((bits & 0x80000000u) != 0u ? ~bits : (bits | 0x80000000u));
+	}
+	float ordered_to_depth(const unsigned int bits) {
+		return as_float((bits & 0x80000000u) != 0u ? (bits & 0x7FFFFFFFu) : ~bits);
+	}
+#endif
+#endif
+	
 	// shortcut for the opengl folks
 	#define discard() { return false; }
 	//###OCLRASTER_DEPTH_TEST_FUNCTION###
@@ -59,18 +135,37 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 										const unsigned int primitive_type,
 										const unsigned int instance_primitive_count,
 										const unsigned int instance_index_count,
+										const unsigned int draw_primitive_offset,
+										global const unsigned int* merged_draw_offsets,
+										const unsigned int merged_draws,
 										
 										const uint2 framebuffer_size,
-										const uint4 scissor_rectangle) {
+										const uint4 scissor_rectangle,
+										
+										global float2* depth_bounds,
+										const unsigned int depth_bounds_pitch,
+										const unsigned int update_depth_bounds,
+										
+										global unsigned int* pipeline_statistics,
+										global unsigned int* overdraw_counts,
+										global unsigned int* bin_primitive_counts,
+										const unsigned int debug_output_pitch,
+										const unsigned int collect_statistics) {
 		const unsigned int local_id = get_local_id(0);
 		const unsigned int local_size = get_local_size(0);
 		
 #if defined(CPU)
 #define NO_BARRIER
-#else
+#elif !defined(OCLRASTER_BINNING_SCATTER)
 #define LOCAL_MEM_COPY
 #endif
 		
+#if defined(OCLRASTER_BINNING_SCATTER)
+		// bin list entry: batch index + primitive mask (see bin_rasterize.cl)
+#define SCATTER_MASK_WORDS (BATCH_SIZE / 32u)
+#define SCATTER_ENTRY_SIZE (SCATTER_MASK_WORDS + 1u)
+#endif
+		
 #if !defined(NO_BARRIER)
 		const unsigned int global_id = get_global_id(0);
 		// init counter
@@ -80,9 +175,22 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 		barrier(CLK_GLOBAL_MEM_FENCE);
 #endif
 		
+#if defined(OCLRASTER_HIERARCHICAL_RASTERIZATION)
+		// sub-tile coverage masks of the primitives in the current batch (indexed by primitive id % BATCH_SIZE)
+		local unsigned int subtile_coverage[BATCH_SIZE];
+#define SUBTILE_COVERAGE_BATCH_COUNT (4)
+#else
+#define SUBTILE_COVERAGE_BATCH_COUNT (0)
+#endif
+		
+#if defined(OCLRASTER_DEPTH_BOUNDS) && !defined(NO_BARRIER)
+		// depth bounds of the current bin (as ordered uints)
+		local unsigned int bin_depth_bounds[2];
+#endif
+		
 #if defined(LOCAL_MEM_COPY)
 		// -1 b/c the local memory is also used for other things
-		#define LOCAL_MEM_BATCH_COUNT ((LOCAL_MEM_SIZE / BATCH_SIZE) - 1)
+		#define LOCAL_MEM_BATCH_COUNT ((LOCAL_MEM_SIZE / BATCH_SIZE) - 1 - SUBTILE_COVERAGE_BATCH_COUNT)
 		local uchar primitive_queue[LOCAL_MEM_BATCH_COUNT * BATCH_SIZE] __attribute__((aligned(16)));
 		unsigned int triangle_offsets[LOCAL_MEM_BATCH_COUNT]; // stores the triangle id offsets for valid batches
 		event_t events[LOCAL_MEM_BATCH_COUNT];
@@ -97,6 +205,10 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 			if(local_id == 0) {
 				// only done once per work-group (-> only work-item #0)
 				bin_idx = atomic_inc(bin_distribution_counter);
+#if defined(OCLRASTER_DEPTH_BOUNDS)
+				bin_depth_bounds[0] = ~0u;
+				bin_depth_bounds[1] = 0u;
+#endif
 			}
 			barrier(CLK_LOCAL_MEM_FENCE);
 			
@@ -110,7 +222,20 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 		{
 #endif
 			
-#if defined(LOCAL_MEM_COPY)
+#if defined(OCLRASTER_BINNING_SCATTER)
+			// scatter binning: each bin has a compact list of its non-empty batches
+			global const unsigned int* bin_lists = (global const unsigned int*)bin_queues;
+			const unsigned int entry_offset = bin_lists[bin_idx];
+			const unsigned int entry_count = bin_lists[bin_idx + 1u] - entry_offset;
+			
+			// early-out when the bin is empty
+#if !defined(NO_BARRIER)
+			if(entry_count == 0) continue;
+#else
+			if(entry_count == 0) return;
+#endif
+			global const unsigned int* bin_entries = &bin_lists[bin_count_lin + 1u + entry_offset * SCATTER_ENTRY_SIZE];
+#elif defined(LOCAL_MEM_COPY)
 			// only read batches into local memory when they're non-empty
 			// note that this doesn't require any synchronization, since it's the same for all work-items
 			unsigned int valid_batch_count = 0;
@@ -140,9 +265,47 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 			
 			//
 			const uint2 bin_location = (uint2)(bin_idx % bin_count.x, bin_idx / bin_count.x) + bin_offset;
+#if defined(OCLRASTER_DEPTH_BOUNDS)
+			float depth_min = INFINITY, depth_max = -INFINITY;
+#endif
+			
+			// per-bin primitive count (bit 1): counted from the bin queues once per bin
+			// (-> independent of the fragments, which may all be outside of the scissor rectangle or framebuffer)
+			if((collect_statistics & 2u) != 0u && local_id == 0u) {
+				unsigned int bin_primitives = 0u;
+#if defined(OCLRASTER_BINNING_SCATTER)
+				for(unsigned int entry_idx = 0; entry_idx < entry_count; entry_idx++) {
+					for(unsigned int word_idx = 0; word_idx < SCATTER_MASK_WORDS; word_idx++) {
+						for(unsigned int mask = bin_entries[entry_idx * SCATTER_ENTRY_SIZE + 1u + word_idx];
+							mask != 0u; mask &= mask - 1u) {
+							bin_primitives++;
+						}
+					}
+				}
+#else
+				for(unsigned int batch_idx = 0; batch_idx < valid_batch_count; batch_idx++) {
+#if defined(LOCAL_MEM_COPY)
+					local const uchar* queue_ptr = &primitive_queue[batch_idx * BATCH_SIZE];
+#else
+					global const uchar* queue_ptr = &bin_queues[global_queue_offset + batch_idx * BATCH_SIZE];
+					if(queue_ptr[0] == 0xFF && queue_ptr[1] == 0xFF) continue; // empty queue
+#endif
+					for(unsigned int idx = 0; idx < BATCH_SIZE; idx++) {
+						if(queue_ptr[idx] < idx) break; // end of queue
+						bin_primitives++;
+					}
+				}
+#endif
+				if(bin_primitives != 0u) {
+					atomic_add(&bin_primitive_counts[bin_location.y * ((debug_output_pitch + BIN_SIZE - 1u) / BIN_SIZE) + bin_location.x],
+							   bin_primitives);
+				}
+			}
+			
 			for(unsigned int i = 0; i < intra_bin_groups; i++) {
 				const unsigned int fragment_idx = (i * local_size) + local_id;
 				const uint2 local_xy = (uint2)(fragment_idx % BIN_SIZE, fragment_idx / BIN_SIZE);
+#if !defined(OCLRASTER_HIERARCHICAL_RASTERIZATION)
 				if(local_xy.y >= BIN_SIZE) continue;
 				const unsigned int x = bin_location.x * BIN_SIZE + local_xy.x;
 				const unsigned int y = bin_location.y * BIN_SIZE + local_xy.y;
@@ -152,19 +315,74 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 				   y < scissor_rectangle.y || y > scissor_rectangle.w) {
 					continue;
 				}
+				const bool fully_covered = false;
+#else
+				// all work-items must take part in the sub-tile classification (barriers)
+				// -> invalid fragments don't early-out, but have an empty sub-tile mask (and are clamped to the framebuffer)
+				const unsigned int unclamped_x = bin_location.x * BIN_SIZE + local_xy.x;
+				const unsigned int unclamped_y = bin_location.y * BIN_SIZE + local_xy.y;
+				const bool valid_fragment = (local_xy.y < BIN_SIZE &&
+											 unclamped_x < framebuffer_size.x && unclamped_y < framebuffer_size.y &&
+											 unclamped_x >= scissor_rectangle.x && unclamped_x <= scissor_rectangle.z &&
+											 unclamped_y >= scissor_rectangle.y && unclamped_y <= scissor_rectangle.w);
+				const unsigned int x = min(unclamped_x, framebuffer_size.x - 1u);
+				const unsigned int y = min(unclamped_y, framebuffer_size.y - 1u);
+				const float2 fragment_coord = (float2)(x, y) + 0.5f;
+				const unsigned int subtile_bit = (valid_fragment ?
+												  1u << ((local_xy.y / SUBTILE_SIZE) * 4u + (local_xy.x / SUBTILE_SIZE)) : 0u);
+#endif
 				
 				//###OCLRASTER_FRAMEBUFFER_READ###
 				
+#if defined(OCLRASTER_FIXED_POINT_RASTERIZATION)
+				// fragment center in sub-pixel space
+				const long2 fixed_coord = (long2)((long)x * OCLRASTER_SUBPIXEL_SCALE + (OCLRASTER_SUBPIXEL_SCALE / 2),
+												  (long)y * OCLRASTER_SUBPIXEL_SCALE + (OCLRASTER_SUBPIXEL_SCALE / 2));
+#endif
 				// simple counter/flag that signals if fragments have passed
 				// (actual value doesn't matter, only if it's 0.0f or not)
 				float fragments_passed = 0.0f;
+				// pipeline statistics counters of this fragment (-> accumulated once per fragment)
+				unsigned int tested_fragments = 0u, depth_passed_fragments = 0u, invocation_count = 0u;
 				
 				//
+#if defined(OCLRASTER_BINNING_SCATTER)
+				// iterate over all set primitive bits in ascending order (-> primitive submission order is kept)
+				for(unsigned int entry_idx = 0; entry_idx < entry_count; entry_idx++) {
+					global const unsigned int* entry = &bin_entries[entry_idx * SCATTER_ENTRY_SIZE];
+					const unsigned int primitive_offset = entry[0] * BATCH_SIZE;
+#if defined(OCLRASTER_HIERARCHICAL_RASTERIZATION)
+					// classify the sub-tiles for all primitives in this batch (across the work-group)
+					barrier(CLK_LOCAL_MEM_FENCE); // all work-items must be done with the previous masks
+					for(unsigned int idx = local_id; idx < BATCH_SIZE; idx += local_size) {
+						if((entry[1u + idx / 32u] & (1u << (idx % 32u))) == 0u) continue;
+						subtile_coverage[idx] = classify_subtiles(&transformed_buffer[primitive_offset + idx], bin_location);
+					}
+					barrier(CLK_LOCAL_MEM_FENCE);
+#endif
+					for(unsigned int word_idx = 0; word_idx < SCATTER_MASK_WORDS; word_idx++) {
+						for(unsigned int mask = entry[1u + word_idx]; mask != 0u;) {
+							const unsigned int lowest_bit = mask & (~mask + 1u);
+							mask ^= lowest_bit;
+							const unsigned int primitive_id = primitive_offset + (word_idx * 32u) + (31u - clz(lowest_bit));
+#else
 				for(unsigned int batch_idx = 0, queue_offset = 0;
 					batch_idx < valid_batch_count;
 					batch_idx++, queue_offset += BATCH_SIZE) {
 #if defined(LOCAL_MEM_COPY)
 					local const uchar* queue_ptr = &primitive_queue[queue_offset];
+#if defined(OCLRASTER_HIERARCHICAL_RASTERIZATION)
+					// classify the sub-tiles for all primitives in this batch (across the work-group)
+					// note: entries after the end of the queue are garbage, but still valid primitive indices of this batch
+					barrier(CLK_LOCAL_MEM_FENCE); // all work-items must be done with the previous masks
+					for(unsigned int idx = local_id; idx < BATCH_SIZE; idx += local_size) {
+						const unsigned int queue_data = queue_ptr[idx];
+						if(queue_data < idx) continue; // end of queue
+						subtile_coverage[queue_data] = classify_subtiles(&transformed_buffer[triangle_offsets[batch_idx] + queue_data],
+																		 bin_location);
+					}
+					barrier(CLK_LOCAL_MEM_FENCE);
+#endif
 #else
 					global const uchar* queue_ptr = &bin_queues[global_queue_offset + queue_offset];
 					
@@ -183,10 +401,59 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 #else
 						const unsigned int primitive_id = queue_offset + queue_data;
 #endif
-						const unsigned int instance_id = primitive_id / instance_primitive_count;
+#endif
+						// primitive id relative to the draw call (primitive_id is relative to the current chunk or the merged range)
+						const unsigned int draw_primitive_id = (merged_draws == 0u ?
+																draw_primitive_offset + primitive_id :
+																primitive_id - merged_draw_offsets[primitive_id / BATCH_SIZE]);
+						const unsigned int instance_id = draw_primitive_id / instance_primitive_count;
+#if defined(OCLRASTER_HIERARCHICAL_RASTERIZATION)
+						// skip the primitive if the sub-tile of this fragment is empty
+						const unsigned int coverage = subtile_coverage[primitive_id % BATCH_SIZE];
+						if((coverage & subtile_bit) == 0u) continue;
+						const bool fully_covered = ((coverage >> 16u) & subtile_bit) != 0u;
+#endif
 						
 						//
 						{
+#if defined(OCLRASTER_FIXED_POINT_RASTERIZATION)
+							// fixed-point rasterization: exact integer edge functions (in sub-pixel space), set up once per
+							// primitive in processing.cl -> edge functions 1 and 2 are relative to vertex 0 and edge function 0
+							// follows from the constant edge sum (-> 4 multiplications per fragment and primitive)
+							// -> no epsilons necessary, adjacent primitives never produce cracks or double hits
+							global const int* fixed_data = (global const int*)transformed_buffer[primitive_id].data;
+							const long2 fixed_offset = fixed_coord - (long2)(fixed_data[4], fixed_data[5]);
+							const long edge_sum = (((long)fixed_data[7] << 32) | (long)(uint)fixed_data[6]);
+							const long edge_a[3] = { -((long)fixed_data[0] + (long)fixed_data[2]), fixed_data[0], fixed_data[2] };
+							const long edge_b[3] = { -((long)fixed_data[1] + (long)fixed_data[3]), fixed_data[1], fixed_data[3] };
+							long edge_values[3];
+							edge_values[1] = edge_a[1] * fixed_offset.x + edge_b[1] * fixed_offset.y;
+							edge_values[2] = edge_a[2] * fixed_offset.x + edge_b[2] * fixed_offset.y;
+							edge_values[0] = edge_sum - edge_values[1] - edge_values[2];
+							
+							// top-left rule: a fragment exactly on an edge is only inside if a > 0 or (a == 0 and b < 0)
+							// note: the inside test is not necessary if the sub-tile is fully covered
+							if(!fully_covered) {
+								bool outside = false;
+								for(unsigned int edge_idx = 0; edge_idx < 3; edge_idx++) {
+									if(edge_values[edge_idx] < 0 ||
+									   (edge_values[edge_idx] == 0 &&
+										!(edge_a[edge_idx] > 0 || (edge_a[edge_idx] == 0 && edge_b[edge_idx] < 0)))) {
+										outside = true;
+										break;
+									}
+								}
+								if(outside) continue;
+							}
+							
+							// the sum of all edge functions is constant across the primitive (-> depth is already final)
+							// note: only covered fragments get here, the reciprocal edge sum is precomputed (-> no divisions)
+							const float inv_edge_sum = transformed_buffer[primitive_id].data[8];
+							float4 barycentric = (float4)(convert_float(edge_values[0]) * inv_edge_sum,
+														  convert_float(edge_values[1]) * inv_edge_sum,
+														  convert_float(edge_values[2]) * inv_edge_sum,
+														  transformed_buffer[primitive_id].data[9]);
+#else
 							const float3 VV0 = (float3)(transformed_buffer[primitive_id].data[0],
 														transformed_buffer[primitive_id].data[1],
 														transformed_buffer[primitive_id].data[2]);
@@ -203,52 +470,62 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 														  mad(fragment_coord.x, VV2.x, mad(fragment_coord.y, VV2.y, VV2.z)),
 														  transformed_buffer[primitive_id].data[9]); // .w = computed depth
 							
+							// note: the inside test is not necessary if the sub-tile is fully covered
 #if defined(OCLRASTER_PROJECTION_PERSPECTIVE)
-							if(barycentric.x >= 0.0f || barycentric.y >= 0.0f || barycentric.z >= 0.0f) continue;
+							if(!fully_covered &&
+							   (barycentric.x >= 0.0f || barycentric.y >= 0.0f || barycentric.z >= 0.0f)) continue;
 #elif defined(OCLRASTER_PROJECTION_ORTHOGRAPHIC)
 #define BARYCENTRIC_EPSILON 0.00001f
-							// this is sadly necessary, due to fp imprecision (this proved to be the most stable/consistent solution)
-							barycentric.xyz = select(barycentric.xyz, (float3)(0.0f),
-													 isless(fabs(barycentric.xyz), (float3)(BARYCENTRIC_EPSILON)));
-							
-							// general case: completely outside the primitive
-							if(barycentric.x < 0.0f || barycentric.y < 0.0f || barycentric.z < 0.0f) continue;
-							
-							// "consistency rules" (fragment is on the edge of a primitive or on a vertex):
-							// -> at least one barycentrix element "i" is 0
-							// -> valid fragment if: VVi.x must be > 0 or VVi.x must be == 0 and VVi.y must be < 0
-							if(barycentric.x == 0.0f) {
-								if(VV0.x < 0.0f) continue;
-								else if(VV0.x == 0.0f && VV0.y >= 0.0f) continue;
-							}
-							if(barycentric.y == 0.0f) {
-								if(VV1.x < 0.0f) continue;
-								else if(VV1.x == 0.0f && VV1.y >= 0.0f) continue;
-							}
-							if(barycentric.z == 0.0f) {
-								if(VV2.x < 0.0f) continue;
-								else if(VV2.x == 0.0f && VV2.y >= 0.0f) continue;
+							if(!fully_covered) {
+								// this is sadly necessary, due to fp imprecision (this proved to be the most stable/consistent solution)
+								barycentric.xyz = select(barycentric.xyz, (float3)(0.0f),
+														 isless(fabs(barycentric.xyz), (float3)(BARYCENTRIC_EPSILON)));
+								
+								// general case: completely outside the primitive
+								if(barycentric.x < 0.0f || barycentric.y < 0.0f || barycentric.z < 0.0f) continue;
+								
+								// "consistency rules" (fragment is on the edge of a primitive or on a vertex):
+								// -> at least one barycentrix element "i" is 0
+								// -> valid fragment if: VVi.x must be > 0 or VVi.x must be == 0 and VVi.y must be < 0
+								if(barycentric.x == 0.0f) {
+									if(VV0.x < 0.0f) continue;
+									else if(VV0.x == 0.0f && VV0.y >= 0.0f) continue;
+								}
+								if(barycentric.y == 0.0f) {
+									if(VV1.x < 0.0f) continue;
+									else if(VV1.x == 0.0f && VV1.y >= 0.0f) continue;
+								}
+								if(barycentric.z == 0.0f) {
+									if(VV2.x < 0.0f) continue;
+									else if(VV2.x == 0.0f && VV2.y >= 0.0f) continue;
+								}
 							}
 #endif
 							
 							// simplified:
 							barycentric /= barycentric.x + barycentric.y + barycentric.z;
+#endif
 							
 							// ignore fragments with negative depth
 							if(barycentric.w < 0.0f) continue;
+							tested_fragments++;
 							
 #if !defined(OCLRASTER_NO_DEPTH) && !defined(OCLRASTER_NO_DEPTH_TEST)
 #if !defined(OCLRASTER_DEPTH_OVERRIDE)
 							// early depth test
 							if(!depth_test(barycentric.w, *fragment_depth)) continue;
+							depth_passed_fragments++;
 #else
 							// need to save the old depth value if the user overwrites the framebuffer depth
 							const float prev_depth = *fragment_depth;
 #endif
+#else
+							depth_passed_fragments++; // no depth test
 #endif
 							
 							// note: if a fragment is discarded, this will "continue"
 							// -> depth is not updated and fragment counter is not increased
+							invocation_count++;
 							//###OCLRASTER_USER_MAIN_CALL###
 							
 #if !defined(OCLRASTER_NO_DEPTH) && !defined(OCLRASTER_NO_DEPTH_TEST)
@@ -261,11 +538,15 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 								*fragment_depth = prev_depth; // restore previous depth value
 								continue;
 							}
+							depth_passed_fragments++;
 #endif
 #endif
 							
 							fragments_passed += 1.0f;
 						}
+#if defined(OCLRASTER_BINNING_SCATTER)
+						}
+#endif
 					}
 					
 					// write framebuffer output (if any fragment has passed)
@@ -273,7 +554,55 @@ static constexpr char template_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
 						//###OCLRASTER_FRAMEBUFFER_WRITE###
 					}
 				}
+				
+				// pipeline statistics (bit 0) and per-pixel overdraw (bit 1)
+				if(collect_statistics != 0u && tested_fragments != 0u) {
+					const unsigned int written_fragments = (unsigned int)fragments_passed;
+					if((collect_statistics & 1u) != 0u) {
+						atomic_add(&pipeline_statistics[4], tested_fragments);
+						atomic_add(&pipeline_statistics[5], depth_passed_fragments);
+						atomic_add(&pipeline_statistics[6], invocation_count);
+						atomic_add(&pipeline_statistics[7], written_fragments);
+					}
+					// note: each fragment is only handled by a single work-item -> no atomics necessary
+					if((collect_statistics & 2u) != 0u && written_fragments != 0u) {
+						overdraw_counts[y * debug_output_pitch + x] += written_fragments;
+					}
+				}
+#if defined(OCLRASTER_DEPTH_BOUNDS)
+				depth_min = fmin(depth_min, *fragment_depth);
+				depth_max = fmax(depth_max, *fragment_depth);
+#endif
 			}
+			
+#if defined(OCLRASTER_DEPTH_BOUNDS)
+			// update the depth bounds of this bin (-> used by the binner to reject occluded primitives)
+			if(update_depth_bounds != 0) {
+				const unsigned int depth_bounds_idx = bin_location.y * depth_bounds_pitch + bin_location.x;
+#if !defined(NO_BARRIER)
+				// note: the work-group covers all fragments of the bin (incl. the ones outside the scissor rectangle)
+				atomic_min(&bin_depth_bounds[0], depth_to_ordered(depth_min));
+				atomic_max(&bin_depth_bounds[1], depth_to_ordered(depth_max));
+				barrier(CLK_LOCAL_MEM_FENCE);
+				if(local_id == 0) {
+					depth_bounds[depth_bounds_idx] = (float2)(ordered_to_depth(bin_depth_bounds[0]),
+															  ordered_to_depth(bin_depth_bounds[1]));
+				}
+#else
+				// fragments outside the scissor rectangle haven't been visited -> merge with the previous bounds
+				const unsigned int bin_start_x = bin_location.x * BIN_SIZE, bin_start_y = bin_location.y * BIN_SIZE;
+				const unsigned int bin_end_x = min(bin_start_x + BIN_SIZE - 1u, framebuffer_size.x - 1u);
+				const unsigned int bin_end_y = min(bin_start_y + BIN_SIZE - 1u, framebuffer_size.y - 1u);
+				if(bin_start_x < scissor_rectangle.x || bin_start_y < scissor_rectangle.y ||
+				   bin_end_x > scissor_rectangle.z || bin_end_y > scissor_rectangle.w) {
+					const float2 prev_bounds = depth_bounds[depth_bounds_idx];
+					depth_min = fmin(depth_min, prev_bounds.x);
+					depth_max = fmax(depth_max, prev_bounds.y);
+				}
+				depth_bounds[depth_bounds_idx] = (float2)(depth_min, depth_max);
+#endif
+			}
+#endif
 		}
 	}
 )OCLRASTER_RAWSTR"};
@@ -289,6 +618,7 @@ oclraster_program(code, entry_function_, "-DOCLRASTER_RASTERIZATION_PROGRAM "+bu
 }
 
 rasterization_program::~rasterization_program() {
+	finish_background_compilation();
 }
 
 string rasterization_program::specialized_processing(const string& code,
@@ -356,7 +686,7 @@ string rasterization_program::specialized_processing(const string& code,
 	}
 	if(has_output_structs) {
 		// reading indices is only necessary when transform stage output variables must be interpolated
-		buffer_handling_code = ("const unsigned int instance_index_offset = instance_id * instance_index_count;\nMAKE_PRIMITIVE_INDICES(indices);\n" +
+		buffer_handling_code = ("const unsigned int instance_index_offset = instance_id * instance_index_count;\nMAKE_PRIMITIVE_INDICES(indices, draw_primitive_offset + primitive_id);\n" +
 								buffer_handling_code);
 	}
 	for(size_t i = 0, img_count = image_decls.size(); i < img_count; i++) {
@@ -364,7 +694,7 @@ string rasterization_program::specialized_processing(const string& code,
 		if(images.is_framebuffer[i]) continue;
 		main_call_parameters += images.image_names[i] + ", ";
 	}
-	main_call_parameters += "&framebuffer, fragment_coord, barycentric.w, barycentric.xyz, primitive_id, instance_id"; // the same for all rasterization programs
+	main_call_parameters += "&framebuffer, fragment_coord, barycentric.w, barycentric.xyz, draw_primitive_id, instance_id"; // the same for all rasterization programs
 	const string main_call = "if(!oclraster_user_"+entry_function+"("+main_call_parameters+")) continue;";
 	core::find_and_replace(program_code, "//###OCLRASTER_USER_MAIN_CALL###",
 						   buffer_handling_code+main_call);
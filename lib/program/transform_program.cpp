@@ -88,6 +88,7 @@ oclraster_program(code, entry_function_, "-DOCLRASTER_TRANSFORM_PROGRAM "+build_
 }
 
 transform_program::~transform_program() {
+	finish_background_compilation();
 }
 
 string transform_program::specialized_processing(const string& code,
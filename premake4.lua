@@ -338,6 +338,99 @@ project "oclr_volume"
 			buildoptions { "-gdwarf-2" }
 		end
 
+-- tools
+project "oclr_bundle"
+	targetname "oclr_bundle"
+	kind "ConsoleApp"
+	language "C++"
+	files { "tools/oclr_bundle/src/**.h", "tools/oclr_bundle/src/**.cpp" }
+	basedir "tools/oclr_bundle"
+	targetdir "bin"
+
+	includedirs { "/usr/include/oclraster",
+				  "/usr/local/include/oclraster",
+				  "tools/oclr_bundle/src/" }
+
+	configuration "Release"
+		links { "oclraster" }
+		targetname "oclr_bundle"
+		defines { "NDEBUG" }
+		flags { "Optimize" }
+		if(not os.is("windows") or win_unixenv) then
+			buildoptions { "-O3 -ffast-math" }
+		end
+		
+	configuration "Debug"
+		links { "oclrasterd" }
+		targetname "oclr_bundled"
+		defines { "DEBUG", "OCLRASTER_DEBUG" }
+		flags { "Symbols" }
+		if(not os.is("windows") or win_unixenv) then
+			buildoptions { "-gdwarf-2" }
+		end
+
+project "oclr_bench"
+	targetname "oclr_bench"
+	kind "ConsoleApp"
+	language "C++"
+	files { "tools/oclr_bench/src/**.h", "tools/oclr_bench/src/**.cpp",
+			"samples/oclr_volume/src/volume.h", "samples/oclr_volume/src/volume.cpp" }
+	basedir "tools/oclr_bench"
+	targetdir "bin"
+
+	includedirs { "/usr/include/oclraster",
+				  "/usr/local/include/oclraster",
+				  "tools/oclr_bench/src/",
+				  "samples/oclr_volume/src/" }
+
+	configuration "Release"
+		links { "oclraster" }
+		targetname "oclr_bench"
+		defines { "NDEBUG" }
+		flags { "Optimize" }
+		if(not os.is("windows") or win_unixenv) then
+			buildoptions { "-O3 -ffast-math" }
+		end
+		
+	configuration "Debug"
+		links { "oclrasterd" }
+		targetname "oclr_benchd"
+		defines { "DEBUG", "OCLRASTER_DEBUG" }
+		flags { "Symbols" }
+		if(not os.is("windows") or win_unixenv) then
+			buildoptions { "-gdwarf-2" }
+		end
+
+project "oclr_microbench"
+	targetname "oclr_microbench"
+	kind "ConsoleApp"
+	language "C++"
+	files { "tools/oclr_microbench/src/**.h", "tools/oclr_microbench/src/**.cpp" }
+	basedir "tools/oclr_microbench"
+	targetdir "bin"
+
+	includedirs { "/usr/include/oclraster",
+				  "/usr/local/include/oclraster",
+				  "tools/oclr_microbench/src/" }
+
+	configuration "Release"
+		links { "oclraster" }
+		targetname "oclr_microbench"
+		defines { "NDEBUG" }
+		flags { "Optimize" }
+		if(not os.is("windows") or win_unixenv) then
+			buildoptions { "-O3 -ffast-math" }
+		end
+		
+	configuration "Debug"
+		links { "oclrasterd" }
+		targetname "oclr_microbenchd"
+		defines { "DEBUG", "OCLRASTER_DEBUG" }
+		flags { "Symbols" }
+		if(not os.is("windows") or win_unixenv) then
+			buildoptions { "-gdwarf-2" }
+		end
+
 -- oclraster_support lib and samples
 project "liboclraster_support"
 	-- project settings
@@ -26,6 +26,7 @@ static constexpr float3 cam_speeds { 0.01f, 0.1f, 0.001f };
 static atomic<unsigned int> update_model { false };
 static atomic<unsigned int> update_light { true };
 static atomic<unsigned int> update_light_color { false };
+static atomic<unsigned int> run_binning_benchmark { false };
 static transform_program* transform_prog { nullptr };
 static rasterization_program* rasterization_prog { nullptr };
 static pipeline* p { nullptr };
@@ -181,6 +182,17 @@ int main(int argc oclr_unused, char* argv[]) {
 	float3 model_scale { 1.0f, 1.0f, 1.0f };
 	float3 target_scale { model_scale };
 	static constexpr float model_scale_range = 0.4f, model_scale_step = 0.01f;
+	const auto draw_model = [&]() {
+		p->bind_buffer("index_buffer", index_buffer);
+		p->bind_buffer("input_attributes", input_attributes);
+		p->bind_buffer("tp_uniforms", *tp_uniforms_buffer);
+		p->bind_buffer("rp_uniforms", *rp_uniforms_buffer);
+		p->bind_image("diffuse_texture", *materials[selected_material][0]);
+		p->bind_image("normal_texture", *materials[selected_material][1]);
+		p->bind_image("height_texture", *materials[selected_material][2]);
+		p->bind_image("fp_noise", *fp_noise);
+		p->draw(PRIMITIVE_TYPE::TRIANGLE, model->get_vertex_count(), { 0, model->get_index_count(0) });
+	};
 	while(!done) {
 		// event handling
 		evt->handle_events();
@@ -204,6 +216,16 @@ int main(int argc oclr_unused, char* argv[]) {
 			caption << " | Cam: " << cam->get_position();
 			caption << " " << cam->get_rotation();
 			oclraster::set_caption(caption.str());
+			
+			if(p->get_collect_bin_statistics()) {
+				const auto bin_stats = p->get_bin_statistics();
+				oclr_log("bin/primitive pairs: aabb: %u, edge test: %u (%f%% rejected), depth bounds rejected: %u",
+						 bin_stats.aabb_pairs, bin_stats.edge_pairs,
+						 bin_stats.aabb_pairs == 0 ? 0.0f :
+						 100.0f * float(bin_stats.aabb_pairs - bin_stats.edge_pairs) / float(bin_stats.aabb_pairs),
+						 bin_stats.depth_rejected_pairs);
+				p->reset_bin_statistics();
+			}
 		}
 		
 		oclraster::start_draw();
@@ -262,17 +284,14 @@ int main(int argc oclr_unused, char* argv[]) {
 		ocl->write_buffer(rp_uniforms_buffer, &rasterize_uniforms);
 		
 		// draw something
-		p->bind_buffer("index_buffer", index_buffer);
-		p->bind_buffer("input_attributes", input_attributes);
-		p->bind_buffer("tp_uniforms", *tp_uniforms_buffer);
-		p->bind_buffer("rp_uniforms", *rp_uniforms_buffer);
-		p->bind_image("diffuse_texture", *materials[selected_material][0]);
-		p->bind_image("normal_texture", *materials[selected_material][1]);
-		p->bind_image("height_texture", *materials[selected_material][2]);
-		p->bind_image("fp_noise", *fp_noise);
-		p->draw(PRIMITIVE_TYPE::TRIANGLE, model->get_vertex_count(), { 0, model->get_index_count(0) });
+		draw_model();
 		
 		oclraster::stop_draw();
+		
+		if(run_binning_benchmark) {
+			run_binning_benchmark = false;
+			binning_benchmark(draw_model);
+		}
 	}
 	
 	// cleanup
@@ -297,16 +316,66 @@ int main(int argc oclr_unused, char* argv[]) {
 	return 0;
 }
 
-bool load_programs() {
-	if(transform_prog != nullptr) {
-		delete transform_prog;
-		transform_prog = nullptr;
-	}
-	if(rasterization_prog != nullptr) {
-		delete rasterization_prog;
-		rasterization_prog = nullptr;
-	}
+void binning_benchmark(const function<void()>& draw_model) {
+	// renders the current scene into offscreen framebuffers of different sizes,
+	// once with single-level binning and once with two-level (coarse/fine) binning
+	static constexpr unsigned int frame_count { 50 };
+	static const array<pair<const char*, uint2>, 4> resolutions {
+		{
+			{ "720p", { 1280, 720 } },
+			{ "1080p", { 1920, 1080 } },
+			{ "1440p", { 2560, 1440 } },
+			{ "4K", { 3840, 2160 } },
+		}
+	};
 	
+	oclraster::acquire_context();
+	const unsigned int prev_threshold = p->get_coarse_binning_threshold();
+	const BINNING prev_binning = p->get_binning();
+	p->set_binning(BINNING::GATHER);
+	oclr_log("binning benchmark (%u frames per run):", frame_count);
+	for(const auto& res : resolutions) {
+		framebuffer fb = framebuffer::create_with_images(res.second.x, res.second.y,
+														 { { IMAGE_TYPE::UINT_8, IMAGE_CHANNEL::RGBA } },
+														 { IMAGE_TYPE::FLOAT_32, IMAGE_CHANNEL::R });
+		p->bind_framebuffer(&fb);
+		p->set_camera(cam);
+		
+		// [0] = single-level, [1] = two-level
+		array<double, 2> frame_times;
+		for(size_t i = 0; i < frame_times.size(); i++) {
+			p->set_coarse_binning_threshold(i == 0 ? 0 : 1);
+			
+			// warm-up (kernel compilation, buffer allocation)
+			fb.clear();
+			draw_model();
+			p->flush();
+			ocl->finish();
+			
+			const auto start = SDL_GetPerformanceCounter();
+			for(unsigned int frame = 0; frame < frame_count; frame++) {
+				fb.clear();
+				draw_model();
+			}
+			p->flush();
+			ocl->finish();
+			frame_times[i] = (double(SDL_GetPerformanceCounter() - start) * 1000.0 /
+							  (double(SDL_GetPerformanceFrequency()) * double(frame_count)));
+		}
+		oclr_log("%s (%v): single-level: %fms, two-level: %fms (speedup: %fx)",
+				 res.first, res.second, frame_times[0], frame_times[1],
+				 frame_times[1] > 0.0 ? frame_times[0] / frame_times[1] : 0.0);
+		
+		p->bind_framebuffer(nullptr);
+		framebuffer::destroy_images(fb);
+	}
+	p->set_coarse_binning_threshold(prev_threshold);
+	p->set_binning(prev_binning);
+	p->set_camera(cam);
+	oclraster::release_context();
+}
+
+bool load_programs(const bool force_reload) {
 	string vs_str, fs_str;
 	static const array<string, 2> shader_filenames {
 #if 0
@@ -328,16 +397,41 @@ bool load_programs() {
 		oclr_error("couldn't open fs program!");
 		return false;
 	}
+	
+	// keep the current programs if neither their code nor anything they depend on has changed
+	static string cur_vs_str, cur_fs_str;
+	if(!force_reload && transform_prog != nullptr && rasterization_prog != nullptr &&
+	   vs_str == cur_vs_str && fs_str == cur_fs_str) {
+		return true;
+	}
+	cur_vs_str = vs_str;
+	cur_fs_str = fs_str;
+	
+	if(transform_prog != nullptr) {
+		delete transform_prog;
+		transform_prog = nullptr;
+	}
+	if(rasterization_prog != nullptr) {
+		delete rasterization_prog;
+		rasterization_prog = nullptr;
+	}
+	
+	// probe the struct layouts of both programs at once
+	oclraster_program::begin_struct_probe_batch();
 	transform_prog = new transform_program(vs_str, "transform_main");
 	rasterization_prog = new rasterization_program(fs_str, "rasterize_main");
+	oclraster_program::end_struct_probe_batch();
 	p->bind_program(*transform_prog);
 	p->bind_program(*rasterization_prog);
 	return true;
 }
 
-bool kernel_reload_handler(EVENT_TYPE type, shared_ptr<event_object> obj oclr_unused) {
+bool kernel_reload_handler(EVENT_TYPE type, shared_ptr<event_object> obj) {
 	if(type == EVENT_TYPE::KERNEL_RELOAD) {
-		load_programs();
+		const kernel_reload_event& reload_evt = (const kernel_reload_event&)*obj;
+		load_programs(reload_evt.full_reload ||
+					  (transform_prog != nullptr && transform_prog->depends_on(reload_evt.changed_files)) ||
+					  (rasterization_prog != nullptr && rasterization_prog->depends_on(reload_evt.changed_files)));
 		return true;
 	}
 	return false;
@@ -382,6 +476,13 @@ bool key_handler(EVENT_TYPE type, shared_ptr<event_object> obj) {
 			case SDLK_f:
 				p->_set_fxaa_state(p->_get_fxaa_state() ^ true);
 				break;
+			case SDLK_b:
+				p->set_collect_bin_statistics(p->get_collect_bin_statistics() ^ true);
+				p->reset_bin_statistics();
+				break;
+			case SDLK_n:
+				run_binning_benchmark = true;
+				break;
 			case SDLK_1:
 				selected_material = 0;
 				break;
@@ -37,7 +37,8 @@ bool mouse_handler(EVENT_TYPE type, shared_ptr<event_object> obj);
 bool quit_handler(EVENT_TYPE type, shared_ptr<event_object> obj);
 bool kernel_reload_handler(EVENT_TYPE type, shared_ptr<event_object> obj);
 
-bool load_programs();
+bool load_programs(const bool force_reload = true);
+void binning_benchmark(const function<void()>& draw_model);
 
 #if defined(OCLRASTER_IOS)
 bool touch_handler(EVENT_TYPE type, shared_ptr<event_object> obj);
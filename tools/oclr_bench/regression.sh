@@ -0,0 +1,46 @@
+#!/bin/sh
+
+# ci regression step for oclr_bench (golden images + timing baseline of all bench and sample scenes)
+# usage: regression.sh <update|check> <reference dir> [additional oclr_bench args]
+# * update: run with a known good build (e.g. the last release) on the ci machine, writes the reference images,
+#   the timing baseline and the revision they were generated from to <reference dir>
+# * check: run with the build that should be tested (on the same machine), exits with 1 if any scene regressed
+# note: the references are device and driver specific, which is why they aren't part of the repository
+#       -> they must be regenerated whenever the ci machine, its opencl driver or the reference revision changes
+# note: oclraster and oclr_bench must have been built and installed beforehand (./premake.sh && make)
+
+OCLR_MODE=$1
+OCLR_REF_DIR=$2
+if [[ -z $OCLR_MODE || -z $OCLR_REF_DIR ]]; then
+	echo "usage: regression.sh <update|check> <reference dir> [additional oclr_bench args]"
+	exit 1
+fi
+shift 2
+
+# oclr_bench must be run from the bin folder (-> ../data/)
+OCLR_ROOT=$( cd "$( dirname "$0" )/../.." && pwd )
+mkdir -p "${OCLR_REF_DIR}/golden"
+OCLR_REF_DIR=$( cd "${OCLR_REF_DIR}" && pwd )
+cd "${OCLR_ROOT}/bin"
+
+case $OCLR_MODE in
+	"update")
+		./oclr_bench -o "${OCLR_REF_DIR}/bench.json" --golden "${OCLR_REF_DIR}/golden" \
+			--baseline "${OCLR_REF_DIR}/baseline.json" --update "$@" || exit 1
+		git -C "${OCLR_ROOT}" rev-parse HEAD > "${OCLR_REF_DIR}/revision"
+		echo "references generated from revision $( cat "${OCLR_REF_DIR}/revision" )"
+		;;
+	"check")
+		if [[ ! -f "${OCLR_REF_DIR}/revision" ]]; then
+			echo "no references in ${OCLR_REF_DIR} - run \"regression.sh update\" with the reference build first"
+			exit 1
+		fi
+		echo "checking against the references of revision $( cat "${OCLR_REF_DIR}/revision" )"
+		./oclr_bench -o bench.json --golden "${OCLR_REF_DIR}/golden" \
+			--baseline "${OCLR_REF_DIR}/baseline.json" "$@" || exit 1
+		;;
+	*)
+		echo "unknown mode \"${OCLR_MODE}\" (must be update or check)"
+		exit 1
+		;;
+esac
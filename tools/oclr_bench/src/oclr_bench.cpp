@@ -0,0 +1,909 @@
+/*
+ *  Flexible OpenCL Rasterizer (oclraster)
+ *  Copyright (C) 2012 - 2013 Florian Ziesche
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License only.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "oclr_bench.h"
+#include "volume.h"
+#include "regression.h"
+
+// renders fixed camera paths (one orbit around each scene) over the shipped models, the volume and the sample
+// scenes in headless mode and writes the results (frame time percentiles, per-stage times, compile time,
+// peak device memory) as json.
+// note: per-stage times are only available when oclraster was built with --cl-profiling
+// optionally, the results are checked against reference images and a timing baseline (see regression.h)
+
+static string output_filename { "bench.json" };
+static string device_name { "default" };
+static vector<string> scenes {
+	"bunny", "teapot", "monkey", "tux", "blend_test", "c60",
+	"oclr_simple", "oclr_rtt", "oclr_ui", "oclr_gl_cmp"
+};
+static vector<uint2> resolutions { { 1280, 720 } };
+static vector<unsigned int> instance_counts { 1 };
+static unsigned int frame_count { 120 };
+static regression_options regression_opts;
+
+// scenes that aren't an .a2m model in the data folder
+static const set<string> volume_scenes { "c60" };
+// scenes of the samples (same programs, textures and geometry, but a deterministic camera and uniforms)
+static const set<string> sample_scenes { "oclr_simple", "oclr_rtt", "oclr_ui", "oclr_gl_cmp" };
+
+static constexpr char bench_transform_program[] { u8R"OCLRASTER_RAWSTR(
+	oclraster_in bench_input {
+		float4 vertex;
+		float4 normal;
+		float4 binormal;
+		float4 tangent;
+		float2 tex_coord;
+	} input_attributes;
+
+	oclraster_out bench_output {
+		float4 normal;
+	} output_attributes;
+
+	oclraster_uniforms bench_uniforms {
+		float4 instance_grid; // .x = spacing, .y = #instances per row, .z = #rows
+	} tp_uniforms;
+
+	float4 transform_main() {
+		// all instances are laid out on a grid (in the xz plane) that is centered at the origin
+		const unsigned int per_row = (unsigned int)tp_uniforms->instance_grid.y;
+		const float2 grid_pos = (float2)((float)(instance_index % per_row) - (tp_uniforms->instance_grid.y - 1.0f) * 0.5f,
+										 (float)(instance_index / per_row) - (tp_uniforms->instance_grid.z - 1.0f) * 0.5f);
+		output_attributes->normal = input_attributes->normal;
+		return (float4)(input_attributes->vertex.x + grid_pos.x * tp_uniforms->instance_grid.x,
+						input_attributes->vertex.y,
+						input_attributes->vertex.z + grid_pos.y * tp_uniforms->instance_grid.x,
+						1.0f);
+	}
+)OCLRASTER_RAWSTR" };
+
+static constexpr char bench_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
+	oclraster_out bench_output {
+		float4 normal;
+	} output_attributes;
+
+	oclraster_framebuffer {
+		image2d color;
+		depth_image depth;
+	};
+
+	bool rasterize_main() {
+		const float3 light_dir = normalize((float3)(0.5f, 1.0f, 0.25f));
+		const float lambert_term = max(dot(normalize(output_attributes->normal.xyz), light_dir), 0.1f);
+		framebuffer->color = (float4)(lambert_term, lambert_term, lambert_term, 1.0f);
+		return true;
+	}
+)OCLRASTER_RAWSTR" };
+
+static double ticks_to_ms(const unsigned long long int ticks) {
+	return double(ticks) * 1000.0 / double(SDL_GetPerformanceFrequency());
+}
+
+int main(int argc, char* argv[]) {
+	if(!parse_args(argc, argv)) {
+		print_usage();
+		return -1;
+	}
+
+	// initialize oclraster in headless mode (no window, no opengl)
+	const auto init_start = SDL_GetPerformanceCounter();
+	oclraster::init(argv[0], (const char*)"../data/", true);
+	const double init_time = ticks_to_ms(SDL_GetPerformanceCounter() - init_start);
+
+	oclraster::acquire_context();
+	const bool regression_checks = (!regression_opts.golden_dir.empty() || !regression_opts.baseline_filename.empty());
+	if(regression_checks && device_name == "default") {
+		// references are device specific -> always use the cpu, unless a device was explicitly specified
+		device_name = "cpu";
+	}
+	if(device_name == "cpu" || device_name == "gpu") {
+		if(ocl->get_device(device_name == "cpu" ?
+						   opencl_base::DEVICE_TYPE::FASTEST_CPU :
+						   opencl_base::DEVICE_TYPE::FASTEST_GPU) == nullptr) {
+			oclr_error("no %s device available!", device_name);
+			oclraster::release_context();
+			oclraster::destroy();
+			return -1;
+		}
+		ocl->set_active_device(device_name == "cpu" ?
+							   opencl_base::DEVICE_TYPE::FASTEST_CPU :
+							   opencl_base::DEVICE_TYPE::FASTEST_GPU);
+	}
+	for(const auto& scene : scenes) {
+		if(sample_scenes.count(scene) == 0 &&
+		   !file_io::is_file(oclraster::data_path(volume_scenes.count(scene) > 0 ?
+												  "volumes/" + scene + ".dat" : scene + ".a2m"))) {
+			oclr_error("unknown scene \"%s\"!", scene);
+			oclraster::release_context();
+			oclraster::destroy();
+			return -1;
+		}
+	}
+	const opencl_base::device_object* device = ocl->get_active_device();
+	oclr_log("benchmarking on: %s (%s)", device->name, device->driver_version);
+	oclraster::release_context();
+
+	vector<bench_result> results;
+	const auto add_result = [&results](bench_result&& result) {
+		if(!result.valid) {
+			oclr_error("%s (%v): failed!", result.scene, result.resolution);
+		}
+		else {
+			oclr_log("%s (%v, %u instances): %fms/frame (compile: %fms, peak memory: %uMB)",
+					 result.scene, result.resolution, result.instance_count,
+					 accumulate(result.frame_times.cbegin(), result.frame_times.cend(), 0.0) / double(result.frame_count),
+					 result.compile_time, result.peak_memory / (1024 * 1024));
+		}
+		results.emplace_back(move(result));
+	};
+	for(const auto& scene : scenes) {
+		for(const auto& resolution : resolutions) {
+			if(volume_scenes.count(scene) > 0) {
+				add_result(run_volume_scene(scene, resolution));
+			}
+			else if(sample_scenes.count(scene) > 0) {
+				add_result(run_sample_scene(scene, resolution));
+			}
+			else {
+				for(const auto& instance_count : instance_counts) {
+					add_result(run_model_scene(scene, resolution, instance_count));
+				}
+			}
+		}
+	}
+
+	// write results
+	bool success = file_io::string_to_file(output_filename, results_to_json(results, init_time));
+	if(!success) oclr_error("couldn't write the results to \"%s\"!", output_filename);
+	else oclr_log("results written to \"%s\"", output_filename);
+
+	// regression checks (the reference images are loaded through opencl -> context is required)
+	if(regression_checks) {
+		oclraster::acquire_context();
+		if(!regression_opts.golden_dir.empty() &&
+		   !regression::check_golden_images(results, regression_opts)) {
+			success = false;
+		}
+		if(!regression_opts.baseline_filename.empty() &&
+		   !regression::check_baseline(results, regression_opts)) {
+			success = false;
+		}
+		oclraster::release_context();
+		if(regression_opts.update) oclr_log("references updated");
+		else oclr_log("regression checks %s", (success ? "passed" : "FAILED"));
+	}
+
+	oclraster::destroy();
+	return (success ? 0 : -1);
+}
+
+void print_usage() {
+	oclr_log("usage: oclr_bench [options]\n"
+			 "options (comma separated lists):\n"
+			 "\t-o <file>: output json file (default: bench.json)\n"
+			 "\t--device <default|cpu|gpu>: use the fastest cpu or gpu (default: the device chosen on init)\n"
+			 "\t--scenes <bunny,teapot,monkey,tux,blend_test,c60,oclr_simple,oclr_rtt,oclr_ui,oclr_gl_cmp>: (default: all)\n"
+			 "\t--resolutions <WxH,...>: (default: 1280x720)\n"
+			 "\t--instances <count,...>: instance counts of the model scenes (default: 1, the volume and sample scenes always use 1)\n"
+			 "\t--frames <count>: #frames per run, one camera orbit per run (default: 120)\n"
+			 "regression checks (the device defaults to cpu, exit code is -1 on failure):\n"
+			 "\t--golden <dir>: compare the first frame of each run against <dir>/<scene>_<W>x<H>_i<instances>.png\n"
+			 "\t--baseline <file>: compare the mean frame time and per-stage times against the baseline file\n"
+			 "\t--update: write the reference images and baseline instead of comparing against them\n"
+			 "\t--pixel-tolerance <0-255>: max channel difference of matching pixels (default: 8)\n"
+			 "\t--max-mismatch <percent>: max amount of mismatching pixels (default: 0.1)\n"
+			 "\t--max-slowdown <percent>: max slowdown of any stage (default: 10)");
+}
+
+bool parse_args(int argc, char* argv[]) {
+	for(int i = 1; i < argc; i++) {
+		const string arg { argv[i] };
+		if(arg == "--update") {
+			regression_opts.update = true;
+			continue;
+		}
+
+		// all other args have a value
+		if(i + 1 >= argc) {
+			oclr_error("missing value for argument \"%s\"!", arg);
+			return false;
+		}
+		const string value { argv[++i] };
+		if(arg == "-o") output_filename = value;
+		else if(arg == "--device") {
+			device_name = core::str_to_lower(value);
+			if(device_name != "default" && device_name != "cpu" && device_name != "gpu") {
+				oclr_error("invalid device \"%s\"!", value);
+				return false;
+			}
+		}
+		else if(arg == "--scenes") {
+			scenes.clear();
+			for(const auto& token : core::tokenize(value, ',')) {
+				// note: scene files are checked after init (-> data path)
+				if(!token.empty()) scenes.emplace_back(token);
+			}
+		}
+		else if(arg == "--resolutions") {
+			resolutions.clear();
+			for(const auto& token : core::tokenize(value, ',')) {
+				const auto dims = core::tokenize(token, 'x');
+				if(dims.size() != 2 || string2uint(dims[0]) == 0 || string2uint(dims[1]) == 0) {
+					oclr_error("invalid resolution \"%s\"!", token);
+					return false;
+				}
+				resolutions.emplace_back(string2uint(dims[0]), string2uint(dims[1]));
+			}
+		}
+		else if(arg == "--instances") {
+			instance_counts.clear();
+			for(const auto& token : core::tokenize(value, ',')) {
+				const unsigned int instance_count = string2uint(token);
+				if(instance_count == 0) {
+					oclr_error("invalid instance count \"%s\"!", token);
+					return false;
+				}
+				instance_counts.emplace_back(instance_count);
+			}
+		}
+		else if(arg == "--golden") regression_opts.golden_dir = value;
+		else if(arg == "--baseline") regression_opts.baseline_filename = value;
+		else if(arg == "--pixel-tolerance") {
+			regression_opts.pixel_tolerance = std::min(string2uint(value), 255u);
+		}
+		else if(arg == "--max-mismatch") {
+			regression_opts.max_mismatch = std::max((double)string2float(value), 0.0);
+		}
+		else if(arg == "--max-slowdown") {
+			regression_opts.max_slowdown = std::max((double)string2float(value), 0.0);
+		}
+		else if(arg == "--frames") {
+			frame_count = string2uint(value);
+			if(frame_count == 0) {
+				oclr_error("invalid frame count \"%s\"!", value);
+				return false;
+			}
+		}
+		else {
+			oclr_error("unknown argument \"%s\"!", arg);
+			return false;
+		}
+	}
+
+	if(scenes.empty() || resolutions.empty() || instance_counts.empty()) {
+		oclr_error("empty scene, resolution or instance count list!");
+		return false;
+	}
+	if(regression_opts.update && regression_opts.golden_dir.empty() && regression_opts.baseline_filename.empty()) {
+		oclr_error("--update requires --golden and/or --baseline!");
+		return false;
+	}
+	return true;
+}
+
+static void set_camera_look_at(pipeline* p, const float3& position, const float3& target) {
+	// same as pipeline::set_camera_setup_from_camera, but with an explicit view target
+	const uint2 fb_size = p->get_bound_framebuffer()->get_size();
+	const float2 fp_framebuffer_size { (float)fb_size.x, (float)fb_size.y };
+	const float aspect_ratio = fp_framebuffer_size.x / fp_framebuffer_size.y;
+	const float angle_ratio = tanf(DEG2RAD(oclraster::get_fov() * 0.5f)) * 2.0f;
+
+	const float3 forward { (target - position).normalized() };
+	const float3 right { (float3(0.0f, 1.0f, 0.0f) ^ forward).normalized() };
+	const float3 up { (forward ^ right).normalized() };
+	const float3 width_vec { right * angle_ratio * aspect_ratio };
+	const float3 height_vec { up * angle_ratio };
+
+	draw_state::camera_setup& cam_setup = p->get_camera_setup();
+	cam_setup.position = position;
+	cam_setup.x_vec = width_vec / fp_framebuffer_size.x;
+	cam_setup.y_vec = height_vec / fp_framebuffer_size.y;
+	cam_setup.origin = forward - width_vec * 0.5f - height_vec * 0.5f;
+	cam_setup.forward = forward;
+	p->compute_frustum_normals(cam_setup);
+	p->update_camera_buffer();
+}
+
+static float3 orbit_position(const float3& center, const float distance, const unsigned int frame) {
+	// one full revolution around the center per run, slowly moving up and down
+	const float angle = (float(frame) / float(frame_count)) * 2.0f * PI;
+	return center + float3(sinf(angle) * distance,
+						   (0.2f + sinf(angle * 2.0f) * 0.25f) * distance,
+						   cosf(angle) * distance);
+}
+
+static function<void(const unsigned int)> orbit_camera(pipeline* p, const float3& center, const float distance) {
+	return [=](const unsigned int frame) {
+		set_camera_look_at(p, orbit_position(center, distance, frame), center);
+	};
+}
+
+static function<void(const unsigned int)> fixed_camera(pipeline* p, const float3& position, const float3& target) {
+	return [=](const unsigned int frame oclr_unused) {
+		set_camera_look_at(p, position, target);
+	};
+}
+
+// renders the warm-up frame and all timed frames (the context must not be acquired by the caller)
+static void run_frames(bench_result& result, pipeline* p, const function<void(const unsigned int)>& set_camera,
+					   const function<void()>& draw) {
+	const auto render_frame = [&](const unsigned int frame) {
+		const auto frame_start = SDL_GetPerformanceCounter();
+		oclraster::start_draw();
+		set_camera(frame);
+		draw();
+		oclraster::stop_draw(); // -> swap and finish
+		return ticks_to_ms(SDL_GetPerformanceCounter() - frame_start);
+	};
+
+	// the first frame also compiles the kernel specializations
+	result.compile_time += render_frame(0);
+
+	result.frame_times.reserve(frame_count);
+	for(unsigned int frame = 0; frame < frame_count; frame++) {
+		result.frame_times.emplace_back(render_frame(frame));
+
+		const auto& profiling_frame = ocl->get_profiling_frame();
+		if(!profiling_frame.events.empty()) {
+			result.has_stage_times = true;
+			for(size_t i = 0; i < result.stage_times.size(); i++) {
+				result.stage_times[i] += profiling_frame.stage_times[i];
+			}
+		}
+		result.peak_memory = std::max(result.peak_memory, ocl->get_allocated_memory());
+	}
+	for(auto& stage_time : result.stage_times) {
+		stage_time /= double(frame_count);
+	}
+
+	// capture the first frame again for the golden image check (not timed, the readback would skew the timings)
+	if(!regression_opts.golden_dir.empty()) {
+		p->set_frame_callback([&result](const unsigned char* data, const uint2& size) {
+			result.frame.assign(data, data + size.x * size.y * 4);
+		});
+		render_frame(0);
+		p->set_frame_callback(nullptr);
+	}
+	result.frame_count = frame_count;
+	result.valid = true;
+}
+
+bench_result run_model_scene(const string& scene_name, const uint2& resolution, const unsigned int instance_count) {
+	bench_result result;
+	result.scene = scene_name;
+	result.resolution = resolution;
+	result.instance_count = instance_count;
+
+	oclraster::set_screen_size(resolution);
+	oclraster::acquire_context();
+	pipeline* p = new pipeline();
+	oclraster::set_active_pipeline(p);
+	a2m* model = new a2m(oclraster::data_path(scene_name + ".a2m"));
+
+	// bounding box of the model (-> instance spacing and camera distance)
+	bbox bounds { float3(__FLT_MAX__), float3(-__FLT_MAX__) };
+	opencl::buffer_object* vertex_buffer = (opencl::buffer_object*)&model->get_vertex_buffer();
+	const a2m::vertex_data* vertices = (const a2m::vertex_data*)ocl->map_buffer(vertex_buffer,
+																				 opencl::MAP_BUFFER_FLAG::READ |
+																				 opencl::MAP_BUFFER_FLAG::BLOCK);
+	if(vertices != nullptr) {
+		for(unsigned int i = 0, count = model->get_vertex_count(); i < count; i++) {
+			bounds.extend(vertices[i].vertex.xyz());
+		}
+		ocl->unmap_buffer(vertex_buffer, (void*)vertices);
+	}
+	const float radius = std::max((bounds.max - bounds.min).length() * 0.5f, 0.001f);
+
+	const unsigned int per_row = (unsigned int)ceilf(sqrtf(float(instance_count)));
+	const unsigned int row_count = (instance_count + per_row - 1) / per_row;
+	const float spacing = radius * 2.2f;
+	oclraster_struct bench_uniforms {
+		float4 instance_grid;
+	} tp_uniforms {
+		float4(spacing, float(per_row), float(row_count), 0.0f)
+	};
+	opencl::buffer_object* tp_uniforms_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ |
+																   opencl::BUFFER_FLAG::INITIAL_COPY |
+																   opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
+																   sizeof(bench_uniforms),
+																   (void*)&tp_uniforms);
+
+	const auto compile_start = SDL_GetPerformanceCounter();
+	transform_program* tp = new transform_program(bench_transform_program, "transform_main");
+	rasterization_program* rp = new rasterization_program(bench_rasterization_program, "rasterize_main");
+	result.compile_time = ticks_to_ms(SDL_GetPerformanceCounter() - compile_start);
+	oclraster::release_context();
+
+	if(tp->is_valid() && rp->is_valid()) {
+		const float grid_extent = spacing * float(std::max(per_row, row_count) - 1) * 0.5f;
+		run_frames(result, p, orbit_camera(p, bounds.center(), (radius + grid_extent) * 2.5f), [&]() {
+			p->bind_program(*tp);
+			p->bind_program(*rp);
+			p->bind_buffer("input_attributes", model->get_vertex_buffer());
+			p->bind_buffer("tp_uniforms", *tp_uniforms_buffer);
+			p->bind_buffer("index_buffer", model->get_index_buffer(0));
+			p->draw_instanced(PRIMITIVE_TYPE::TRIANGLE, model->get_vertex_count(),
+							  { 0, model->get_index_count(0) }, instance_count);
+		});
+	}
+	else oclr_error("failed to create the benchmark programs!");
+
+	oclraster::acquire_context();
+	delete tp;
+	delete rp;
+	ocl->delete_buffer(tp_uniforms_buffer);
+	delete model;
+	oclraster::set_active_pipeline(nullptr);
+	delete p;
+	oclraster::release_context();
+	return result;
+}
+
+bench_result run_volume_scene(const string& scene_name, const uint2& resolution) {
+	bench_result result;
+	result.scene = scene_name;
+	result.resolution = resolution;
+
+	string vs_str, fs_str;
+	if(!file_io::file_to_string(oclraster::kernel_path("user/volume_shader_vs.cl"), vs_str) ||
+	   !file_io::file_to_string(oclraster::kernel_path("user/volume_shader_fs.cl"), fs_str)) {
+		oclr_error("couldn't open the volume programs!");
+		return result;
+	}
+
+	oclraster::set_screen_size(resolution);
+	oclraster::acquire_context();
+	pipeline* p = new pipeline();
+	oclraster::set_active_pipeline(p);
+	volume* vol = volume::from_file(oclraster::data_path("volumes/" + scene_name + ".dat"));
+	if(vol == nullptr) {
+		oclraster::set_active_pipeline(nullptr);
+		delete p;
+		oclraster::release_context();
+		return result;
+	}
+
+	// same transfer function as oclr_volume
+	uchar4 tf_data[256];
+	static constexpr float alpha_div = 4.0f;
+	for(size_t i = 0; i < 256; i++) {
+		if(i < 64) tf_data[i] = uchar4(0);
+		else {
+			const float f = (PI / 192.0f) * (float)(i - 64);
+			const float val = 255.0f * ((sinf(f - PI/2) + 1.0f) / 2.0f);
+			if(i < 96) tf_data[i] = uchar4(val, 0, 0, val / alpha_div);
+			else if(i < 128) tf_data[i] = uchar4(0, val, 0, val / alpha_div);
+			else if(i < 160) tf_data[i] = uchar4(0, 0, val, val / alpha_div);
+			else tf_data[i] = uchar4(val, val, 0, val / alpha_div);
+		}
+	}
+	image* tf_texture = new image(256, 1, image::BACKING::IMAGE, IMAGE_TYPE::UINT_8, IMAGE_CHANNEL::RGBA, tf_data);
+
+	const auto compile_start = SDL_GetPerformanceCounter();
+	transform_program* tp = new transform_program(vs_str, "transform_main");
+	rasterization_program* rp = new rasterization_program(fs_str, "rasterize_main");
+	result.compile_time = ticks_to_ms(SDL_GetPerformanceCounter() - compile_start);
+	oclraster::release_context();
+
+	if(tp->is_valid() && rp->is_valid()) {
+		// the volume is centered at the origin and spans LAYER_SIZE in each dimension
+		run_frames(result, p, orbit_camera(p, float3(0.0f), LAYER_SIZE * 2.0f), [&]() {
+			// draw the slices of the axis that is most aligned with the view direction (back to front)
+			const float3 view_vec = p->get_camera_setup().forward.normalized();
+			const size_t axis = view_vec.abs().max_element_index();
+			p->bind_program(*tp);
+			p->bind_program(*rp);
+			p->bind_buffer("index_buffer", vol->get_index_buffer(axis, view_vec[axis] < 0.0f ? 0 : 1));
+			p->bind_buffer("input_attributes", vol->get_vertex_buffer(axis));
+			p->bind_image("volume_texture", *vol->get_texture(axis));
+			p->bind_image("tf_texture", *tf_texture);
+			p->draw(PRIMITIVE_TYPE::TRIANGLE, (unsigned int)vol->get_vertex_count(axis),
+					{ 0, (unsigned int)vol->get_index_count(axis) });
+		});
+	}
+	else oclr_error("failed to create the volume programs!");
+
+	oclraster::acquire_context();
+	delete tp;
+	delete rp;
+	delete tf_texture;
+	delete vol;
+	oclraster::set_active_pipeline(nullptr);
+	delete p;
+	oclraster::release_context();
+	return result;
+}
+
+// the resources of a sample scene (everything in here is deleted after the run)
+struct sample_scene {
+	vector<transform_program*> transform_programs;
+	vector<rasterization_program*> rasterization_programs;
+	vector<opencl::buffer_object*> buffers;
+	vector<image*> images;
+	vector<framebuffer> framebuffers;
+	a2m* model { nullptr };
+	double compile_time { 0.0 }; // program creation only, in ms
+	function<void(const unsigned int)> set_camera;
+	function<void()> draw;
+};
+
+// loads and compiles a transform/rasterization program pair from the user kernel folder (same as the samples)
+static bool load_sample_programs(sample_scene& scene, const string& tp_filename, const string& rp_filename) {
+	string vs_str, fs_str;
+	if(!file_io::file_to_string(oclraster::kernel_path("user/"+tp_filename), vs_str) ||
+	   !file_io::file_to_string(oclraster::kernel_path("user/"+rp_filename), fs_str)) {
+		oclr_error("couldn't open the sample programs \"%s\" and \"%s\"!", tp_filename, rp_filename);
+		return false;
+	}
+	const auto compile_start = SDL_GetPerformanceCounter();
+	scene.transform_programs.emplace_back(new transform_program(vs_str, "transform_main"));
+	scene.rasterization_programs.emplace_back(new rasterization_program(fs_str, "rasterize_main"));
+	scene.compile_time += ticks_to_ms(SDL_GetPerformanceCounter() - compile_start);
+	return (scene.transform_programs.back()->is_valid() && scene.rasterization_programs.back()->is_valid());
+}
+
+static opencl::buffer_object* create_sample_buffer(sample_scene& scene, const size_t size, const void* data) {
+	scene.buffers.emplace_back(ocl->create_buffer(opencl::BUFFER_FLAG::READ |
+												  opencl::BUFFER_FLAG::INITIAL_COPY |
+												  opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
+												  size, (void*)data));
+	return scene.buffers.back();
+}
+
+static image* load_sample_texture(sample_scene& scene, const string& name) {
+	scene.images.emplace_back(new image(image::from_file(oclraster::data_path(name+".png"),
+														 image::BACKING::IMAGE, IMAGE_TYPE::UINT_8, IMAGE_CHANNEL::RGBA)));
+	return scene.images.back();
+}
+
+// uniforms of the lit samples (identity transforms and a fixed light, the camera position is updated per frame)
+oclraster_struct sample_tp_uniforms {
+	matrix4f modelview;
+	matrix4f rotation;
+};
+oclraster_struct sample_rp_uniforms {
+	float4 camera_position;
+	float4 light_position; // .w = light radius ^ 2
+	float4 light_color;
+};
+
+// same view distance as the sample cameras
+static constexpr float sample_camera_distance { 3.3f };
+
+static bool setup_simple_scene(sample_scene& scene, pipeline* p) {
+	// oclr_simple: monkey with the parallax mapping programs and the "light" material
+	if(!load_sample_programs(scene, "simple_parallax_vs.cl", "simple_parallax_fs.cl")) return false;
+	scene.model = new a2m(oclraster::data_path("monkey_uv.a2m"));
+
+	static const sample_tp_uniforms tp_uniforms { matrix4f(), matrix4f() };
+	opencl::buffer_object* tp_uniforms_buffer = create_sample_buffer(scene, sizeof(sample_tp_uniforms), &tp_uniforms);
+	const float light_dist = 10.0f, light_intensity = 32.0f;
+	auto rp_uniforms = make_shared<sample_rp_uniforms>(sample_rp_uniforms {
+		float4(0.0f, 0.0f, 0.0f, 1.0f),
+		float4(sinf(PI)*light_dist, 0.0f, cosf(PI)*light_dist, light_intensity*light_intensity),
+		float4(0.0f, 0.3f, 0.7f, 1.0f)
+	});
+	opencl::buffer_object* rp_uniforms_buffer = create_sample_buffer(scene, sizeof(sample_rp_uniforms), rp_uniforms.get());
+
+	image* diffuse_texture = load_sample_texture(scene, "light_512");
+	image* normal_texture = load_sample_texture(scene, "light_normal_512");
+	image* height_texture = load_sample_texture(scene, "light_height_512");
+
+	// the noise must be the same on every run -> fixed seed
+	vector<float> fp_noise_data(512*512);
+	core::set_random_seed(42);
+	for(auto& noise : fp_noise_data) {
+		noise = core::rand(0.0f, 1.0f);
+	}
+	scene.images.emplace_back(new image(512, 512, image::BACKING::BUFFER, IMAGE_TYPE::FLOAT_32, IMAGE_CHANNEL::R,
+										&fp_noise_data[0]));
+	image* fp_noise = scene.images.back();
+
+	scene.set_camera = orbit_camera(p, float3(0.0f), sample_camera_distance);
+	scene.draw = [&scene, p, tp_uniforms_buffer, rp_uniforms, rp_uniforms_buffer,
+				  diffuse_texture, normal_texture, height_texture, fp_noise]() {
+		rp_uniforms->camera_position.vector3<float>::set(p->get_camera_setup().position);
+		ocl->write_buffer(rp_uniforms_buffer, rp_uniforms.get());
+
+		p->bind_program(*scene.transform_programs[0]);
+		p->bind_program(*scene.rasterization_programs[0]);
+		p->bind_buffer("index_buffer", scene.model->get_index_buffer(0));
+		p->bind_buffer("input_attributes", scene.model->get_vertex_buffer());
+		p->bind_buffer("tp_uniforms", *tp_uniforms_buffer);
+		p->bind_buffer("rp_uniforms", *rp_uniforms_buffer);
+		p->bind_image("diffuse_texture", *diffuse_texture);
+		p->bind_image("normal_texture", *normal_texture);
+		p->bind_image("height_texture", *height_texture);
+		p->bind_image("fp_noise", *fp_noise);
+		p->draw(PRIMITIVE_TYPE::TRIANGLE, scene.model->get_vertex_count(), { 0, scene.model->get_index_count(0) });
+	};
+	return true;
+}
+
+static bool setup_rtt_scene(sample_scene& scene, pipeline* p) {
+	// oclr_rtt: monkey rendered into a texture, which is then displayed on a hexagon (triangle fan)
+	if(!load_sample_programs(scene, "diffuse_texturing_vs.cl", "diffuse_texturing_fs.cl") ||
+	   !load_sample_programs(scene, "rtt_display_vs.cl", "rtt_display_fs.cl")) {
+		return false;
+	}
+	scene.model = new a2m(oclraster::data_path("monkey_uv.a2m"));
+
+	static const sample_tp_uniforms tp_uniforms { matrix4f(), matrix4f() };
+	opencl::buffer_object* tp_uniforms_buffer = create_sample_buffer(scene, sizeof(sample_tp_uniforms), &tp_uniforms);
+	image* diffuse_texture = load_sample_texture(scene, "planks_512");
+
+	oclraster_struct plane_vertex_attribute {
+		float4 vertex;
+		float2 tex_coord;
+	};
+	static const array<plane_vertex_attribute, 7> plane_attributes {{
+		{ float4 { 0.0f, 0.0f, 0.0f, 1.0f }, float2 { 0.5f, 0.5f } },
+		{ float4 { -0.5f, -1.0f, 0.0f, 1.0f }, float2 { 0.25f, 0.0f } },
+		{ float4 { -1.0f, 0.0f, 0.0f, 1.0f }, float2 { 0.0f, 0.5f } },
+		{ float4 { -0.5f, 1.0f, 0.0f, 1.0f }, float2 { 0.25f, 1.0f } },
+		{ float4 { 0.5f, 1.0f, 0.0f, 1.0f }, float2 { 0.75f, 1.0f } },
+		{ float4 { 1.0f, 0.0f, 0.0f, 1.0f }, float2 { 1.0f, 0.5f } },
+		{ float4 { 0.5f, -1.0f, 0.0f, 1.0f }, float2 { 0.75f, 0.0f } },
+	}};
+	static const array<unsigned int, 8> plane_indices {{ 0, 1, 2, 3, 4, 5, 6, 1 }};
+	opencl::buffer_object* plane_input_attributes = create_sample_buffer(scene, sizeof(plane_attributes), &plane_attributes[0]);
+	opencl::buffer_object* plane_index_buffer = create_sample_buffer(scene, sizeof(plane_indices), &plane_indices[0]);
+
+	scene.framebuffers.emplace_back(framebuffer::create_with_images(512, 512,
+																	{{ IMAGE_TYPE::UINT_8, IMAGE_CHANNEL::RGBA }},
+																	{ IMAGE_TYPE::FLOAT_32, IMAGE_CHANNEL::R }));
+	framebuffer* rtt_fb = &scene.framebuffers.back();
+	rtt_fb->set_clear_color(ulong4 { 0, 76, 180, 255 });
+
+	scene.set_camera = orbit_camera(p, float3(0.0f), sample_camera_distance);
+	scene.draw = [&scene, p, tp_uniforms_buffer, diffuse_texture, plane_input_attributes, plane_index_buffer, rtt_fb]() {
+		// draw the monkey into the rtt framebuffer (fixed camera, same as the sample)
+		const draw_state::camera_setup orbit_setup = p->get_camera_setup();
+		rtt_fb->clear();
+		p->bind_framebuffer(rtt_fb);
+		set_camera_look_at(p, float3(0.8f, 0.28f, 3.2f), float3(0.0f));
+		p->bind_program(*scene.transform_programs[0]);
+		p->bind_program(*scene.rasterization_programs[0]);
+		p->bind_buffer("index_buffer", scene.model->get_index_buffer(0));
+		p->bind_buffer("input_attributes", scene.model->get_vertex_buffer());
+		p->bind_buffer("tp_uniforms", *tp_uniforms_buffer);
+		p->bind_image("diffuse_texture", *diffuse_texture);
+		p->draw(PRIMITIVE_TYPE::TRIANGLE, scene.model->get_vertex_count(), { 0, scene.model->get_index_count(0) });
+
+		// display it with the orbit camera
+		p->bind_framebuffer(nullptr);
+		p->get_camera_setup() = orbit_setup;
+		p->update_camera_buffer();
+		p->bind_program(*scene.transform_programs[1]);
+		p->bind_program(*scene.rasterization_programs[1]);
+		p->bind_buffer("index_buffer", *plane_index_buffer);
+		p->bind_buffer("input_attributes", *plane_input_attributes);
+		p->bind_image("texture", *rtt_fb->get_image(0));
+		p->draw(PRIMITIVE_TYPE::TRIANGLE_FAN, (unsigned int)plane_attributes.size(), { 0, 6 });
+	};
+	return true;
+}
+
+static bool setup_ui_scene(sample_scene& scene, pipeline* p) {
+	// oclr_ui: only the 3d scene, the gui is part of oclraster_support (not linked into the benchmark)
+	if(!load_sample_programs(scene, "simple_shader_vs.cl", "simple_shader_fs.cl")) return false;
+	scene.model = new a2m(oclraster::data_path("monkey_uv.a2m"));
+
+	// note: simple_shader_vs.cl declares the rotation matrix first (both are the identity here)
+	static const sample_tp_uniforms tp_uniforms { matrix4f(), matrix4f() };
+	opencl::buffer_object* tp_uniforms_buffer = create_sample_buffer(scene, sizeof(sample_tp_uniforms), &tp_uniforms);
+	const float light_dist = 10.0f;
+	auto rp_uniforms = make_shared<sample_rp_uniforms>(sample_rp_uniforms {
+		float4(0.0f, 0.0f, 0.0f, 1.0f),
+		float4(0.0f, 0.0f, light_dist, 16.0f*16.0f),
+		float4(0.0f, 0.3f, 0.7f, 1.0f)
+	});
+	opencl::buffer_object* rp_uniforms_buffer = create_sample_buffer(scene, sizeof(sample_rp_uniforms), rp_uniforms.get());
+
+	scene.set_camera = orbit_camera(p, float3(0.0f), sample_camera_distance);
+	scene.draw = [&scene, p, tp_uniforms_buffer, rp_uniforms, rp_uniforms_buffer]() {
+		rp_uniforms->camera_position.vector3<float>::set(p->get_camera_setup().position);
+		ocl->write_buffer(rp_uniforms_buffer, rp_uniforms.get());
+
+		p->bind_program(*scene.transform_programs[0]);
+		p->bind_program(*scene.rasterization_programs[0]);
+		p->bind_buffer("index_buffer", scene.model->get_index_buffer(0));
+		p->bind_buffer("input_attributes", scene.model->get_vertex_buffer());
+		p->bind_buffer("tp_uniforms", *tp_uniforms_buffer);
+		p->bind_buffer("rp_uniforms", *rp_uniforms_buffer);
+		p->draw(PRIMITIVE_TYPE::TRIANGLE, scene.model->get_vertex_count(), { 0, scene.model->get_index_count(0) });
+	};
+	return true;
+}
+
+static bool setup_gl_cmp_scene(sample_scene& scene, pipeline* p) {
+	// oclr_gl_cmp: grid of 32768 small triangles in front of a fixed camera (same geometry and view as the sample)
+	if(!load_sample_programs(scene, "gl_cmp.cl", "gl_cmp.cl")) return false;
+
+	oclraster_struct vertex_data {
+		float4 vertex;
+	};
+	static constexpr size_t triangle_count = 32768;
+	static constexpr size_t columns = 192;
+	static constexpr float scale = 1.0f / (float)columns;
+	constexpr float2 offset { -0.5f };
+	const float3 camera_position { 0.0f, -0.25f, 0.0f };
+	vector<unsigned int> indices(triangle_count * 3);
+	vector<vertex_data> vertex_attrs(triangle_count * 3);
+	for(size_t i = 0; i < triangle_count; i++) {
+		const size_t idx_offset = i * 3;
+		const float fcolumn = (float)(i % columns);
+		const float frow = (float)(i / columns);
+		for(size_t j = 0; j < 3; j++) {
+			indices[idx_offset + j] = (unsigned int)(idx_offset + j);
+			vertex_attrs[idx_offset + j].vertex = {
+				offset.x + (fcolumn + (j == 1 ? 1.0f : 0.0f)) * scale,
+				offset.y + (frow + (j == 2 ? 1.0f : 0.0f)) * scale,
+				0.75f,
+				(float)j
+			};
+		}
+
+		// flip triangles that don't face the camera
+		const float3 v0 { vertex_attrs[idx_offset + 0].vertex.xyz() };
+		const float3 v1 { vertex_attrs[idx_offset + 1].vertex.xyz() };
+		const float3 v2 { vertex_attrs[idx_offset + 2].vertex.xyz() };
+		if((v0 - camera_position).normalized().dot(((v1 - v0) ^ (v2 - v0)).normalized()) >= 0.0f) {
+			swap(vertex_attrs[idx_offset + 1], vertex_attrs[idx_offset + 2]);
+		}
+	}
+	opencl::buffer_object* index_buffer = create_sample_buffer(scene, sizeof(unsigned int) * indices.size(), &indices[0]);
+	opencl::buffer_object* vertex_buffer = create_sample_buffer(scene, sizeof(vertex_data) * vertex_attrs.size(),
+																&vertex_attrs[0]);
+
+	static const matrix4f tp_uniforms {};
+	opencl::buffer_object* tp_uniforms_buffer = create_sample_buffer(scene, sizeof(matrix4f), &tp_uniforms);
+	const float light_pos = PI / 2.0f, light_dist = 10.0f, light_intensity = 32.0f;
+	const sample_rp_uniforms rp_uniforms {
+		float4(camera_position, 1.0f),
+		float4(sinf(light_pos)*light_dist, 0.0f, cosf(light_pos)*light_dist, light_intensity*light_intensity),
+		float4(0.0f, 0.3f, 0.7f, 1.0f)
+	};
+	opencl::buffer_object* rp_uniforms_buffer = create_sample_buffer(scene, sizeof(sample_rp_uniforms), &rp_uniforms);
+	image* diffuse_texture = load_sample_texture(scene, "light_512");
+
+	const unsigned int vertex_count = (unsigned int)vertex_attrs.size();
+	scene.set_camera = fixed_camera(p, camera_position, camera_position + float3(0.0f, 0.0f, 1.0f));
+	scene.draw = [&scene, p, index_buffer, vertex_buffer, tp_uniforms_buffer, rp_uniforms_buffer,
+				  diffuse_texture, vertex_count]() {
+		p->bind_program(*scene.transform_programs[0]);
+		p->bind_program(*scene.rasterization_programs[0]);
+		p->bind_buffer("index_buffer", *index_buffer);
+		p->bind_buffer("input_attributes", *vertex_buffer);
+		p->bind_buffer("tp_uniforms", *tp_uniforms_buffer);
+		p->bind_buffer("rp_uniforms", *rp_uniforms_buffer);
+		p->bind_image("diffuse_texture", *diffuse_texture);
+		p->draw(PRIMITIVE_TYPE::TRIANGLE, vertex_count, { 0, (unsigned int)triangle_count });
+	};
+	return true;
+}
+
+bench_result run_sample_scene(const string& scene_name, const uint2& resolution) {
+	bench_result result;
+	result.scene = scene_name;
+	result.resolution = resolution;
+
+	static const map<string, function<bool(sample_scene&, pipeline*)>> sample_setups {
+		{ "oclr_simple", setup_simple_scene },
+		{ "oclr_rtt", setup_rtt_scene },
+		{ "oclr_ui", setup_ui_scene },
+		{ "oclr_gl_cmp", setup_gl_cmp_scene },
+	};
+
+	oclraster::set_screen_size(resolution);
+	oclraster::acquire_context();
+	pipeline* p = new pipeline();
+	oclraster::set_active_pipeline(p);
+
+	sample_scene scene;
+	const bool valid_setup = sample_setups.at(scene_name)(scene, p);
+	result.compile_time = scene.compile_time;
+	oclraster::release_context();
+
+	if(valid_setup) {
+		run_frames(result, p, scene.set_camera, scene.draw);
+	}
+	else oclr_error("failed to set up the \"%s\" sample scene!", scene_name);
+
+	oclraster::acquire_context();
+	for(auto& tp : scene.transform_programs) delete tp;
+	for(auto& rp : scene.rasterization_programs) delete rp;
+	for(auto& buffer : scene.buffers) ocl->delete_buffer(buffer);
+	for(auto& img : scene.images) delete img;
+	for(auto& fb : scene.framebuffers) framebuffer::destroy_images(fb);
+	if(scene.model != nullptr) delete scene.model;
+	oclraster::set_active_pipeline(nullptr);
+	delete p;
+	oclraster::release_context();
+	return result;
+}
+
+static string json_escape(const string& str) {
+	string ret;
+	for(const auto& ch : str) {
+		if(ch == '\"' || ch == '\\') ret += '\\';
+		if(ch == '\n' || ch == '\t') {
+			ret += ' ';
+			continue;
+		}
+		ret += ch;
+	}
+	return ret;
+}
+
+string results_to_json(const vector<bench_result>& results, const double init_time) {
+	const opencl_base::device_object* device = ocl->get_active_device();
+	stringstream json;
+	json.precision(4);
+	json << fixed << "{\n";
+	json << "\t\"version\": \"" << json_escape(oclraster::get_version()) << "\",\n";
+	json << "\t\"device\": { \"name\": \"" << json_escape(device->name) << "\", \"driver\": \"";
+	json << json_escape(device->driver_version) << "\" },\n";
+	json << "\t\"init_time_ms\": " << init_time << ",\n";
+	json << "\t\"frames_per_run\": " << frame_count << ",\n";
+	json << "\t\"results\": [";
+	for(size_t i = 0, count = results.size(); i < count; i++) {
+		const bench_result& result = results[i];
+		json << (i == 0 ? "\n" : ",\n") << "\t\t{\n";
+		json << "\t\t\t\"scene\": \"" << json_escape(result.scene) << "\",\n";
+		json << "\t\t\t\"width\": " << result.resolution.x << ",\n";
+		json << "\t\t\t\"height\": " << result.resolution.y << ",\n";
+		json << "\t\t\t\"instances\": " << result.instance_count << ",\n";
+		json << "\t\t\t\"valid\": " << (result.valid ? "true" : "false");
+		if(result.valid && !result.frame_times.empty()) {
+			vector<double> sorted_times { result.frame_times };
+			sort(begin(sorted_times), end(sorted_times));
+			const auto percentile = [&sorted_times](const double pct) {
+				// nearest-rank percentile
+				const size_t rank = (size_t)ceil(pct * 0.01 * double(sorted_times.size()));
+				return sorted_times[std::min(std::max(rank, size_t(1)), sorted_times.size()) - 1];
+			};
+			const double mean = accumulate(sorted_times.cbegin(), sorted_times.cend(), 0.0) / double(sorted_times.size());
+
+			json << ",\n\t\t\t\"frames\": " << result.frame_count << ",\n";
+			json << "\t\t\t\"compile_time_ms\": " << result.compile_time << ",\n";
+			json << "\t\t\t\"frame_time_ms\": { \"mean\": " << mean;
+			json << ", \"min\": " << sorted_times.front();
+			json << ", \"p50\": " << percentile(50.0);
+			json << ", \"p90\": " << percentile(90.0);
+			json << ", \"p95\": " << percentile(95.0);
+			json << ", \"p99\": " << percentile(99.0);
+			json << ", \"max\": " << sorted_times.back() << " },\n";
+			json << "\t\t\t\"stage_time_ms\": ";
+			if(!result.has_stage_times) json << "null";
+			else {
+				json << "{";
+				for(size_t stage = 0; stage < result.stage_times.size(); stage++) {
+					json << (stage == 0 ? " \"" : ", \"");
+					json << opencl_base::profiling_stage_to_string((opencl_base::PROFILING_STAGE)stage);
+					json << "\": " << result.stage_times[stage];
+				}
+				json << " }";
+			}
+			json << ",\n\t\t\t\"peak_device_memory_bytes\": " << result.peak_memory;
+		}
+		json << "\n\t\t}";
+	}
+	json << "\n\t]\n}\n";
+	return json.str();
+}
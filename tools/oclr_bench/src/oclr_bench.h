@@ -0,0 +1,59 @@
+/*
+ *  Flexible OpenCL Rasterizer (oclraster)
+ *  Copyright (C) 2012 - 2013 Florian Ziesche
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License only.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __OCLRASTER_TOOL_BENCH_H__
+#define __OCLRASTER_TOOL_BENCH_H__
+
+#include <oclraster/oclraster.h>
+#include <oclraster/core/file_io.h>
+#include <oclraster/core/a2m.h>
+#include <oclraster/core/bbox.h>
+#include <oclraster/pipeline/pipeline.h>
+#include <oclraster/pipeline/transform_stage.h>
+#include <oclraster/pipeline/image.h>
+#include <oclraster/pipeline/framebuffer.h>
+#include <oclraster/program/oclraster_program.h>
+#include <oclraster/program/transform_program.h>
+#include <oclraster/program/rasterization_program.h>
+
+#define APPLICATION_NAME "oclraster benchmark tool"
+
+// results of one scene/resolution/instance count run
+struct bench_result {
+	string scene;
+	uint2 resolution;
+	unsigned int instance_count { 1 };
+	unsigned int frame_count { 0 };
+	double compile_time { 0.0 }; // program creation + first frame (-> kernel specialization), in ms
+	vector<double> frame_times; // in ms
+	array<double, (size_t)opencl_base::PROFILING_STAGE::__MAX_PROFILING_STAGE> stage_times {{}}; // avg per frame, in ms
+	bool has_stage_times { false };
+	size_t peak_memory { 0 }; // in bytes
+	vector<unsigned char> frame; // rgba8 data of the first frame (only captured for golden image checks)
+	bool valid { false };
+};
+
+// prototypes
+void print_usage();
+bool parse_args(int argc, char* argv[]);
+bench_result run_model_scene(const string& scene_name, const uint2& resolution, const unsigned int instance_count);
+bench_result run_volume_scene(const string& scene_name, const uint2& resolution);
+bench_result run_sample_scene(const string& scene_name, const uint2& resolution);
+string results_to_json(const vector<bench_result>& results, const double init_time);
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ *  Flexible OpenCL Rasterizer (oclraster)
+ *  Copyright (C) 2012 - 2013 Florian Ziesche
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License only.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "regression.h"
+
+// stages (and frames) that take less time than this (in ms) are too noisy to be compared
+static constexpr double min_baseline_time { 0.05 };
+
+string regression::run_name(const bench_result& result) {
+	return (result.scene + "_" + uint2string(result.resolution.x) + "x" + uint2string(result.resolution.y) +
+			"_i" + uint2string(result.instance_count));
+}
+
+bool regression::write_image(const string& filename, const bench_result& result) {
+	// the captured frame is tightly packed rgba8 (-> byte order r, g, b, a)
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	static constexpr Uint32 rmask = 0xFF000000, gmask = 0x00FF0000, bmask = 0x0000FF00, amask = 0x000000FF;
+#else
+	static constexpr Uint32 rmask = 0x000000FF, gmask = 0x0000FF00, bmask = 0x00FF0000, amask = 0xFF000000;
+#endif
+	SDL_Surface* surface = SDL_CreateRGBSurfaceFrom((void*)&result.frame[0],
+													(int)result.resolution.x, (int)result.resolution.y,
+													32, (int)result.resolution.x * 4,
+													rmask, gmask, bmask, amask);
+	if(surface == nullptr) {
+		oclr_error("couldn't create a surface for \"%s\": %s", filename, SDL_GetError());
+		return false;
+	}
+	const bool success = (IMG_SavePNG(surface, filename.c_str()) == 0);
+	if(!success) oclr_error("couldn't write the reference image \"%s\": %s", filename, IMG_GetError());
+	SDL_FreeSurface(surface);
+	return success;
+}
+
+bool regression::compare_image(const string& filename, const bench_result& result, const regression_options& options) {
+	if(!file_io::is_file(filename)) {
+		oclr_error("%s: no reference image \"%s\"!", run_name(result), filename);
+		return false;
+	}
+
+	image reference { image::from_file(filename, image::BACKING::BUFFER, IMAGE_TYPE::UINT_8, IMAGE_CHANNEL::RGBA) };
+	if(!reference.is_valid() ||
+	   reference.get_size().x != result.resolution.x ||
+	   reference.get_size().y != result.resolution.y) {
+		oclr_error("%s: invalid reference image \"%s\" (size: %v, expected: %v)!",
+				   run_name(result), filename, reference.get_size(), result.resolution);
+		return false;
+	}
+	vector<unsigned char> reference_data(result.frame.size());
+	reference.read(&reference_data[0]);
+
+	size_t mismatch_count = 0;
+	unsigned int max_diff = 0;
+	for(size_t i = 0, pixel_count = result.frame.size() / 4; i < pixel_count; i++) {
+		unsigned int pixel_diff = 0;
+		for(size_t c = 0; c < 4; c++) {
+			pixel_diff = std::max(pixel_diff, (unsigned int)abs(int(result.frame[i * 4 + c]) - int(reference_data[i * 4 + c])));
+		}
+		if(pixel_diff > options.pixel_tolerance) mismatch_count++;
+		max_diff = std::max(max_diff, pixel_diff);
+	}
+
+	const double mismatch = 100.0 * double(mismatch_count) / double(result.frame.size() / 4);
+	if(mismatch > options.max_mismatch) {
+		oclr_error("%s: image mismatch: %f%% of all pixels differ (max difference: %u)",
+				   run_name(result), mismatch, max_diff);
+		return false;
+	}
+	oclr_log("%s: image ok (%f%% mismatching pixels, max difference: %u)", run_name(result), mismatch, max_diff);
+	return true;
+}
+
+bool regression::check_golden_images(const vector<bench_result>& results, const regression_options& options) {
+	bool success = true;
+	for(const auto& result : results) {
+		if(!result.valid || result.frame.empty()) {
+			oclr_error("%s: no frame was rendered!", run_name(result));
+			success = false;
+			continue;
+		}
+
+		const string filename { options.golden_dir + "/" + run_name(result) + ".png" };
+		if(options.update) {
+			if(!write_image(filename, result)) success = false;
+		}
+		else if(!compare_image(filename, result, options)) success = false;
+	}
+	return success;
+}
+
+bool regression::check_baseline(const vector<bench_result>& results, const regression_options& options) {
+	// one entry per run and stage ("frame" = mean frame time)
+	const auto run_times = [](const bench_result& result) {
+		vector<pair<string, double>> times;
+		times.emplace_back("frame", accumulate(result.frame_times.cbegin(), result.frame_times.cend(), 0.0) /
+						   double(std::max(result.frame_times.size(), size_t(1))));
+		if(result.has_stage_times) {
+			for(size_t stage = 0; stage < result.stage_times.size(); stage++) {
+				times.emplace_back(opencl_base::profiling_stage_to_string((opencl_base::PROFILING_STAGE)stage),
+								   result.stage_times[stage]);
+			}
+		}
+		return times;
+	};
+
+	if(options.update) {
+		string baseline_data { "# run;stage;time in ms\n" };
+		for(const auto& result : results) {
+			if(!result.valid) continue;
+			for(const auto& time : run_times(result)) {
+				baseline_data += run_name(result) + ";" + time.first + ";" + float2string(time.second) + "\n";
+			}
+		}
+		if(!file_io::string_to_file(options.baseline_filename, baseline_data)) {
+			oclr_error("couldn't write the baseline file \"%s\"!", options.baseline_filename);
+			return false;
+		}
+		return true;
+	}
+
+	stringstream baseline_data;
+	if(!file_io::file_to_buffer(options.baseline_filename, baseline_data)) {
+		oclr_error("couldn't read the baseline file \"%s\"!", options.baseline_filename);
+		return false;
+	}
+	unordered_map<string, double> baseline;
+	string line;
+	while(getline(baseline_data, line)) {
+		if(line.empty() || line[0] == '#') continue;
+		const auto tokens = core::tokenize(line, ';');
+		if(tokens.size() != 3) {
+			oclr_error("invalid baseline entry: \"%s\"", line);
+			continue;
+		}
+		baseline[tokens[0] + ";" + tokens[1]] = (double)string2float(tokens[2]);
+	}
+
+	bool success = true;
+	for(const auto& result : results) {
+		if(!result.valid) {
+			success = false;
+			continue;
+		}
+		for(const auto& time : run_times(result)) {
+			const auto baseline_time = baseline.find(run_name(result) + ";" + time.first);
+			if(baseline_time == baseline.cend()) {
+				oclr_debug("%s: no baseline for \"%s\"", run_name(result), time.first);
+				continue;
+			}
+			if(baseline_time->second < min_baseline_time) continue;
+
+			const double slowdown = 100.0 * (time.second / baseline_time->second - 1.0);
+			if(slowdown > options.max_slowdown) {
+				oclr_error("%s: %s is %f%% slower (%fms, baseline: %fms)",
+						   run_name(result), time.first, slowdown, time.second, baseline_time->second);
+				success = false;
+			}
+		}
+	}
+	return success;
+}
@@ -0,0 +1,58 @@
+/*
+ *  Flexible OpenCL Rasterizer (oclraster)
+ *  Copyright (C) 2012 - 2013 Florian Ziesche
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License only.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __OCLRASTER_TOOL_BENCH_REGRESSION_H__
+#define __OCLRASTER_TOOL_BENCH_REGRESSION_H__
+
+#include "oclr_bench.h"
+
+// golden image and performance regression checks of the benchmark runs:
+// * the first frame of each run is compared against a stored reference image (<golden dir>/<run name>.png),
+//   a pixel mismatches if any channel differs by more than pixel_tolerance, a run fails if more than
+//   max_mismatch percent of all pixels mismatch
+// * the mean frame time and all per-stage times of each run are compared against a stored baseline file,
+//   a run fails if any of them is more than max_slowdown percent slower
+// note: references are device/driver specific, a cpu device is used by default for this reason
+struct regression_options {
+	string golden_dir { "" };
+	string baseline_filename { "" };
+	bool update { false }; // write the references/baseline instead of comparing against them
+	unsigned int pixel_tolerance { 8 };
+	double max_mismatch { 0.1 }; // in percent
+	double max_slowdown { 10.0 }; // in percent
+};
+
+class regression {
+public:
+	// "scene_WxH_iN"
+	static string run_name(const bench_result& result);
+
+	// return false if any run regressed (or if the references/baseline couldn't be read or written)
+	static bool check_golden_images(const vector<bench_result>& results, const regression_options& options);
+	static bool check_baseline(const vector<bench_result>& results, const regression_options& options);
+
+protected:
+	regression() = delete;
+	~regression() = delete;
+
+	static bool write_image(const string& filename, const bench_result& result);
+	static bool compare_image(const string& filename, const bench_result& result, const regression_options& options);
+
+};
+
+#endif
@@ -0,0 +1,234 @@
+/*
+ *  Flexible OpenCL Rasterizer (oclraster)
+ *  Copyright (C) 2012 - 2013 Florian Ziesche
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License only.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "oclr_bundle.h"
+
+// compiles all internal kernels and all specified programs (+kernel spec combinations) and
+// writes their binaries into a kernel bundle, which can then be loaded at runtime (config: opencl bundle)
+// note: the bundle is only valid for the exact device, driver and oclraster version it was created with
+
+static string bundle_filename { "" };
+static string device_name { "all" };
+static vector<pair<string, bool>> program_files; // filename, is rasterization program
+static vector<PROJECTION> projections { PROJECTION::PERSPECTIVE };
+static vector<BINNING> binnings { BINNING::GATHER };
+static vector<DEPTH_FUNCTION> depth_funcs { DEPTH_FUNCTION::LESS };
+static bool fixed_point { false };
+
+static const unordered_map<string, DEPTH_FUNCTION> depth_func_names {
+	{ "never", DEPTH_FUNCTION::NEVER },
+	{ "less", DEPTH_FUNCTION::LESS },
+	{ "equal", DEPTH_FUNCTION::EQUAL },
+	{ "less_or_equal", DEPTH_FUNCTION::LESS_OR_EQUAL },
+	{ "greater", DEPTH_FUNCTION::GREATER },
+	{ "not_equal", DEPTH_FUNCTION::NOT_EQUAL },
+	{ "greater_or_equal", DEPTH_FUNCTION::GREATER_OR_EQUAL },
+	{ "always", DEPTH_FUNCTION::ALWAYS },
+};
+
+int main(int argc, char* argv[]) {
+	if(!parse_args(argc, argv)) {
+		print_usage();
+		return -1;
+	}
+
+	// initialize oclraster (this will already compile the internal kernels)
+	oclraster::init(argv[0], (const char*)"../data/");
+	oclraster::set_caption(APPLICATION_NAME);
+	oclraster::acquire_context();
+
+	opencl_base::device_object* device = nullptr;
+	if(device_name == "cpu") device = ocl->get_device(opencl_base::DEVICE_TYPE::FASTEST_CPU);
+	else if(device_name == "gpu") device = ocl->get_device(opencl_base::DEVICE_TYPE::FASTEST_GPU);
+	if(device_name != "all") {
+		if(device == nullptr) {
+			oclr_error("no %s device available!", device_name);
+			oclraster::release_context();
+			oclraster::destroy();
+			return -1;
+		}
+		ocl->set_active_device(device_name == "cpu" ?
+							   opencl_base::DEVICE_TYPE::FASTEST_CPU :
+							   opencl_base::DEVICE_TYPE::FASTEST_GPU);
+		oclr_log("creating kernel bundle for: %s (%s)", device->name, device->driver_version);
+	}
+
+	// start recording and reload all internal kernels (these are loaded from the binary cache at this point)
+	ocl->record_kernel_bundle();
+	ocl->reload_kernels(true);
+
+	bool success = true;
+	for(const auto& program_file : program_files) {
+		if(!compile_program(program_file.first, program_file.second)) {
+			success = false;
+		}
+	}
+
+	if(success) {
+		success = ocl->write_kernel_bundle(bundle_filename, device);
+	}
+	else oclr_error("not all programs compiled successfully - no kernel bundle was written!");
+
+	oclraster::release_context();
+	oclraster::destroy();
+	return (success ? 0 : -1);
+}
+
+void print_usage() {
+	oclr_log("usage: oclr_bundle [options] -o <bundle file> <programs>\n"
+			 "programs:\n"
+			 "\t-t <file>: transform program (file path or file name in data/kernels/user/)\n"
+			 "\t-r <file>: rasterization program (file path or file name in data/kernels/user/)\n"
+			 "options (comma separated lists, all combinations are compiled for each rasterization program):\n"
+			 "\t--device <all|cpu|gpu>: only bundle the binaries of the fastest cpu or gpu (default: all)\n"
+			 "\t--projection <perspective,orthographic>: (default: perspective)\n"
+			 "\t--binning <gather,scatter>: (default: gather)\n"
+			 "\t--depth <never,less,equal,less_or_equal,greater,not_equal,greater_or_equal,always>: (default: less)\n"
+			 "\t--fixed-point: also compile fixed-point variants of all orthographic kernels");
+}
+
+bool parse_args(int argc, char* argv[]) {
+	for(int i = 1; i < argc; i++) {
+		const string arg { argv[i] };
+		if(arg == "--fixed-point") {
+			fixed_point = true;
+			continue;
+		}
+
+		// all other args have a value
+		if(i + 1 >= argc) {
+			oclr_error("missing value for argument \"%s\"!", arg);
+			return false;
+		}
+		const string value { argv[++i] };
+		if(arg == "-o") bundle_filename = value;
+		else if(arg == "-t") program_files.emplace_back(value, false);
+		else if(arg == "-r") program_files.emplace_back(value, true);
+		else if(arg == "--device") {
+			device_name = core::str_to_lower(value);
+			if(device_name != "all" && device_name != "cpu" && device_name != "gpu") {
+				oclr_error("invalid device \"%s\"!", value);
+				return false;
+			}
+		}
+		else if(arg == "--projection") {
+			projections.clear();
+			for(const auto& token : core::tokenize(value, ',')) {
+				if(token == "perspective") projections.emplace_back(PROJECTION::PERSPECTIVE);
+				else if(token == "orthographic") projections.emplace_back(PROJECTION::ORTHOGRAPHIC);
+				else {
+					oclr_error("invalid projection \"%s\"!", token);
+					return false;
+				}
+			}
+		}
+		else if(arg == "--binning") {
+			binnings.clear();
+			for(const auto& token : core::tokenize(value, ',')) {
+				if(token == "gather") binnings.emplace_back(BINNING::GATHER);
+				else if(token == "scatter") binnings.emplace_back(BINNING::SCATTER);
+				else {
+					oclr_error("invalid binning mode \"%s\"!", token);
+					return false;
+				}
+			}
+		}
+		else if(arg == "--depth") {
+			depth_funcs.clear();
+			for(const auto& token : core::tokenize(value, ',')) {
+				const auto depth_func = depth_func_names.find(token);
+				if(depth_func == depth_func_names.end()) {
+					oclr_error("invalid depth function \"%s\"!", token);
+					return false;
+				}
+				depth_funcs.emplace_back(depth_func->second);
+			}
+		}
+		else {
+			oclr_error("unknown argument \"%s\"!", arg);
+			return false;
+		}
+	}
+
+	if(bundle_filename.empty()) {
+		oclr_error("no bundle file specified!");
+		return false;
+	}
+	if(projections.empty() || binnings.empty() || depth_funcs.empty()) {
+		oclr_error("empty kernel spec list!");
+		return false;
+	}
+	return true;
+}
+
+bool compile_program(const string& filename, const bool is_rasterization_program) {
+	string program_code;
+	const string program_filename { file_io::is_file(filename) ? filename : oclraster::kernel_path("user/"+filename) };
+	if(!file_io::file_to_string(program_filename, program_code)) {
+		oclr_error("couldn't open program \"%s\"!", filename);
+		return false;
+	}
+
+	// this compiles the default kernel spec
+	oclraster_program* program = nullptr;
+	if(is_rasterization_program) program = new rasterization_program(program_code, "main");
+	else program = new transform_program(program_code, "main");
+	if(!program->is_valid()) {
+		oclr_error("program \"%s\" is invalid!", filename);
+		delete program;
+		return false;
+	}
+
+	// the program image spec is the same as for the default spec (image hints or uchar4)
+	vector<image_type> image_spec;
+	const auto& images = program->get_images();
+	for(const auto& hint : images.image_hints) {
+		image_spec.emplace_back(hint.is_valid() ? hint : image_type { IMAGE_TYPE::UINT_8, IMAGE_CHANNEL::RGBA });
+	}
+
+	// transform programs only depend on the image spec
+	vector<oclraster_program::kernel_spec> specs;
+	if(!is_rasterization_program) {
+		specs.emplace_back(image_spec);
+	}
+	else {
+		for(const auto& projection : projections) {
+			for(const auto& binning : binnings) {
+				for(const auto& depth_func : depth_funcs) {
+					specs.emplace_back(image_spec, projection, depth_func, "", true, false, binning, false);
+					if(fixed_point && projection == PROJECTION::ORTHOGRAPHIC) {
+						specs.emplace_back(image_spec, projection, depth_func, "", true, false, binning, true);
+					}
+				}
+			}
+		}
+	}
+
+	// compile all specs in the background, then wait for them
+	bool success = true;
+	program->precompile(specs);
+	for(const auto& spec : specs) {
+		if(program->get_kernel(spec).use_count() == 0) {
+			success = false;
+		}
+	}
+	oclr_log("%s: %u kernel specs %s", filename, specs.size(), (success ? "compiled" : "failed to compile"));
+
+	delete program;
+	return success;
+}
@@ -0,0 +1,35 @@
+/*
+ *  Flexible OpenCL Rasterizer (oclraster)
+ *  Copyright (C) 2012 - 2013 Florian Ziesche
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License only.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __OCLRASTER_TOOL_BUNDLE_H__
+#define __OCLRASTER_TOOL_BUNDLE_H__
+
+#include <oclraster/oclraster.h>
+#include <oclraster/core/file_io.h>
+#include <oclraster/program/oclraster_program.h>
+#include <oclraster/program/transform_program.h>
+#include <oclraster/program/rasterization_program.h>
+
+#define APPLICATION_NAME "oclraster kernel bundle tool"
+
+// prototypes
+void print_usage();
+bool parse_args(int argc, char* argv[]);
+bool compile_program(const string& filename, const bool is_rasterization_program);
+
+#endif
@@ -0,0 +1,533 @@
+/*
+ *  Flexible OpenCL Rasterizer (oclraster)
+ *  Copyright (C) 2012 - 2013 Florian Ziesche
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License only.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "oclr_microbench.h"
+
+// draws generated triangle streams (orthographically, into an offscreen framebuffer) and reports the throughput
+// (triangles/s and fragments/s) of the transform, processing, binning and rasterization stage of each draw.
+// note: per-stage times are only available when oclraster was built with --cl-profiling,
+// otherwise only the throughput of the whole draw is reported
+
+static string output_filename { "microbench.json" };
+static string device_name { "default" };
+static vector<string> distributions { "tiny", "fullscreen", "sliver", "overdraw", "instanced" };
+static vector<unsigned int> primitive_counts { 4096, 65536 };
+static vector<uint2> resolutions { { 1280, 720 }, { 1920, 1080 } };
+static vector<BINNING> binnings { BINNING::GATHER, BINNING::SCATTER };
+static unsigned int iteration_count { 16 };
+
+// full-screen triangles are limited, so that a sweep doesn't take forever
+static constexpr unsigned int max_fullscreen_triangles { 256 };
+
+// the stages that are reported (clears etc. are ignored)
+static const vector<opencl_base::PROFILING_STAGE> reported_stages {
+	opencl_base::PROFILING_STAGE::TRANSFORM,
+	opencl_base::PROFILING_STAGE::PROCESSING,
+	opencl_base::PROFILING_STAGE::BINNING,
+	opencl_base::PROFILING_STAGE::RASTERIZATION,
+};
+
+static constexpr char microbench_transform_program[] { u8R"OCLRASTER_RAWSTR(
+	oclraster_in microbench_input {
+		float4 vertex;
+	} input_attributes;
+
+	oclraster_out microbench_output {
+		float4 color;
+	} output_attributes;
+
+	oclraster_uniforms microbench_uniforms {
+		float4 instance_grid; // .x = #columns, .yz = cell size
+	} tp_uniforms;
+
+	float4 transform_main() {
+		const unsigned int columns = (unsigned int)tp_uniforms->instance_grid.x;
+		const float2 offset = (float2)((float)(instance_index % columns),
+									   (float)(instance_index / columns)) * tp_uniforms->instance_grid.yz;
+		output_attributes->color = (float4)(input_attributes->vertex.z, 0.5f, 1.0f - input_attributes->vertex.z, 1.0f);
+		return (float4)(input_attributes->vertex.xy + offset, input_attributes->vertex.zw);
+	}
+)OCLRASTER_RAWSTR" };
+
+static constexpr char microbench_rasterization_program[] { u8R"OCLRASTER_RAWSTR(
+	oclraster_out microbench_output {
+		float4 color;
+	} output_attributes;
+
+	oclraster_framebuffer {
+		image2d color;
+		depth_image depth;
+	};
+
+	bool rasterize_main() {
+		framebuffer->color = output_attributes->color;
+		return true;
+	}
+)OCLRASTER_RAWSTR" };
+
+int main(int argc, char* argv[]) {
+	if(!parse_args(argc, argv)) {
+		print_usage();
+		return -1;
+	}
+
+	// initialize oclraster in headless mode (no window, no opengl)
+	oclraster::init(argv[0], (const char*)"../data/", true);
+	oclraster::acquire_context();
+	if(device_name == "cpu" || device_name == "gpu") {
+		const auto device_type = (device_name == "cpu" ?
+								  opencl_base::DEVICE_TYPE::FASTEST_CPU :
+								  opencl_base::DEVICE_TYPE::FASTEST_GPU);
+		if(ocl->get_device(device_type) == nullptr) {
+			oclr_error("no %s device available!", device_name);
+			oclraster::release_context();
+			oclraster::destroy();
+			return -1;
+		}
+		ocl->set_active_device(device_type);
+	}
+	const opencl_base::device_object* device = ocl->get_active_device();
+	oclr_log("benchmarking on: %s (%s)", device->name, device->driver_version);
+
+	vector<microbench_result> results;
+	for(const auto& distribution : distributions) {
+		for(const auto& primitive_count : primitive_counts) {
+			for(const auto& resolution : resolutions) {
+				const synthetic_stream stream { generate_stream(distribution, primitive_count, resolution) };
+				for(const auto& binning : binnings) {
+					results.emplace_back(run_stream(distribution, stream, resolution, binning));
+
+					const microbench_result& result = results.back();
+					if(!result.valid) {
+						oclr_error("%s (%u triangles, %v): failed!", distribution, primitive_count, resolution);
+						continue;
+					}
+
+					const double draws_per_s = 1000.0 / result.draw_time;
+					string stage_info;
+					if(result.has_stage_times) {
+						for(const auto& stage : reported_stages) {
+							stage_info += string(stage_info.empty() ? " (" : ", ");
+							stage_info += opencl_base::profiling_stage_to_string(stage);
+							stage_info += ": " + float2string(result.stage_times[(size_t)stage]) + "ms";
+						}
+						stage_info += ")";
+					}
+					oclr_log("%s, %u triangles, %v, %s: %fms/draw -> %f Mtri/s, %f Mfrag/s%s",
+							 distribution, result.primitive_count, resolution,
+							 (binning == BINNING::GATHER ? "gather" : "scatter"), result.draw_time,
+							 double(result.primitive_count) * draws_per_s / 1000000.0,
+							 result.fragment_count * draws_per_s / 1000000.0, stage_info);
+				}
+			}
+		}
+	}
+
+	// write results
+	const bool success = file_io::string_to_file(output_filename, results_to_json(results));
+	if(!success) oclr_error("couldn't write the results to \"%s\"!", output_filename);
+	else oclr_log("results written to \"%s\"", output_filename);
+
+	oclraster::release_context();
+	oclraster::destroy();
+	return (success ? 0 : -1);
+}
+
+void print_usage() {
+	oclr_log("usage: oclr_microbench [options]\n"
+			 "options (comma separated lists, all combinations are benchmarked):\n"
+			 "\t-o <file>: output json file (default: microbench.json)\n"
+			 "\t--device <default|cpu|gpu>: use the fastest cpu or gpu (default: the device chosen on init)\n"
+			 "\t--distributions <tiny,fullscreen,sliver,overdraw,instanced>: (default: all)\n"
+			 "\t--primitives <count,...>: #triangles per draw (default: 4096,65536, fullscreen: max 256)\n"
+			 "\t--resolutions <WxH,...>: (default: 1280x720,1920x1080)\n"
+			 "\t--binning <gather,scatter>: (default: gather,scatter)\n"
+			 "\t--iterations <count>: #timed draws per run (default: 16)");
+}
+
+bool parse_args(int argc, char* argv[]) {
+	static const set<string> known_distributions { "tiny", "fullscreen", "sliver", "overdraw", "instanced" };
+	for(int i = 1; i < argc; i++) {
+		const string arg { argv[i] };
+
+		// all args have a value
+		if(i + 1 >= argc) {
+			oclr_error("missing value for argument \"%s\"!", arg);
+			return false;
+		}
+		const string value { argv[++i] };
+		if(arg == "-o") output_filename = value;
+		else if(arg == "--device") {
+			device_name = core::str_to_lower(value);
+			if(device_name != "default" && device_name != "cpu" && device_name != "gpu") {
+				oclr_error("invalid device \"%s\"!", value);
+				return false;
+			}
+		}
+		else if(arg == "--distributions") {
+			distributions.clear();
+			for(const auto& token : core::tokenize(value, ',')) {
+				if(known_distributions.count(token) == 0) {
+					oclr_error("invalid distribution \"%s\"!", token);
+					return false;
+				}
+				distributions.emplace_back(token);
+			}
+		}
+		else if(arg == "--primitives") {
+			primitive_counts.clear();
+			for(const auto& token : core::tokenize(value, ',')) {
+				const unsigned int primitive_count = string2uint(token);
+				if(primitive_count == 0) {
+					oclr_error("invalid primitive count \"%s\"!", token);
+					return false;
+				}
+				primitive_counts.emplace_back(primitive_count);
+			}
+		}
+		else if(arg == "--resolutions") {
+			resolutions.clear();
+			for(const auto& token : core::tokenize(value, ',')) {
+				const auto dims = core::tokenize(token, 'x');
+				if(dims.size() != 2 || string2uint(dims[0]) == 0 || string2uint(dims[1]) == 0) {
+					oclr_error("invalid resolution \"%s\"!", token);
+					return false;
+				}
+				resolutions.emplace_back(string2uint(dims[0]), string2uint(dims[1]));
+			}
+		}
+		else if(arg == "--binning") {
+			binnings.clear();
+			for(const auto& token : core::tokenize(value, ',')) {
+				if(token == "gather") binnings.emplace_back(BINNING::GATHER);
+				else if(token == "scatter") binnings.emplace_back(BINNING::SCATTER);
+				else {
+					oclr_error("invalid binning mode \"%s\"!", token);
+					return false;
+				}
+			}
+		}
+		else if(arg == "--iterations") {
+			iteration_count = string2uint(value);
+			if(iteration_count == 0) {
+				oclr_error("invalid iteration count \"%s\"!", value);
+				return false;
+			}
+		}
+		else {
+			oclr_error("unknown argument \"%s\"!", arg);
+			return false;
+		}
+	}
+
+	if(distributions.empty() || primitive_counts.empty() || resolutions.empty() || binnings.empty()) {
+		oclr_error("empty distribution, primitive count, resolution or binning list!");
+		return false;
+	}
+	return true;
+}
+
+static double clipped_area(const array<float2, 3>& triangle, const float2& size) {
+	// clip the triangle against the framebuffer rectangle (sutherland-hodgman), then compute the polygon area
+	vector<float2> polygon { triangle.cbegin(), triangle.cend() };
+	for(unsigned int edge = 0; edge < 4; edge++) {
+		const size_t axis = edge / 2;
+		const bool is_max = ((edge % 2) == 1);
+		const float bound = (is_max ? size[axis] : 0.0f);
+		const auto inside = [&](const float2& point) {
+			return (is_max ? point[axis] <= bound : point[axis] >= bound);
+		};
+
+		vector<float2> clipped;
+		for(size_t i = 0, count = polygon.size(); i < count; i++) {
+			const float2& cur = polygon[i];
+			const float2& next = polygon[(i + 1) % count];
+			if(inside(cur)) clipped.emplace_back(cur);
+			if(inside(cur) != inside(next)) {
+				const float t = (bound - cur[axis]) / (next[axis] - cur[axis]);
+				clipped.emplace_back(cur + (next - cur) * t);
+			}
+		}
+		polygon.swap(clipped);
+		if(polygon.size() < 3) return 0.0;
+	}
+
+	double area = 0.0;
+	for(size_t i = 0, count = polygon.size(); i < count; i++) {
+		const float2& cur = polygon[i];
+		const float2& next = polygon[(i + 1) % count];
+		area += double(cur.x) * double(next.y) - double(next.x) * double(cur.y);
+	}
+	return fabs(area) * 0.5;
+}
+
+static void add_triangle(synthetic_stream& stream, const array<float2, 3>& triangle,
+						 const float depth, const uint2& resolution) {
+	// pixel -> orthographic screen space (one pixel is 1 / height in both dimensions)
+	const float inv_height = 1.0f / float(resolution.y);
+	const unsigned int first_index = (unsigned int)stream.vertices.size();
+	for(const auto& vertex : triangle) {
+		stream.vertices.emplace_back(vertex.x * inv_height, vertex.y * inv_height, depth, 1.0f);
+	}
+	// add both windings, so that exactly one of them passes backface culling (same as the autotuner)
+	stream.indices.emplace_back(first_index, first_index + 1, first_index + 2);
+	stream.indices.emplace_back(first_index, first_index + 2, first_index + 1);
+	stream.fragment_count += clipped_area(triangle, float2(resolution.x, resolution.y));
+	stream.triangle_count++;
+}
+
+synthetic_stream generate_stream(const string& distribution, const unsigned int primitive_count, const uint2& resolution) {
+	synthetic_stream stream;
+	const float2 size { float(resolution.x), float(resolution.y) };
+
+	// fixed seed -> the same streams on every run
+	mt19937 gen { 0x0C1Bu };
+	uniform_real_distribution<float> x_dist(0.0f, size.x);
+	uniform_real_distribution<float> y_dist(0.0f, size.y);
+	uniform_real_distribution<float> z_dist(0.1f, 0.9f);
+	uniform_real_distribution<float> unit_dist(0.0f, 1.0f);
+	uniform_real_distribution<float> offset_dist(-0.5f, 0.5f);
+	const auto random_triangle = [&](const float2& center, const float triangle_size) {
+		return array<float2, 3> {{
+			center + float2(offset_dist(gen), offset_dist(gen)) * triangle_size,
+			center + float2(offset_dist(gen), offset_dist(gen)) * triangle_size,
+			center + float2(offset_dist(gen), offset_dist(gen)) * triangle_size,
+		}};
+	};
+
+	if(distribution == "tiny") {
+		// uniformly distributed triangles with a size of a few pixels
+		for(unsigned int i = 0; i < primitive_count; i++) {
+			add_triangle(stream, random_triangle(float2(x_dist(gen), y_dist(gen)), 4.0f), z_dist(gen), resolution);
+		}
+	}
+	else if(distribution == "fullscreen") {
+		// overlapping triangles that each cover the whole framebuffer
+		const unsigned int triangle_count = std::min(primitive_count, max_fullscreen_triangles);
+		if(triangle_count < primitive_count) {
+			oclr_debug("fullscreen: limiting #triangles to %u", triangle_count);
+		}
+		for(unsigned int i = 0; i < triangle_count; i++) {
+			const float border = unit_dist(gen) * 16.0f;
+			add_triangle(stream, {{
+				float2(-border, -border),
+				float2(size.x * 2.0f + border * 2.0f, -border),
+				float2(-border, size.y * 2.0f + border * 2.0f),
+			}}, z_dist(gen), resolution);
+		}
+	}
+	else if(distribution == "sliver") {
+		// long (a quarter up to the full framebuffer height) and thin (about one pixel) triangles in random directions
+		for(unsigned int i = 0; i < primitive_count; i++) {
+			const float2 center { x_dist(gen), y_dist(gen) };
+			const float angle = unit_dist(gen) * float(PI);
+			const float2 dir { cosf(angle), sinf(angle) };
+			const float2 normal { -dir.y, dir.x };
+			const float half_length = (0.25f + unit_dist(gen) * 0.75f) * size.y * 0.5f;
+			const float width = 0.75f + unit_dist(gen) * 0.5f;
+			add_triangle(stream, {{
+				center - dir * half_length,
+				center + dir * half_length,
+				center + normal * width,
+			}}, z_dist(gen), resolution);
+		}
+	}
+	else if(distribution == "overdraw") {
+		// medium sized triangles that are clustered around a few points (-> heavy overdraw inside each cluster)
+		const unsigned int cluster_count = std::max(primitive_count / 1024u, 1u);
+		vector<float2> clusters;
+		for(unsigned int i = 0; i < cluster_count; i++) {
+			clusters.emplace_back(x_dist(gen), y_dist(gen));
+		}
+		for(unsigned int i = 0; i < primitive_count; i++) {
+			const float2 center { clusters[i % cluster_count] + float2(offset_dist(gen), offset_dist(gen)) * 32.0f };
+			add_triangle(stream, random_triangle(center, 48.0f), z_dist(gen), resolution);
+		}
+	}
+	else if(distribution == "instanced") {
+		// one quad (two triangles) per instance, the instances are laid out on a grid that covers the framebuffer
+		const unsigned int instance_count = std::max((primitive_count + 1) / 2, 1u);
+		const float aspect_ratio = size.x / size.y;
+		const unsigned int columns = std::max((unsigned int)ceilf(sqrtf(float(instance_count) * aspect_ratio)), 1u);
+		const unsigned int rows = (instance_count + columns - 1) / columns;
+		const float2 cell_size { size.x / float(columns), size.y / float(rows) };
+		const float2 quad_min { cell_size * 0.1f };
+		const float2 quad_max { cell_size * 0.9f };
+		const float depth = z_dist(gen);
+		add_triangle(stream, {{ quad_min, float2(quad_max.x, quad_min.y), quad_max }}, depth, resolution);
+		add_triangle(stream, {{ quad_min, quad_max, float2(quad_min.x, quad_max.y) }}, depth, resolution);
+		stream.fragment_count *= double(instance_count);
+		stream.instance_count = instance_count;
+		stream.instance_grid = float4(float(columns), cell_size.x / size.y, cell_size.y / size.y, 0.0f);
+	}
+	return stream;
+}
+
+microbench_result run_stream(const string& distribution, const synthetic_stream& stream,
+							 const uint2& resolution, const BINNING binning) {
+	microbench_result result;
+	result.distribution = distribution;
+	result.primitive_count = stream.triangle_count * stream.instance_count;
+	result.instance_count = stream.instance_count;
+	result.resolution = resolution;
+	result.binning = binning;
+	result.fragment_count = stream.fragment_count;
+	if(stream.indices.empty()) return result;
+
+	pipeline* p = new pipeline();
+	framebuffer fb = framebuffer::create_with_images(resolution.x, resolution.y,
+													 {{ IMAGE_TYPE::UINT_8, IMAGE_CHANNEL::RGBA }},
+													 { IMAGE_TYPE::FLOAT_32, IMAGE_CHANNEL::R });
+	transform_program* tp = new transform_program(microbench_transform_program, "transform_main");
+	rasterization_program* rp = new rasterization_program(microbench_rasterization_program, "rasterize_main");
+
+	oclraster_struct microbench_uniforms {
+		float4 instance_grid;
+	} tp_uniforms { stream.instance_grid };
+	opencl::buffer_object* vertex_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ |
+															  opencl::BUFFER_FLAG::INITIAL_COPY |
+															  opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
+															  sizeof(float4) * stream.vertices.size(),
+															  (void*)&stream.vertices[0]);
+	opencl::buffer_object* index_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ |
+															 opencl::BUFFER_FLAG::INITIAL_COPY |
+															 opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
+															 sizeof(index3) * stream.indices.size(),
+															 (void*)&stream.indices[0]);
+	opencl::buffer_object* tp_uniforms_buffer = ocl->create_buffer(opencl::BUFFER_FLAG::READ |
+																   opencl::BUFFER_FLAG::INITIAL_COPY |
+																   opencl::BUFFER_FLAG::BLOCK_ON_WRITE,
+																   sizeof(microbench_uniforms),
+																   (void*)&tp_uniforms);
+
+	if(tp->is_valid() && rp->is_valid()) {
+		p->set_binning(binning);
+		p->bind_framebuffer(&fb);
+		p->start_orthographic_rendering();
+		p->bind_program(*tp);
+		p->bind_program(*rp);
+		p->bind_buffer("index_buffer", *index_buffer);
+		p->bind_buffer("input_attributes", *vertex_buffer);
+		p->bind_buffer("tp_uniforms", *tp_uniforms_buffer);
+
+		const auto draw = [&]() {
+			if(stream.instance_count == 1) {
+				p->draw(PRIMITIVE_TYPE::TRIANGLE, (unsigned int)stream.vertices.size(),
+						{ 0, (unsigned int)stream.indices.size() });
+			}
+			else {
+				p->draw_instanced(PRIMITIVE_TYPE::TRIANGLE, (unsigned int)stream.vertices.size(),
+								  { 0, (unsigned int)stream.indices.size() }, stream.instance_count);
+			}
+		};
+
+		// the first draw also compiles the kernel specialization
+		fb.clear();
+		draw();
+		ocl->finish();
+		ocl->end_profiling_frame();
+
+		// each draw is timed on its own (-> one profiling frame per draw)
+		for(unsigned int i = 0; i < iteration_count; i++) {
+			fb.clear();
+			ocl->finish();
+
+			const auto start_time = SDL_GetPerformanceCounter();
+			draw();
+			ocl->finish();
+			result.draw_time += (double(SDL_GetPerformanceCounter() - start_time) * 1000.0 /
+								 double(SDL_GetPerformanceFrequency()));
+
+			ocl->end_profiling_frame();
+			const auto& profiling_frame = ocl->get_profiling_frame();
+			if(!profiling_frame.events.empty()) {
+				result.has_stage_times = true;
+				for(size_t stage = 0; stage < result.stage_times.size(); stage++) {
+					result.stage_times[stage] += profiling_frame.stage_times[stage];
+				}
+			}
+		}
+		result.draw_time /= double(iteration_count);
+		for(auto& stage_time : result.stage_times) {
+			stage_time /= double(iteration_count);
+		}
+		result.valid = true;
+		p->bind_framebuffer(nullptr);
+	}
+	else oclr_error("failed to create the microbenchmark programs!");
+
+	ocl->delete_buffer(vertex_buffer);
+	ocl->delete_buffer(index_buffer);
+	ocl->delete_buffer(tp_uniforms_buffer);
+	delete tp;
+	delete rp;
+	framebuffer::destroy_images(fb);
+	delete p;
+	return result;
+}
+
+static void write_throughput(stringstream& json, const double time, const double primitive_count,
+							 const double fragment_count) {
+	// in ms, million triangles/s and million fragments/s
+	const double per_s = (time > 0.0 ? 1000.0 / time : 0.0);
+	json << "{ \"time_ms\": " << time;
+	json << ", \"mtriangles_per_s\": " << primitive_count * per_s / 1000000.0;
+	json << ", \"mfragments_per_s\": " << fragment_count * per_s / 1000000.0 << " }";
+}
+
+string results_to_json(const vector<microbench_result>& results) {
+	const opencl_base::device_object* device = ocl->get_active_device();
+	stringstream json;
+	json.precision(4);
+	json << fixed << "{\n";
+	json << "\t\"version\": \"" << oclraster::get_version() << "\",\n";
+	json << "\t\"device\": \"" << device->name << "\",\n";
+	json << "\t\"iterations\": " << iteration_count << ",\n";
+	json << "\t\"results\": [";
+	for(size_t i = 0, count = results.size(); i < count; i++) {
+		const microbench_result& result = results[i];
+		json << (i == 0 ? "\n" : ",\n") << "\t\t{\n";
+		json << "\t\t\t\"distribution\": \"" << result.distribution << "\",\n";
+		json << "\t\t\t\"triangles\": " << result.primitive_count << ",\n";
+		json << "\t\t\t\"instances\": " << result.instance_count << ",\n";
+		json << "\t\t\t\"width\": " << result.resolution.x << ",\n";
+		json << "\t\t\t\"height\": " << result.resolution.y << ",\n";
+		json << "\t\t\t\"binning\": \"" << (result.binning == BINNING::GATHER ? "gather" : "scatter") << "\",\n";
+		json << "\t\t\t\"fragments\": " << (unsigned long long int)result.fragment_count << ",\n";
+		json << "\t\t\t\"valid\": " << (result.valid ? "true" : "false");
+		if(result.valid) {
+			json << ",\n\t\t\t\"draw\": ";
+			write_throughput(json, result.draw_time, result.primitive_count, result.fragment_count);
+			json << ",\n\t\t\t\"stages\": ";
+			if(!result.has_stage_times) json << "null";
+			else {
+				json << "{";
+				for(size_t stage = 0; stage < reported_stages.size(); stage++) {
+					json << (stage == 0 ? "\n" : ",\n") << "\t\t\t\t\"";
+					json << opencl_base::profiling_stage_to_string(reported_stages[stage]) << "\": ";
+					write_throughput(json, result.stage_times[(size_t)reported_stages[stage]],
+									 result.primitive_count, result.fragment_count);
+				}
+				json << "\n\t\t\t}";
+			}
+		}
+		json << "\n\t\t}";
+	}
+	json << "\n\t]\n}\n";
+	return json.str();
+}
@@ -0,0 +1,63 @@
+/*
+ *  Flexible OpenCL Rasterizer (oclraster)
+ *  Copyright (C) 2012 - 2013 Florian Ziesche
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License only.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __OCLRASTER_TOOL_MICROBENCH_H__
+#define __OCLRASTER_TOOL_MICROBENCH_H__
+
+#include <oclraster/oclraster.h>
+#include <oclraster/core/file_io.h>
+#include <oclraster/pipeline/pipeline.h>
+#include <oclraster/pipeline/framebuffer.h>
+#include <oclraster/program/transform_program.h>
+#include <oclraster/program/rasterization_program.h>
+
+#define APPLICATION_NAME "oclraster stage microbenchmark tool"
+
+// generated triangle stream (in orthographic screen space: x in [0, aspect ratio], y in [0, 1])
+struct synthetic_stream {
+	vector<float4> vertices;
+	vector<index3> indices;
+	unsigned int triangle_count { 0 }; // #generated triangles (per instance)
+	unsigned int instance_count { 1 };
+	float4 instance_grid { 1.0f, 0.0f, 0.0f, 0.0f }; // .x = #columns, .yz = cell size
+	double fragment_count { 0.0 }; // covered area of all triangles (and instances), in pixels
+};
+
+// results of one distribution/primitive count/resolution/binning run
+struct microbench_result {
+	string distribution;
+	unsigned int primitive_count { 0 }; // #triangles of all instances
+	unsigned int instance_count { 1 };
+	uint2 resolution;
+	BINNING binning { BINNING::GATHER };
+	double fragment_count { 0.0 };
+	double draw_time { 0.0 }; // avg per draw (wall time, incl. finish), in ms
+	array<double, (size_t)opencl_base::PROFILING_STAGE::__MAX_PROFILING_STAGE> stage_times {{}}; // avg per draw, in ms
+	bool has_stage_times { false };
+	bool valid { false };
+};
+
+// prototypes
+void print_usage();
+bool parse_args(int argc, char* argv[]);
+synthetic_stream generate_stream(const string& distribution, const unsigned int primitive_count, const uint2& resolution);
+microbench_result run_stream(const string& distribution, const synthetic_stream& stream,
+							 const uint2& resolution, const BINNING binning);
+string results_to_json(const vector<microbench_result>& results);
+
+#endif